@@ -52,6 +52,7 @@
 #define HEX_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -59,8 +60,8 @@
 #endif /* __cplusplus */
 
 // Suppress warnings about these symbols not being used.
-//lint -esym(714, hexToInt4, hexToInt8, hexToInt16, hexToInt32, int4ToHex, int8ToHex, int16ToHex, int32ToHex, hexbuf2String)
-//lint -esym(759, hexToInt4, hexToInt8, hexToInt16, hexToInt32, int4ToHex, int8ToHex, int16ToHex, int32ToHex, hexbuf2String)
+//lint -esym(714, hexToInt4, hexToInt8, hexToInt16, hexToInt32, hexToInt64, hexToInt32Checked, hexToInt64Checked, int4ToHex, int8ToHex, int16ToHex, int32ToHex, int64ToHex, hex_encode, hex_decode, hexbuf2String, hex_dumpInit, hex_dumpWrite, hex_dumpFinish, hex_dumpFileSink, hex_dumpFdSink)
+//lint -esym(759, hexToInt4, hexToInt8, hexToInt16, hexToInt32, hexToInt64, hexToInt32Checked, hexToInt64Checked, int4ToHex, int8ToHex, int16ToHex, int32ToHex, int64ToHex, hex_encode, hex_decode, hexbuf2String, hex_dumpInit, hex_dumpWrite, hex_dumpFinish, hex_dumpFileSink, hex_dumpFdSink)
 
 
 /** Converts a 4 bit nibble to an (uppercase) hexadecimal digit. */
@@ -122,6 +123,18 @@ extern void int32ToHex(char *pDest, uint_fast32_t value);
 
 
 
+/** Converts a 64 bit integer to sixteen hexadecimal digits.
+
+   Like int32ToHex(), eight digits are computed at once using arithmetic
+   on 64 bit words.
+
+   @param pDest Pointer to a buffer able to store sixteen bytes (or more).
+   @param value The value to convert to hexadecimal digits.
+*/
+extern void int64ToHex(char *pDest, uint_fast64_t value);
+
+
+
 /** Convers two hexadecimal digits to an 8 bit integer.
 
    @param pSrc Pointer to the hexadecimal digits.
@@ -149,12 +162,87 @@ extern uint_fast32_t hexToInt32(char const *pSrc);
 
 
 
+/** Convers sixteen hexadecimal digits to a 64 bit integer.
+
+   @param pSrc Pointer to the hexadecimal digits.
+   @return The integer value of the hexadecimal digits.
+*/
+extern uint_fast64_t hexToInt64(char const *pSrc);
+
+
+
+/** Converts eight hexadecimal digits to a 32 bit integer, checking
+   that every character is a hexadecimal digit.
+
+   @param pSrc Pointer to the hexadecimal digits.
+   @param pValue Receives the value. Unchanged if an error is reported.
+   @return Error status.
+   @retval true A character is not a hexadecimal digit.
+   @retval false The value has been converted.
+*/
+extern bool hexToInt32Checked(char const *pSrc, uint32_t *pValue);
+
+
+
+/** Converts sixteen hexadecimal digits to a 64 bit integer, checking
+   that every character is a hexadecimal digit.
+
+   @param pSrc Pointer to the hexadecimal digits.
+   @param pValue Receives the value. Unchanged if an error is reported.
+   @return Error status.
+   @retval true A character is not a hexadecimal digit.
+   @retval false The value has been converted.
+*/
+extern bool hexToInt64Checked(char const *pSrc, uint64_t *pValue);
+
+
+
+/** Converts a buffer of bytes to hexadecimal digits.
+
+   Each byte is converted to two digits, most significant nibble first.
+   The output is not zero-terminated. On x86, large buffers are converted
+   using SSSE3 or AVX2 if the CPU supports it; the result is the same.
+
+   @param pDest Pointer to a buffer able to store 2 * nrBytes characters.
+   @param pSrc Pointer to the bytes to convert.
+   @param nrBytes The number of bytes to convert.
+   @param lowercase If true, the digits a-f are used, otherwise A-F.
+*/
+extern void hex_encode(char *pDest, void const *pSrc, size_t nrBytes,
+                       bool lowercase);
+
+
+
+/** Converts a string of hexadecimal digits to bytes.
+
+   Every character is checked, upper and lower case digits are accepted.
+   Unlike hexToInt8() and friends, invalid input is reported instead of
+   being converted to garbage. On x86, long strings are converted using
+   SSSE3 or AVX2 if the CPU supports it.
+
+   @param pDest Pointer to a buffer able to store nrChars / 2 bytes. If an
+       error is reported, the bytes before the invalid character's pair
+       have been converted and the remaining bytes are undefined.
+   @param pSrc Pointer to the hexadecimal digits. Need not be zero-terminated.
+   @param nrChars The number of characters to convert.
+   @param pErrorPosition If not NULL, receives the index of the first
+       character that is not a hexadecimal digit. If nrChars is odd and all
+       characters are valid, nrChars is reported.
+   @return Error status.
+   @retval true A character is invalid or nrChars is odd.
+   @retval false All characters have been converted.
+*/
+extern bool hex_decode(void *pDest, char const *pSrc, size_t nrChars,
+                       size_t *pErrorPosition);
+
+
+
 /** Calculate the size of the buffer required by hexbuf2String() with
    the given options.
 
    @param nrBytes The number of bytes to dump.
    @param useCRLF If true, CR+LF will be used to terminate each line.
-       If false, CR will be used.
+       If false, LF will be used.
    @param showASCII If true, the hex values will be followed by an ASCII
        representation of each byte. If false, only the hex values will
        be shown.
@@ -177,7 +265,7 @@ extern size_t hexbuf2StringLength(size_t nrBytes,
    two-digit hexadecimal tuples separated by a single SPACE. If
    showASCII is true, lineWidth ASCII characters follow. Non-printable
    characters are replaced with a period (.). Each line is
-   is terminated with a CR or CR+LF, depending on the useCRLF parameter.
+   is terminated with a LF or CR+LF, depending on the useCRLF parameter.
 
    Each line requires
    (showOffset ? 8 : 0) + 3*lineWidth + (showASCII ? lineWidth + 1 : 0) + (useCRLF ? 2 : 1)
@@ -200,7 +288,7 @@ extern size_t hexbuf2StringLength(size_t nrBytes,
        for freeing the buffer.
    @param stringBufferSize The size of the string buffer in bytes.
    @param useCRLF If true, CR+LF will be used to terminate each line.
-       If false, CR will be used.
+       If false, LF will be used.
    @param showASCII If true, the hex values will be followed by an ASCII
        representation of each byte. If false, only the hex values will
        be shown.
@@ -223,6 +311,133 @@ extern char *hexbuf2String(char const *pValueBuffer, size_t nrBytes,
                            bool useCRLF, bool useASCII, unsigned lineWidth,
                            bool showOffset, size_t initialOffset);
 
+
+
+/** The maximum line width of a streaming hex dump. */
+#define HEX_DUMP_MAX_LINE_WIDTH 64
+
+/** The number of bytes a streaming hex dump collects before passing
+   them to its sink. */
+#ifndef HEX_DUMP_BUFFER_SIZE
+#define HEX_DUMP_BUFFER_SIZE 16384
+#endif // HEX_DUMP_BUFFER_SIZE
+
+
+/** Receives the output of a streaming hex dump.
+
+   @param pSinkContext The context given to hex_dumpInit().
+   @param pText The complete lines to output, not zero-terminated.
+   @param length The number of bytes to output.
+   @return Error status.
+   @retval true The output failed, the dump is aborted.
+   @retval false The output was successful.
+*/
+typedef bool (*hex_dump_sink_t)(void *pSinkContext, char const *pText, size_t length);
+
+
+/** The state of a streaming hex dump.
+
+   The data may be passed in chunks of any size, the output is the same
+   as that of hexbuf2String() for the concatenated chunks. The memory
+   used does not depend on the amount of data dumped.
+
+   All members are private, use hex_dumpInit() to initialize the state.
+*/
+typedef struct {
+    /** Where the output goes. */
+    hex_dump_sink_t sink;
+    /** The first argument of the sink. */
+    void *pSinkContext;
+    /** The number of bytes per line. */
+    unsigned lineWidth;
+    /** Terminate lines with CR+LF instead of LF? */
+    bool useCRLF;
+    /** Show the ASCII representation of each line? */
+    bool showASCII;
+    /** Prepend the offset to each line? */
+    bool showOffset;
+    /** Has the sink failed? */
+    bool failed;
+    /** The offset of the first byte of the current line. */
+    size_t offset;
+    /** The number of bytes in partialLine. */
+    unsigned nrPartialBytes;
+    /** The bytes of the current line until it is complete. */
+    unsigned char partialLine[HEX_DUMP_MAX_LINE_WIDTH];
+    /** The number of bytes in buffer. */
+    size_t bufferLength;
+    /** Complete lines not yet passed to the sink. */
+    char buffer[HEX_DUMP_BUFFER_SIZE];
+} hex_dump_t;
+
+
+/** Initializes a streaming hex dump.
+
+   The options are those of hexbuf2String(). Offsets beyond 32 bits are
+   shown with 16 digits.
+
+   @param pDump The state to initialize.
+   @param sink The function receiving the output, e.g. hex_dumpFileSink().
+   @param pSinkContext The first argument of the sink.
+   @param useCRLF If true, CR+LF will be used to terminate each line.
+       If false, LF will be used.
+   @param showASCII If true, the hex values will be followed by an ASCII
+       representation of each byte.
+   @param lineWidth The number of bytes to dump in each line, 1 to
+       HEX_DUMP_MAX_LINE_WIDTH.
+   @param showOffset If true, the offset will be prepended to each line.
+   @param initialOffset The offset to display for the first byte.
+   @return Error status.
+   @retval true The line width is not supported.
+   @retval false The dump is ready.
+*/
+extern bool hex_dumpInit(hex_dump_t *pDump,
+                         hex_dump_sink_t sink, void *pSinkContext,
+                         bool useCRLF, bool showASCII, unsigned lineWidth,
+                         bool showOffset, size_t initialOffset);
+
+
+/** Dumps the next chunk of data.
+
+   Complete lines are buffered and passed to the sink whenever the buffer
+   is full, the bytes of an incomplete line are kept for the next chunk.
+
+   @param pDump The state of the dump.
+   @param pData The data to dump.
+   @param nrBytes The number of bytes to dump.
+   @return Error status.
+   @retval true The sink has failed, now or before.
+   @retval false The data has been dumped.
+*/
+extern bool hex_dumpWrite(hex_dump_t *pDump, void const *pData, size_t nrBytes);
+
+
+/** Dumps the incomplete last line, if any, and passes all buffered
+   output to the sink. The dump may be continued afterwards.
+
+   @param pDump The state of the dump.
+   @return Error status.
+   @retval true The sink has failed, now or before.
+   @retval false All output has been passed to the sink.
+*/
+extern bool hex_dumpFinish(hex_dump_t *pDump);
+
+
+/** A hex dump sink writing to a stdio stream.
+
+   @param pFile The FILE * to write to.
+*/
+extern bool hex_dumpFileSink(void *pFile, char const *pText, size_t length);
+
+
+#if !FTR_EMBEDDED
+/** A hex dump sink writing to a file descriptor.
+
+   @param pFd Pointer to the int file descriptor to write to.
+*/
+extern bool hex_dumpFdSink(void *pFd, char const *pText, size_t length);
+#endif // !FTR_EMBEDDED
+
 #ifdef __cplusplus
     }
 #endif /* __cplusplus */
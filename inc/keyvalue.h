@@ -3,11 +3,20 @@
     Each key-value object contains a number of keys with an attached value.
 
     The key is always a string in the current implementation. The value is
-    a boolean, an integer, a floating-point number, a pointer, or a string.
+    a boolean, an integer, a 64 bit integer, a floating-point number, a
+    pointer, a string, or a blob of binary data with a length.
 
-    Note that this implementation could be improved in performance by choosing
-    a different way of organizing the data, such as a hash table. This is
-    currently not implemented.
+    Strings and blobs are normally copied into the collection. Strings whose
+    storage is guaranteed to outlive the collection may be inserted as
+    borrowed strings using #kv_insertBorrowedString, which avoids the copy.
+
+    The objects of a collection are kept in a linked list in the order they
+    were inserted. A hash index on the keys is maintained in addition so
+    that finding a key does not require walking the list.
+
+    Collections can be loaded from INI-style text using #kv_parseIni or
+    #kv_loadIniFile. They can be converted to JSON using #kv_toJSON or
+    #kv_writeJSON and parsed from JSON using #kv_fromJSON.
 
 
     @file keyvalue.h
@@ -61,6 +70,8 @@
 #define KEYKV_VALUE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 
 #undef MISCLIB_EXTERN
@@ -84,7 +95,9 @@
 
 // This header defines an API, do not complain if functions are not used.
 //lint -esym(714, kv_initializeIterator, kv_iterateNext, kv_createCollection, kv_clearCollection, kv_freeCollection, kv_createObject, kv_freeObject, kv_findObjectForKey, kv_addObjectToCollection, kv_remove, kv_getTypeFromObject, kv_getBoolValueFromObject, kv_getIntValueFromObject, kv_getFloatValueFromObject, kv_getPointerValueFromObject, kv_getStringValueFromObject, kv_insertBool, kv_insertInt, kv_insertFloat, kv_insertPointer, kv_insertString, kv_getBool, kv_getInt, kv_getFloat, kv_getPointer, kv_getString)
+//lint -esym(714, kv_getInt64ValueFromObject, kv_getBlobValueFromObject, kv_insertInt64, kv_insertBlob, kv_insertBorrowedString, kv_getInt64, kv_getBlob, kv_reserve, kv_parseIni, kv_loadIniFile, kv_stringToJSON, kv_valueToJSON, kv_toJSON, kv_writeJSON, kv_fromJSON, kv_enableLookupCounters, kv_getStatistics, kv_diff, kv_merge)
 //lint -esym(759, kv_initializeIterator, kv_iterateNext, kv_createCollection, kv_clearCollection, kv_freeCollection, kv_createObject, kv_freeObject, kv_findObjectForKey, kv_addObjectToCollection, kv_remove, kv_getTypeFromObject, kv_getBoolValueFromObject, kv_getIntValueFromObject, kv_getFloatValueFromObject, kv_getPointerValueFromObject, kv_getStringValueFromObject, kv_insertBool, kv_insertInt, kv_insertFloat, kv_insertPointer, kv_insertString, kv_getBool, kv_getInt, kv_getFloat, kv_getPointer, kv_getString)
+//lint -esym(759, kv_getInt64ValueFromObject, kv_getBlobValueFromObject, kv_insertInt64, kv_insertBlob, kv_insertBorrowedString, kv_getInt64, kv_getBlob, kv_reserve, kv_parseIni, kv_loadIniFile, kv_stringToJSON, kv_valueToJSON, kv_toJSON, kv_writeJSON, kv_fromJSON, kv_enableLookupCounters, kv_getStatistics, kv_diff, kv_merge)
 
 
 /** The type to use for object keys. */
@@ -105,11 +118,39 @@ typedef enum {
     KV_VALUE_STRING,
     /** The value is a pointer. */
     KV_VALUE_POINTER,
+    /** The value is a 64 bit integer. */
+    KV_VALUE_INT64,
+    /** The value is a blob of binary data with a length. */
+    KV_VALUE_BLOB,
     /** The value type is unknown and unsupported. */
     KV_VALUE_UNKNOWN
 } kv_value_type_t;
 
 
+/** The different value types are encoded in a union. */
+typedef union {
+    /** Boolean value. */
+    bool   b;
+    /** Integer value. */
+    int    i;
+    /** 64 bit integer value. */
+    int64_t i64;
+    /** Floating-point value. */
+    double f;
+    /** Pointer value. */
+    void *p;
+    /** String value. */
+    char  *s;
+    /** Blob value. */
+    struct {
+        /** The start of the binary data. */
+        void *p;
+        /** The number of bytes of binary data. */
+        size_t length;
+    } blob;
+} kv_value_t;
+
+
 /** Each Key-Value object contains the key, the type of the value, and the
   value itself.
  */
@@ -118,40 +159,158 @@ struct s_kv_object {
        data object.
      */
     struct s_kv_object *next;
+    /** The link to the next object in the same bucket of the hash index. */
+    struct s_kv_object *nextInBucket;
+    /** The hash value of the key. */
+    uint32_t hash;
     /** The key is an identifier that must be unique in the map. It is case
        sensitive.
      */
     kv_key_t key;
     /** The type of the value. Used to decode the union, below. */
     kv_value_type_t type;
-    /** The different value types are encoded in a union. */
-    union {
-        /** Boolean value. */
-        bool   b;
-        /** Integer value. */
-        int    i;
-        /** Floating-point value. */
-        double f;
-        /** Pointer value. */
-        void *p;
-        /** String value. */
-        char  *s;
-    } value;
+    /** If true, the string value is owned by the caller and is not free()ed
+       by the collection.
+     */
+    bool borrowed;
+    /** The value itself. */
+    kv_value_t value;
 };
 typedef struct s_kv_object kv_object_t;
 
 
 
+/** Counters for the lookups made in a collection. */
+typedef struct {
+    /** The number of lookups, including those made by the insert functions. */
+    unsigned long nrLookups;
+    /** The number of lookups that found the key. */
+    unsigned long nrHits;
+    /** The number of lookups that did not find the key. */
+    unsigned long nrMisses;
+    /** The number of objects compared against the key in all lookups. */
+    unsigned long nrProbes;
+} kv_lookup_counters_t;
+
+
+
 /** A number of key-value objects are grouped in a collection */
 typedef struct {
     /** The first object in the collection. */
     kv_object_t *first;
     /** The last object in the collection. This is used for performance optimization. */
     kv_object_t *last;
+    /** The number of objects in the collection. */
+    size_t nrObjects;
+    /** The hash index of the objects or NULL if there is no index (yet).
+       Without an index, the list of objects is searched linearly.
+     */
+    kv_object_t **pBuckets;
+    /** The number of buckets in the hash index. Always 0 or a power of 2. */
+    size_t nrBuckets;
+    /** The lookup counters or NULL if lookups are not counted. */
+    kv_lookup_counters_t *pCounters;
 } kv_collection_t;
 
 
 
+/** Describes the memory use and the shape of a collection. */
+typedef struct {
+    /** The number of objects in the collection. */
+    size_t nrObjects;
+    /** The number of bytes occupied by the objects themselves. */
+    size_t objectBytes;
+    /** The number of bytes occupied by the keys, including terminators. */
+    size_t keyBytes;
+    /** The number of bytes occupied by strings and blobs owned by the
+       collection. Borrowed strings are not included.
+     */
+    size_t valueBytes;
+    /** The number of bytes occupied by the hash index and the counters. */
+    size_t indexBytes;
+    /** The number of buckets in the hash index, 0 if there is no index. */
+    size_t nrBuckets;
+    /** The number of buckets containing at least one object. */
+    size_t nrUsedBuckets;
+    /** The average number of objects in a used bucket. Without an index,
+       this is the number of objects in the collection.
+     */
+    double averageChainLength;
+    /** The largest number of objects in a single bucket. Without an index,
+       this is the number of objects in the collection.
+     */
+    size_t maximumChainLength;
+    /** The lookup counters. All zero if lookups are not counted. */
+    kv_lookup_counters_t counters;
+} kv_statistics_t;
+
+
+
+/** Describes where and why parsing failed. */
+typedef struct {
+    /** The number of the line (starting at 1) where the error was detected.
+       0 if the error is not related to a line, e.g. the file could not be
+       read.
+     */
+    unsigned long line;
+    /** A human-readable description of the error. */
+    char const *message;
+} kv_parse_error_t;
+
+
+
+/** Receives output produced by the collection, e.g. by #kv_writeJSON.
+
+   @param pContext The context passed along with the sink.
+   @param pData The data to output. It is not NUL-terminated.
+   @param length The number of bytes to output.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true An error occurred, no more output will be sent.
+ */
+typedef bool (*kv_sink_t)(void *pContext, char const *pData, size_t length);
+
+
+
+/** The kinds of differences reported by #kv_diff. */
+typedef enum {
+    /** The key exists only in the new collection. */
+    KV_CHANGE_ADDED,
+    /** The key exists only in the old collection. */
+    KV_CHANGE_REMOVED,
+    /** The key exists in both collections with a different type or value. */
+    KV_CHANGE_CHANGED
+} kv_change_t;
+
+
+
+/** Receives a single difference found by #kv_diff.
+
+   @param pContext The context passed to #kv_diff.
+   @param change The kind of difference.
+   @param pOldObject The object in the old collection, NULL if added.
+   @param pNewObject The object in the new collection, NULL if removed.
+   @return Should the comparison stop?
+   @retval false Continue with the next difference.
+   @retval true Stop the comparison.
+ */
+typedef bool (*kv_diff_callback_t)(void *pContext,
+                                   kv_change_t change,
+                                   kv_object_t const *pOldObject,
+                                   kv_object_t const *pNewObject);
+
+
+
+/** Determines what #kv_merge does with keys present in both collections. */
+typedef enum {
+    /** The value in the destination collection is kept. */
+    KV_MERGE_KEEP_EXISTING,
+    /** The value in the destination collection is replaced. */
+    KV_MERGE_OVERWRITE
+} kv_merge_policy_t;
+
+
+
 /** An iterator to move through the list of objects. */
 typedef kv_object_t *kv_iterator_t;
 
@@ -204,6 +363,50 @@ MISCLIB_EXTERN void kv_freeCollection(kv_collection_t *pCollection);
 
 
 
+/** Prepares the collection to hold the given number of objects without
+   growing its hash index.
+
+   Use this before inserting many objects at once.
+
+   @param pCollection The collection to prepare.
+   @param nrObjects The number of objects expected in the collection.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The index could not be allocated. The collection is still
+       usable, only slower.
+ */
+MISCLIB_EXTERN bool kv_reserve(kv_collection_t *pCollection, size_t nrObjects);
+
+
+
+/** Enables or disables counting the lookups made in the collection.
+
+   Counting costs a few increments per lookup, so it is disabled by
+   default. Enabling resets the counters.
+
+   @param pCollection The collection.
+   @param enable True to count lookups, false to stop counting.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The counters could not be allocated.
+ */
+MISCLIB_EXTERN bool kv_enableLookupCounters(kv_collection_t *pCollection, bool enable);
+
+
+
+/** Determines the memory use and the shape of the collection.
+
+   This walks the entire collection and is intended for diagnostics, not
+   for frequent use.
+
+   @param pCollection The collection to examine.
+   @param pStatistics Returns the statistics.
+ */
+MISCLIB_EXTERN void kv_getStatistics(kv_collection_t const *pCollection,
+                                     kv_statistics_t *pStatistics);
+
+
+
 /** Creates a new copy for the given key.
 
    @param pKey A string to use as the object key. A copy will be created.
@@ -216,8 +419,9 @@ MISCLIB_EXTERN kv_object_t *kv_createObject(kv_key_t pKey);
 
 /** Frees the memory occupied by the given object.
 
-   If the value if of the type KV_VALUE_STRING, the memory occupied by the
-   string will also be free()ed.
+   If the value if of the type KV_VALUE_STRING or KV_VALUE_BLOB, the memory
+   occupied by the string or blob will also be free()ed, unless the value
+   is borrowed.
 
    @note The linked list will not be updated to remove the object that is
    free()ed. The caller must handle this prior to calling this function!
@@ -321,6 +525,28 @@ MISCLIB_EXTERN char const *kv_getStringValueFromObject(kv_object_t const *pObjec
 
 
 
+/** Returns the 64 bit integer value stored in the object.
+
+   @param pObject The object to get the value from.
+   @return The value stored in the object.
+   @pre The object must contain the right type of value.
+ */
+MISCLIB_EXTERN int64_t kv_getInt64ValueFromObject(kv_object_t const *pObject);
+
+
+
+/** Returns the blob value stored in the object.
+
+   @param pObject The object to get the value from.
+   @param pLength Returns the number of bytes in the blob. May be NULL if
+       the length is not required.
+   @return The start of the binary data stored in the object.
+   @pre The object must contain the right type of value.
+ */
+MISCLIB_EXTERN void const *kv_getBlobValueFromObject(kv_object_t const *pObject, size_t *pLength);
+
+
+
 /** Stores a boolean value in the object with the given key in the collection.
 
    If an object with the specified value exists, the value will be overwritten.
@@ -391,6 +617,60 @@ MISCLIB_EXTERN kv_object_t *kv_insertString(kv_collection_t *pCollection, kv_key
 
 
 
+/** Stores a borrowed string value in the object with the given key in the
+   collection.
+
+   If an object with the specified value exists, the value will be overwritten.
+
+   @note Unlike #kv_insertString, no copy of the string is made. The caller
+   must guarantee that the string remains valid and unchanged for as long as
+   it is stored in the collection. The string is never free()ed by the
+   collection.
+
+   @param pCollection The collection that will contain the object.
+   @param pKey The key identifying the object containing the value.
+   @param value The value to store with the key.
+   @return A pointer to the object containing the value.
+*/
+MISCLIB_EXTERN kv_object_t *kv_insertBorrowedString(kv_collection_t *pCollection, kv_key_t const pKey, char const *value);
+
+
+
+/** Stores a 64 bit integer value in the object with the given key in the
+   collection.
+
+   If an object with the specified value exists, the value will be overwritten.
+
+   @param pCollection The collection that will contain the object.
+   @param pKey The key identifying the object containing the value.
+   @param value The value to store with the key.
+   @return A pointer to the object containing the value.
+*/
+MISCLIB_EXTERN kv_object_t *kv_insertInt64(kv_collection_t *pCollection, kv_key_t pKey, int64_t value);
+
+
+
+/** Stores a blob of binary data in the object with the given key in the
+   collection.
+
+   If an object with the specified value exists, the value will be overwritten.
+
+   @note A copy of the data is stored using malloc(). The copy is
+   automatically free()ed when it is either replaced or the object in the
+   collection is deleted (using #kv_freeObject).
+
+   @param pCollection The collection that will contain the object.
+   @param pKey The key identifying the object containing the value.
+   @param pData The binary data to store with the key. May be NULL if
+       length is 0.
+   @param length The number of bytes of binary data.
+   @return A pointer to the object containing the value.
+   @retval NULL Out of memory.
+*/
+MISCLIB_EXTERN kv_object_t *kv_insertBlob(kv_collection_t *pCollection, kv_key_t pKey, void const *pData, size_t length);
+
+
+
 /** Returns the boolean value stored with the given key in the collection.
 
    If the key does not exist, False is returned. If you want to know if the key exists, use
@@ -456,4 +736,251 @@ MISCLIB_EXTERN void *kv_getPointer(kv_collection_t const *pCollection, kv_key_t
 MISCLIB_EXTERN char const *kv_getString(kv_collection_t const *pCollection, kv_key_t const pKey);
 
 
+
+/** Returns the 64 bit integer value stored with the given key in the
+   collection.
+
+   If the key does not exist, 0 is returned. If you want to know if the key exists, use
+   kv_findObjectForKey.
+
+   @param pCollection The collection to search the for the key.
+   @param pKey The key identifying the object containing the value.
+   @return The value stored with the key.
+*/
+MISCLIB_EXTERN int64_t kv_getInt64(kv_collection_t const *pCollection, kv_key_t const pKey);
+
+
+
+/** Returns the blob value stored with the given key in the collection.
+
+   If the key does not exist, NULL is returned and the length is set to 0.
+   If you want to know if the key exists, use kv_findObjectForKey.
+
+   @param pCollection The collection to search the for the key.
+   @param pKey The key identifying the object containing the value.
+   @param pLength Returns the number of bytes in the blob. May be NULL if
+       the length is not required.
+   @return The start of the binary data stored with the key.
+*/
+MISCLIB_EXTERN void const *kv_getBlob(kv_collection_t const *pCollection, kv_key_t const pKey, size_t *pLength);
+
+
+
+/** Compares two collections and reports every key that was added, removed
+   or changed.
+
+   Removed and changed keys are reported in the order of the old
+   collection, followed by the added keys in the order of the new
+   collection. Each key is looked up in the hash index of the other
+   collection, so the run time is linear in the size of both collections.
+
+   Two values are equal if they have the same type and the same contents.
+   Strings and blobs are compared by contents, pointers by address.
+
+   @param pOldCollection The collection before the change.
+   @param pNewCollection The collection after the change.
+   @param callback The function receiving the differences.
+   @param pContext Passed to the callback.
+   @return Was the comparison stopped?
+   @retval false All differences were reported.
+   @retval true The callback stopped the comparison.
+ */
+MISCLIB_EXTERN bool kv_diff(kv_collection_t const *pOldCollection,
+                            kv_collection_t const *pNewCollection,
+                            kv_diff_callback_t callback,
+                            void *pContext);
+
+
+
+/** Copies all objects from one collection into another.
+
+   Keys missing from the destination are appended in the order of the
+   source. Values are copied, so the source may be freed afterwards;
+   borrowed strings become owned by the destination. If the policy replaces
+   a value of a different type, the type of the destination object changes
+   as well.
+
+   @param pDestination The collection receiving the objects.
+   @param pSource The collection to copy from.
+   @param policy Determines what happens to keys present in both.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true Out of memory. The destination may be partially merged.
+ */
+MISCLIB_EXTERN bool kv_merge(kv_collection_t *pDestination,
+                             kv_collection_t const *pSource,
+                             kv_merge_policy_t policy);
+
+
+
+
+/** Parses INI-style text and inserts the values into the collection.
+
+   Each line contains either a key-value pair <code>key = value</code>,
+   a section header <code>[section]</code>, a comment starting with ';' or
+   '#', or nothing but whitespace. Lines are terminated by LF or CR+LF.
+
+   Keys following a section header are stored as
+   <code>section.key</code>. Whitespace around keys and values is ignored.
+
+   The type of the value is inferred from its text: <code>true</code>,
+   <code>false</code>, <code>yes</code>, <code>no</code>, <code>on</code>,
+   and <code>off</code> (in any case) are booleans, decimal or 0x-prefixed
+   hexadecimal numbers are integers (#KV_VALUE_INT64 if they do not fit an
+   int), other numbers are floating-point with '.' as the decimal point
+   whatever the locale, and anything else is a string. Values enclosed in double quotes are always strings, without the quotes.
+
+   If a key occurs more than once, the last value wins.
+
+   @param pCollection The collection to insert the values into.
+   @param pText The text to parse. It need not be NUL-terminated.
+   @param length The number of characters in the text.
+   @param pError Returns the location and reason of an error. May be NULL.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The text could not be parsed. Values from the lines before
+       the error have been inserted.
+ */
+MISCLIB_EXTERN bool kv_parseIni(kv_collection_t *pCollection,
+                                char const *pText, size_t length,
+                                kv_parse_error_t *pError);
+
+
+
+/** Loads an INI-style file into the collection.
+
+   The file is mapped into memory (where supported) and parsed with
+   #kv_parseIni.
+
+   @param pCollection The collection to insert the values into.
+   @param filename The name (with path) of the file to load.
+   @param pError Returns the location and reason of an error. May be NULL.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The file could not be read (check errno for details) or
+       could not be parsed.
+ */
+MISCLIB_EXTERN bool kv_loadIniFile(kv_collection_t *pCollection,
+                                   char const *filename,
+                                   kv_parse_error_t *pError);
+
+
+
+/** Converts a string to a quoted JSON string.
+
+   Quotes, backslashes and control characters are escaped. All other bytes
+   are copied unchanged, so UTF-8 input results in UTF-8 output.
+
+   Like snprintf(), the function returns the length the output would have
+   and writes as much as fits into the buffer, always NUL-terminating it.
+
+   @param pBuffer The buffer receiving the JSON text. May be NULL if
+       bufferSize is 0.
+   @param bufferSize The size of the buffer in bytes.
+   @param pString The NUL-terminated string to convert. NULL results in
+       <code>null</code>.
+   @return The length of the complete JSON text, not counting the NUL
+       terminator.
+ */
+MISCLIB_EXTERN size_t kv_stringToJSON(char *pBuffer, size_t bufferSize, char const *pString);
+
+
+
+/** Converts a single value to JSON text.
+
+   Booleans, integers and floating-point numbers are converted to JSON
+   literals and numbers. Non-finite floating-point numbers and NULL
+   pointers become <code>null</code>. Strings are quoted and escaped, blobs
+   become strings of hexadecimal digits, and other pointers become strings
+   of the form <code>"0x1234abcd"</code>.
+
+   Like snprintf(), the function returns the length the output would have
+   and writes as much as fits into the buffer, always NUL-terminating it.
+
+   @param pBuffer The buffer receiving the JSON text. May be NULL if
+       bufferSize is 0.
+   @param bufferSize The size of the buffer in bytes.
+   @param type The type of the value.
+   @param pValue The value to convert.
+   @return The length of the complete JSON text, not counting the NUL
+       terminator.
+ */
+MISCLIB_EXTERN size_t kv_valueToJSON(char *pBuffer, size_t bufferSize,
+                                     kv_value_type_t type, kv_value_t const *pValue);
+
+
+
+/** Converts the collection to a flat JSON object.
+
+   The keys appear in the order of the collection. See #kv_valueToJSON for
+   the representation of the values.
+
+   Like snprintf(), the function returns the length the output would have
+   and writes as much as fits into the buffer, always NUL-terminating it.
+   Call it with a bufferSize of 0 to determine the size required.
+
+   @param pCollection The collection to convert.
+   @param pBuffer The buffer receiving the JSON text. May be NULL if
+       bufferSize is 0.
+   @param bufferSize The size of the buffer in bytes.
+   @return The length of the complete JSON text, not counting the NUL
+       terminator.
+ */
+MISCLIB_EXTERN size_t kv_toJSON(kv_collection_t const *pCollection,
+                                char *pBuffer, size_t bufferSize);
+
+
+
+/** Converts the collection to a flat JSON object and passes the text to
+   the sink in large pieces.
+
+   The output is identical to #kv_toJSON, but no buffer for the whole text
+   is required.
+
+   @param pCollection The collection to convert.
+   @param sink The function receiving the JSON text.
+   @param pContext Passed to the sink unchanged.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The sink reported an error.
+ */
+MISCLIB_EXTERN bool kv_writeJSON(kv_collection_t const *pCollection,
+                                 kv_sink_t sink, void *pContext);
+
+
+
+/** Parses a flat JSON object and inserts its members into the collection.
+
+   The text is parsed in a single pass and modified in place: strings are
+   unescaped and NUL-terminated inside the text. Members with a string value
+   can thus be stored as borrowed strings without any copy, provided the
+   text outlives the collection.
+
+   Numbers without fraction or exponent become #KV_VALUE_INTEGER or
+   #KV_VALUE_INT64, depending on their size. Other numbers become
+   #KV_VALUE_FLOAT, <code>true</code> and <code>false</code> become
+   #KV_VALUE_BOOL and <code>null</code> becomes a NULL #KV_VALUE_POINTER.
+   Nested objects and arrays are not supported.
+
+   If a key occurs more than once, the last value wins.
+
+   @param pCollection The collection to insert the members into.
+   @param pText The JSON text. It need not be NUL-terminated and is
+       modified by the parser.
+   @param length The number of characters in the text.
+   @param borrowStrings If true, string values are inserted with
+       #kv_insertBorrowedString and point into the text. Otherwise they
+       are copied.
+   @param pError Returns the location and reason of an error. May be NULL.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true The text could not be parsed. Members before the error
+       have been inserted.
+ */
+MISCLIB_EXTERN bool kv_fromJSON(kv_collection_t *pCollection,
+                                char *pText, size_t length,
+                                bool borrowStrings,
+                                kv_parse_error_t *pError);
+
+
 #endif // KEYKV_VALUE_H
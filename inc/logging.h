@@ -63,7 +63,9 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include "keyvalue.h"
 
 // In order to compile code using the logging API but with logging disabled
 // (at compile-time), use -DLOGGING_API_DISABLED=1. This is the implicit
@@ -100,12 +102,40 @@
 #endif // unkown compiler
 #endif // !LOGGING_API_USES_VARIADIC_MACROS
 
+// Features that need a thread of their own (e.g. the asynchronous writer)
+// are built on POSIX threads and C11 atomics. They are enabled by default
+// on all platforms that provide both. Use -DLOGGING_THREADS=0 to build
+// without them; the corresponding functions then report an error.
+#ifndef LOGGING_THREADS
+#if defined(_WIN32) || FTR_EMBEDDED
+#define LOGGING_THREADS 0
+#else
+#define LOGGING_THREADS 1
+#endif
+#endif // !LOGGING_THREADS
+
+// State shared between threads is declared using this macro.
+#if LOGGING_THREADS
+#include <stdatomic.h>
+#define LOGGING_ATOMIC(type) _Atomic(type)
+#else
+#define LOGGING_ATOMIC(type) type
+#endif // !LOGGING_THREADS
+
 
 // Suppress warnings about these symbols not being used.
-//lint -esym(714, log_openLogfile, log_closeLogfile, log_setFileLevel, log_setStderrLevel, log_setStdoutLevel, log_setStdoutSupression)
+//lint -esym(714, log_openLogfile, log_openMappedLogfile, log_closeLogfile, log_setRotation, log_setFileLevel, log_setStderrLevel, log_setStdoutLevel, log_setStdoutSupression, log_setTimestamps)
 //lint -esym(714, log_logMessageContinue, log_logMessageStart, log_logVMessageContinue, log_logVMessageStart)
-//lint -esym(759, log_openLogfile, log_closeLogfile, log_setFileLevel, log_setStderrLevel, log_setStdoutLevel, log_setStdoutSupression)
+//lint -esym(714, log_startAsync, log_stopAsync, log_flush, log_getDroppedCount, log_setFlushPolicy, log_installCrashHandler, log_startFlightRecorder, log_stopFlightRecorder, log_dumpFlightRecorder)
+//lint -esym(714, log_getLevelPrefix, log_logVMessage, log_openBinaryLogfile, log_closeBinaryLogfile, log_logBinary_impl, log_decodeBinary)
+//lint -esym(714, log_checkCategory, log_logCategory_impl, log_setUncategorizedLevel, log_setCategoryLevel, log_setDefaultCategoryLevel, log_loadCategoryConfig, log_installCategoryReloadHandler, log_checkCategoryReload)
+//lint -esym(714, log_checkRateLimit, log_setDuplicateSuppression, log_isLevelEnabled, log_openJsonLogfile, log_closeJsonLogfile, log_logFields, log_logDataLimited, log_checkSample, log_logSampled_impl, log_setSamplingSummary)
+//lint -esym(759, log_openLogfile, log_openMappedLogfile, log_closeLogfile, log_setRotation, log_setFileLevel, log_setStderrLevel, log_setStdoutLevel, log_setStdoutSupression, log_setTimestamps)
 //lint -esym(759, log_logMessageContinue, log_logMessageStart, log_logVMessageContinue, log_logVMessageStart)
+//lint -esym(759, log_startAsync, log_stopAsync, log_flush, log_getDroppedCount, log_setFlushPolicy, log_installCrashHandler, log_startFlightRecorder, log_stopFlightRecorder, log_dumpFlightRecorder)
+//lint -esym(759, log_getLevelPrefix, log_logVMessage, log_openBinaryLogfile, log_closeBinaryLogfile, log_logBinary_impl, log_decodeBinary)
+//lint -esym(759, log_checkCategory, log_logCategory_impl, log_setUncategorizedLevel, log_setCategoryLevel, log_setDefaultCategoryLevel, log_loadCategoryConfig, log_installCategoryReloadHandler, log_checkCategoryReload)
+//lint -esym(759, log_checkRateLimit, log_setDuplicateSuppression, log_isLevelEnabled, log_openJsonLogfile, log_closeJsonLogfile, log_logFields, log_logDataLimited, log_checkSample, log_logSampled_impl, log_setSamplingSummary)
 
 
 /** Message classification levels for logging. */
@@ -156,6 +186,50 @@ typedef enum {
 } log_level_t;
 
 
+// In order to remove messages below a certain level (at compile-time),
+// including the evaluation of their arguments, define LOGGING_MIN_LEVEL as
+// that level, e.g. -DLOGGING_MIN_LEVEL=LOGLEVEL_INFO. By default, no
+// message is removed.
+// Without variadic macros, the level is only known inside the call, so
+// the calls remain and their arguments are evaluated, but the messages
+// are still discarded before they are formatted.
+#ifdef LOGGING_MIN_LEVEL
+#define LOGGING_IS_COMPILED_IN(level) ((level) >= LOGGING_MIN_LEVEL)
+#else
+#define LOGGING_IS_COMPILED_IN(level) (true)
+#endif // !LOGGING_MIN_LEVEL
+
+
+/** What happens to a message if the queue of the asynchronous writer is
+ * full.
+ */
+typedef enum {
+    /** The calling thread waits until the writer has made room. */
+    LOG_QUEUE_BLOCK,
+    /** The message is dropped and counted, see #log_getDroppedCount. */
+    LOG_QUEUE_DROP,
+    /** The message is dropped and counted. The writer reports the number
+     * of dropped messages in the log as soon as there is room again.
+     */
+    LOG_QUEUE_DROP_REPORT
+} log_queue_policy_t;
+
+
+/** When the log file is flushed. */
+typedef enum {
+    /** After every complete message, i.e. when the EOL marker is written.
+     * This is the default.
+     */
+    LOG_FLUSH_EVERY_MESSAGE,
+    /** After the given number of bytes has been written. */
+    LOG_FLUSH_BYTES,
+    /** Every given number of milliseconds, by a timer thread. */
+    LOG_FLUSH_INTERVAL,
+    /** After every message of level LOGLEVEL_ERROR or higher. */
+    LOG_FLUSH_ERROR
+} log_flush_policy_t;
+
+
 
 
 /** Opens the specified log file for writing.
@@ -174,6 +248,35 @@ extern bool log_openLogfile(char const *filename, bool append);
 
 
 
+/** Opens a log file that is written through a shared memory mapping.
+ *
+ * Messages are copied into the mapping at an atomically advanced offset,
+ * so logging makes no system call except when the file is extended, which
+ * happens in large chunks. The operating system writes the pages back to
+ * the file. If the program crashes, all messages copied so far are kept,
+ * followed by NUL bytes up to the end of the last chunk.
+ * #log_closeLogfile truncates the file to the messages written.
+ *
+ * The memory-mapped file replaces the file opened by #log_openLogfile and
+ * vice versa. It uses the level set by #log_setFileLevel, flush policies
+ * do not apply.
+ *
+ * @param filename The name (with path) of the file to open.
+ * @param append true if the logfile shall be appended to, false if the
+ *        previous content will be deleted before opening the file.
+ * @param maximumSize The largest number of bytes that will be added to
+ *        the file, or 0 for a default of 1 GiB (64 MiB on 32 bit systems).
+ *        The address space is reserved up front, messages beyond this size
+ *        are discarded.
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true The file could not be opened or mapped, or the platform
+ *        does not support memory-mapped files. Check errno for details.
+ */
+extern bool log_openMappedLogfile(char const *filename, bool append, size_t maximumSize);
+
+
+
 /** Closes the log file currently in use.
  *
  * @note A logfile must be open when this function is called.
@@ -188,6 +291,31 @@ extern bool log_closeLogfile(void);
 
 
 
+/** Rotates the log file by size or time.
+ *
+ * When the log file reaches the given size or the interval has passed,
+ * it is renamed to "filename.1" (the previous "filename.1" to
+ * "filename.2" and so on) and logging continues in a new file of the
+ * original name. Only the given number of rotated files is kept.
+ *
+ * The rotation is done by a thread of its own, so no logging thread waits
+ * for the file system. Until the new file is in place, messages go to the
+ * renamed file. The log file must be opened by #log_openLogfile or
+ * #log_openMappedLogfile.
+ *
+ * @param maximumBytes Rotate when the file reaches this size, or 0.
+ * @param interval Rotate after this many seconds, or 0.
+ * @param nrKeptFiles The number of rotated files to keep.
+ * @return Did an error occur?
+ * @retval false No error occurred. Passing 0 for both triggers turns
+ *         rotation off.
+ * @retval true The rotation thread could not be started, or logging was
+ *         built without threads (LOGGING_THREADS=0).
+ */
+extern bool log_setRotation(unsigned long maximumBytes, unsigned long interval, unsigned nrKeptFiles);
+
+
+
 /** Flushes the buffer of the log file.
 
     @pre A log file must have been opened using #log_openLogfile.
@@ -196,6 +324,91 @@ extern void log_flushLogfile(void);
 
 
 
+/** Determines when the log file is flushed.
+ *
+ * Flushing costs a system call. Flushing less often than once per message
+ * makes logging much cheaper, at the risk of losing the last messages if
+ * the program crashes. #LOG_FLUSH_ERROR keeps errors durable while
+ * debug messages are buffered. See also #log_installCrashHandler.
+ *
+ * The log file is always flushed when it is closed and by #log_flush.
+ *
+ * @param policy When the log file is flushed.
+ * @param parameter The number of bytes for #LOG_FLUSH_BYTES or the
+ *        number of milliseconds for #LOG_FLUSH_INTERVAL. Ignored for the
+ *        other policies.
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true The parameter is 0 or the timer thread could not be
+ *     started. #LOG_FLUSH_INTERVAL needs LOGGING_THREADS. The policy is
+ *     not changed.
+ */
+extern bool log_setFlushPolicy(log_flush_policy_t policy, unsigned long parameter);
+
+
+
+/** Installs handlers for fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL
+ * and SIGABRT) that flush the log file before the program terminates.
+ *
+ * The handler flushes the log file and then re-raises the signal with the
+ * default action, so core dumps and exit codes are unaffected. Flushing is
+ * done on a best-effort basis: stdio is not async-signal-safe and
+ * messages still in the queue of the asynchronous writer are lost.
+ * The flight recorder, if started, is dumped first.
+ *
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true A handler could not be installed.
+ */
+extern bool log_installCrashHandler(void);
+
+
+
+/** Starts the flight recorder.
+ *
+ * The flight recorder keeps the most recent records of the given or a
+ * higher level in a ring in memory, independent of the levels of the
+ * other channels. It costs formatting and a copy, but no I/O. The ring is
+ * written to the dump file when a #LOGLEVEL_FATAL message is logged, when
+ * the program receives a fatal signal (see #log_installCrashHandler, which
+ * is called by this function) or when #log_dumpFlightRecorder is called.
+ *
+ * Records of concurrent threads may overwrite each other once the ring
+ * wraps around, so the oldest record in a dump may be incomplete.
+ *
+ * @param filename The name (with path) of the dump file. It is created
+ *     or truncated by each dump.
+ * @param size The size of the ring in bytes, rounded up to a power of 2.
+ * @param level All records of this or a higher level are recorded.
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true The flight recorder is already running, out of memory, the
+ *     crash handler could not be installed, or the platform does not
+ *     support it (FTR_EMBEDDED).
+ */
+extern bool log_startFlightRecorder(char const *filename, size_t size, log_level_t level);
+
+
+
+/** Stops the flight recorder and discards the ring. */
+extern void log_stopFlightRecorder(void);
+
+
+
+/** Writes the ring of the flight recorder to its dump file.
+ *
+ * Only async-signal-safe functions are used, so this may be called from a
+ * signal handler.
+ *
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true The flight recorder is not running, another dump is in
+ *     progress, or the dump file could not be written.
+ */
+extern bool log_dumpFlightRecorder(void);
+
+
+
 /** Sets the minimum message level logged to the log file (if open),
  * lower messages are ignored.
  *
@@ -242,6 +455,73 @@ extern void log_setStdoutSupression(bool suppress);
 
 
 
+/** Enables timestamps at the start of each line.
+ *
+ * The timestamp is the local time with microseconds, e.g.
+ * "2017-03-14 15:09:26.535897 INFO: message". The date and time are
+ * formatted once per second and thread, so a timestamp is cheap.
+ *
+ * The default is to log without timestamps.
+ *
+ * @param enable If true, lines start with a timestamp.
+ */
+extern void log_setTimestamps(bool enable);
+
+
+
+/** Switches to asynchronous logging.
+ *
+ * Messages are formatted by the calling thread and placed in a lock-free
+ * queue. A dedicated writer thread takes them from the queue and writes
+ * them to the channels in batches, so the calling thread never waits for
+ * I/O (unless the queue is full and the policy is #LOG_QUEUE_BLOCK).
+ *
+ * A message longer than the whole queue is cut and ends in "[truncated]".
+ *
+ * Call #log_stopAsync before the program terminates, otherwise queued
+ * messages are lost.
+ *
+ * @param queueSize The size of the queue in bytes. It is rounded up to a
+ *        power of two and to at least 8 KiB.
+ * @param policy Determines what happens if the queue is full.
+ * @return Did an error occur?
+ * @retval false No error occurred.
+ * @retval true The writer is already running, resources could not be
+ *     allocated, or the library was built with LOGGING_THREADS=0.
+ */
+extern bool log_startAsync(size_t queueSize, log_queue_policy_t policy);
+
+
+
+/** Writes all queued messages, stops the writer thread and returns to
+ * synchronous logging.
+ *
+ * Nothing happens if asynchronous logging is not active.
+ *
+ * @note No other thread may log while this function executes.
+ */
+extern void log_stopAsync(void);
+
+
+
+/** Waits until all messages logged so far have been written and flushes
+ * the log file (if open).
+ *
+ * Use this at shutdown or before the program may crash.
+ */
+extern void log_flush(void);
+
+
+
+/** Returns the number of messages dropped because the queue of the
+ * asynchronous writer was full.
+ *
+ * @return The number of dropped messages since the program started.
+ */
+extern unsigned long log_getDroppedCount(void);
+
+
+
 /** Logs the given message to whatever channels accept the specified log
  * level.
  *
@@ -261,19 +541,27 @@ extern void log_setStdoutSupression(bool suppress);
  * @param format A format string as used by @see printf
  * @param ... A list of parameters as used by @see printf
  */
+extern void log_logMessage_impl(log_level_t level, char const *format, ...);
 #if 0 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessage(log)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessage(log) log_logMessage_min log
     #else
         #define log_logMessage(log) log_logMessage_impl log
-        extern void log_logMessage_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #elif 1 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessage(level, format, ...)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessage(level, ...) \
+            do { \
+                if (LOGGING_IS_COMPILED_IN(level)) { \
+                    log_logMessage_impl((level), __VA_ARGS__); \
+                } \
+            } while (0)
     #else
         #define log_logMessage log_logMessage_impl
-        extern void log_logMessage_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #else
     #error Illegal value for LOGGING_API_USES_VARIADIC_MACROS
@@ -281,6 +569,41 @@ extern void log_setStdoutSupression(bool suppress);
 
 
 
+/** Returns the text prepended to messages of the given level.
+ *
+ * @param level The level of the message.
+ * @return The prefix, e.g. "WARNING: ".
+ */
+extern char const *log_getLevelPrefix(log_level_t level);
+
+
+
+/** Checks if any channel accepts messages of the given level.
+ *
+ * @param level The level of the message.
+ * @return Would a message of the level be output?
+ */
+extern bool log_isLevelEnabled(log_level_t level);
+
+
+
+/** Logs the given message to whatever channels accept the specified log
+ * level.
+ *
+ * The message is terminated with an EOL (End-Of-Line) marker (i.e. LF or CR+LF).
+ *
+ * @param level The level of the message.
+ * @param format A format string as used by @see printf
+ * @param arglist A list of parameters as used by @see vprintf
+ */
+#if LOGGING_API_DISABLED
+    #define log_logVMessage(l, f, a)
+#else
+    extern void log_logVMessage(log_level_t level, char const *format, va_list arglist);
+#endif // !LOGGING_API_DISABLED
+
+
+
 /** Logs the start of a message to whatever channels accept the specified
  * log level.
  *
@@ -288,23 +611,34 @@ extern void log_setStdoutSupression(bool suppress);
  * (i.e. LF or CR+LF). You should call #log_logMessageContinue as many times
  * as necessary with the final call containing the EOL marker.
  *
+ * The parts are collected per thread and output as one record once the
+ * EOL marker arrives, so lines of concurrent threads never interleave.
+ *
  * @param level The level of the message.
  * @param format A format string as used by @see printf
  * @param ... A list of parameters as used by @see printf
  */
+extern void log_logMessageStart_impl(log_level_t level, char const *format, ...);
 #if 0 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessageStart(log)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessageStart(log) log_logMessageStart_min log
     #else
         #define log_logMessageStart(log) log_logMessageStart_impl log
-        extern void log_logMessageStart_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #elif 1 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessageStart(level, format, ...)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessageStart(level, ...) \
+            do { \
+                if (LOGGING_IS_COMPILED_IN(level)) { \
+                    log_logMessageStart_impl((level), __VA_ARGS__); \
+                } \
+            } while (0)
     #else
         #define log_logMessageStart log_logMessageStart_impl
-        extern void log_logMessageStart_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #else
     #error Illegal value for LOGGING_API_USES_VARIADIC_MACROS
@@ -345,19 +679,27 @@ extern void log_setStdoutSupression(bool suppress);
  * @param format A format string as used by @see printf
  * @param ... A list of parameters as used by @see printf
  */
+extern void log_logMessageContinue_impl(log_level_t level, char const *format, ...);
 #if 0 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessageContinue(log)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessageContinue(log) log_logMessageContinue_min log
     #else
         #define log_logMessageContinue(log) log_logMessageContinue_impl log
-        extern void log_logMessageContinue_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #elif 1 == LOGGING_API_USES_VARIADIC_MACROS
     #if LOGGING_API_DISABLED
         #define log_logMessageContinue(level, format, ...)
+    #elif defined(LOGGING_MIN_LEVEL)
+        #define log_logMessageContinue(level, ...) \
+            do { \
+                if (LOGGING_IS_COMPILED_IN(level)) { \
+                    log_logMessageContinue_impl((level), __VA_ARGS__); \
+                } \
+            } while (0)
     #else
         #define log_logMessageContinue log_logMessageContinue_impl
-        extern void log_logMessageContinue_impl(log_level_t level, char const *format, ...);
     #endif // !LOGGING_API_DISABLED
 #else
     #error Illegal value for LOGGING_API_USES_VARIADIC_MACROS
@@ -387,7 +729,49 @@ extern void log_setStdoutSupression(bool suppress);
 
 
 
-/** Logs the given data using loglevel LOGLEVEL_DEBUG2.
+#if defined(LOGGING_MIN_LEVEL) && (0 == LOGGING_API_USES_VARIADIC_MACROS) && !LOGGING_API_DISABLED
+/** Logs a message unless its level is below #LOGGING_MIN_LEVEL. */
+static inline void log_logMessage_min(log_level_t level, char const *format, ...) {
+    va_list args;
+
+    if (LOGGING_IS_COMPILED_IN(level)) {
+        va_start(args, format);
+        log_logVMessage(level, format, args);
+        va_end(args);
+    }
+}
+
+/** Logs the start of a message unless its level is below #LOGGING_MIN_LEVEL. */
+static inline void log_logMessageStart_min(log_level_t level, char const *format, ...) {
+    va_list args;
+
+    if (LOGGING_IS_COMPILED_IN(level)) {
+        va_start(args, format);
+        log_logVMessageStart(level, format, args);
+        va_end(args);
+    }
+}
+
+/** Continues a message unless its level is below #LOGGING_MIN_LEVEL. */
+static inline void log_logMessageContinue_min(log_level_t level, char const *format, ...) {
+    va_list args;
+
+    if (LOGGING_IS_COMPILED_IN(level)) {
+        va_start(args, format);
+        log_logVMessageContinue(level, format, args);
+        va_end(args);
+    }
+}
+#endif // LOGGING_MIN_LEVEL && !LOGGING_API_USES_VARIADIC_MACROS
+
+
+
+/** Logs the given data as a hex dump.
+ *
+ * The whole dump is output as a single record, so it is not interleaved
+ * with messages of other threads. Each line starts with the text
+ * describing the level; the lines following the first are indented to
+ * align with it.
  *
  * @param level The level of the message.
  * @param pData The data that will be logged.
@@ -402,4 +786,628 @@ extern void log_logData(log_level_t level,
                         size_t nrOfBytes,
                         char const *prefixStr,
                         size_t hexWidth);
+
+
+
+/** Logs at most the given number of bytes of the data as a hex dump.
+ *
+ * Works like #log_logData. If the data is longer than maxBytes, only the
+ * first maxBytes are dumped, followed by a line telling the number of
+ * bytes omitted.
+ *
+ * @param level The level of the message.
+ * @param pData The data that will be logged.
+ * @param nrOfBytes The number of data bytes.
+ * @param prefixStr A string that will prefix the first line of output.
+ * @param hexWidth The number of hex bytes to output per line.
+ * @param maxBytes The largest number of bytes to dump, 0 for no limit.
+ */
+extern void log_logDataLimited(log_level_t level,
+                               char const *pData,
+                               size_t nrOfBytes,
+                               char const *prefixStr,
+                               size_t hexWidth,
+                               size_t maxBytes);
+#ifdef LOGGING_MIN_LEVEL
+    #define log_logData(level, pData, nrOfBytes, prefixStr, hexWidth) \
+        do { \
+            if (LOGGING_IS_COMPILED_IN(level)) { \
+                log_logData((level), (pData), (nrOfBytes), (prefixStr), (hexWidth)); \
+            } \
+        } while (0)
+    #define log_logDataLimited(level, pData, nrOfBytes, prefixStr, hexWidth, maxBytes) \
+        do { \
+            if (LOGGING_IS_COMPILED_IN(level)) { \
+                log_logDataLimited((level), (pData), (nrOfBytes), (prefixStr), (hexWidth), (maxBytes)); \
+            } \
+        } while (0)
+#endif // LOGGING_MIN_LEVEL
+
+
+
+/** The largest number of arguments a binary log message may have. */
+#define LOG_BINARY_MAX_ARGS 16
+
+/** Describes a call site of #log_logBinary.
+
+    Each use of the macro creates one static descriptor. The format string
+    is written to the binary log file only once, each message refers to it
+    by the identifier of its call site.
+ */
+typedef struct {
+    /** The level of all messages logged from this call site. */
+    log_level_t level;
+    /** The source file containing the call site. */
+    char const *file;
+    /** The line of the call site in the source file. */
+    unsigned line;
+    /** The identifier of the call site, 0 until it is first used. */
+    uint32_t id;
+    /** The binary log file the definition of the call site was last
+        written to. If it differs from the current file, the definition is
+        written again.
+     */
+    LOGGING_ATOMIC(unsigned) generation;
+    /** The number of arguments required by the format string. */
+    unsigned char nrArgs;
+    /** The type of each argument, determined from the format string. */
+    unsigned char argTypes[LOG_BINARY_MAX_ARGS];
+} log_binary_site_t;
+
+
+
+/** Opens a binary log file.
+
+    Messages logged using #log_logBinary are written to this file without
+    formatting. Each message consists of the identifier of its call site, a
+    timestamp and the raw values of its arguments. Use #log_decodeBinary
+    (or the logdecode tool) to convert the file to text.
+
+    If a binary log file is currently open, it will be closed first.
+
+    @param filename The name (with path) of the file to create.
+    @param level All messages of this or a higher level are written.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The file could not be created. Check errno for details.
+ */
+extern bool log_openBinaryLogfile(char const *filename, log_level_t level);
+
+
+
+/** Closes the binary log file.
+
+    Afterwards, #log_logBinary formats its messages as text again.
+
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The file could not be closed.
+ */
+extern bool log_closeBinaryLogfile(void);
+
+
+
+/** Logs a message in binary form if a binary log file is open.
+
+    Only the identifier of the call site, a timestamp and the arguments are
+    recorded. Formatting is done later by #log_decodeBinary. If no binary
+    log file is open, the message is formatted and logged as text, just
+    like #log_logMessage.
+
+    The level must be a constant. The format string must be a string
+    literal with at most #LOG_BINARY_MAX_ARGS arguments. %n is not
+    supported.
+
+    @note Compilers without variadic macros always log as text.
+
+    <B>Example</B>:
+    <pre>
+    log_logBinary(LOGLEVEL_DEBUG, "received %u bytes from %s", n, peer);
+    </pre>
+
+    @param level The level of the message.
+    @param ... The format string followed by its arguments.
+ */
+#if LOGGING_API_DISABLED
+    #if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        #define log_logBinary(log)
+    #else
+        #define log_logBinary(level, ...)
+    #endif // LOGGING_API_USES_VARIADIC_MACROS
+#elif 0 == LOGGING_API_USES_VARIADIC_MACROS
+    #define log_logBinary(log) log_logMessage(log)
+#else
+    #define log_logBinary(level, ...) \
+        do { \
+            if (LOGGING_IS_COMPILED_IN(level)) { \
+                static log_binary_site_t log_binarySite = { (level), __FILE__, __LINE__, 0, 0, 0, { 0 } }; \
+                log_logBinary_impl(&log_binarySite, __VA_ARGS__); \
+            } \
+        } while (0)
+    extern void log_logBinary_impl(log_binary_site_t *pSite, char const *format, ...);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+
+
+/** Converts a binary log file to text.
+
+    Each message is written as a line in the format used by
+    #log_logMessage, i.e. "LEVEL: message". The input is read
+    sequentially, so it need not be seekable and may be a pipe.
+
+    @param pInput The binary log file, opened for reading in binary mode.
+    @param pOutput Receives the text.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The input is not a valid binary log file, or it is
+        truncated. All complete messages up to the error were written.
+ */
+extern bool log_decodeBinary(FILE *pInput, FILE *pOutput);
+
+
+
+/** A named group of messages (e.g. those of one module) with a level of
+    its own.
+
+    A message logged using #log_logCategory is output only if its level is
+    equal to or higher than the level of its category and is accepted by a
+    channel. The level of the default category (see
+    #log_setDefaultCategoryLevel) does not apply to it. Define categories using #LOG_DEFINE_CATEGORY. A category is
+    registered when it is first used; until then its level is
+    #LOGLEVEL_NONE, which lets the first message reach the registration.
+ */
+typedef struct log_category_s {
+    /** The name of the category used for its configuration. */
+    char const *name;
+    /** Messages below this level are discarded. */
+    LOGGING_ATOMIC(log_level_t) level;
+    /** The next registered category. */
+    struct log_category_s *next;
+} log_category_t;
+
+/** Defines the category variable with the given name. */
+#define LOG_DEFINE_CATEGORY(variable, name) \
+    log_category_t variable = { (name), LOGLEVEL_NONE, NULL }
+
+/** Declares a category variable defined elsewhere. */
+#define LOG_DECLARE_CATEGORY(variable) extern log_category_t variable
+
+
+
+/** Checks if a message of the given level of the category is output.
+
+    A disabled level costs a single load and compare at the call site.
+
+    @param category The category variable (not a pointer).
+    @param messageLevel The level of the message.
+    @return Is the message output?
+ */
+#if LOGGING_API_DISABLED
+    #define log_isCategoryEnabled(category, messageLevel) (false)
+#else
+    #define log_isCategoryEnabled(category, messageLevel) \
+        (LOGGING_IS_COMPILED_IN(messageLevel) \
+         && ((messageLevel) >= (category).level) \
+         && log_checkCategory(&(category), (messageLevel)))
+#endif // !LOGGING_API_DISABLED
+extern bool log_checkCategory(log_category_t *pCategory, log_level_t level);
+
+
+
+/** Logs a message of a category to whatever channels accept its level.
+
+    The arguments are evaluated only if the category accepts the level.
+
+    <B>Example</B>:
+    <pre>
+    LOG_DEFINE_CATEGORY(tcpCategory, "tcputils");
+
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG, "received %u bytes", n);
+    // Without variadic macros:
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG, (LOGLEVEL_DEBUG, "received %u bytes", n));
+    </pre>
+
+    @param category The category variable (not a pointer).
+    @param level The level of the message.
+    @param ... The format string followed by its arguments.
+ */
+#if LOGGING_API_DISABLED
+    #if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        #define log_logCategory(category, level, log)
+    #else
+        #define log_logCategory(category, level, ...)
+    #endif // LOGGING_API_USES_VARIADIC_MACROS
+#elif 0 == LOGGING_API_USES_VARIADIC_MACROS
+    #define log_logCategory(category, level, log) \
+        do { \
+            if (log_isCategoryEnabled(category, level)) { \
+                log_logCategory_impl log; \
+            } \
+        } while (0)
+#else
+    #define log_logCategory(category, level, ...) \
+        do { \
+            if (log_isCategoryEnabled(category, level)) { \
+                log_logCategory_impl((level), __VA_ARGS__); \
+            } \
+        } while (0)
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+extern void log_logCategory_impl(log_level_t level, char const *format, ...);
+
+
+
+/** Sets the level of all categories with the given name.
+
+    The level also applies to categories of that name registered later.
+    Using #LOGLEVEL_NONE discards all messages of the category except those
+    of level #LOGLEVEL_ALWAYS.
+
+    @param name The name of the category.
+    @param level The new level.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true Out of memory.
+ */
+extern bool log_setCategoryLevel(char const *name, log_level_t level);
+
+
+
+/** Sets the level of all categories without a level of their own.
+
+    Messages logged without a category (e.g. by #log_logMessage) belong to
+    the default category, so this also sets #log_setUncategorizedLevel.
+    Open the channels to a low level and raise the default level to see
+    the low levels of selected categories only.
+
+    The default is #LOGLEVEL_DEBUG3, i.e. the channels alone decide.
+
+    @param level The new level.
+ */
+extern void log_setDefaultCategoryLevel(log_level_t level);
+
+
+
+/** Sets the level of messages logged without a category.
+
+    Such messages below the level are discarded, even if a channel accepts
+    them. Usually set through #log_setDefaultCategoryLevel.
+
+    The default is #LOGLEVEL_NONE, i.e. the channels alone decide.
+
+    @param level The new level.
+ */
+extern void log_setUncategorizedLevel(log_level_t level);
+
+
+
+/** Configures the levels of the categories from an INI file.
+
+    The section <code>[categories]</code> contains one key per category
+    name and the key <code>default</code>. The values are level names
+    (e.g. <code>DEBUG</code>, <code>INFO</code>, <code>WARNING</code>) or
+    numbers of #log_level_t.
+
+    The levels of the file override those set by #log_setCategoryLevel
+    before. Each load replaces the levels of the previous file, so a
+    category removed from the file returns to the level set by name or the
+    default level.
+
+    @param filename The name (with path) of the file to load.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The file could not be loaded or contains an unknown level.
+        No level was changed.
+ */
+extern bool log_loadCategoryConfig(char const *filename);
+
+
+
+/** Reloads the category configuration when the process receives SIGHUP.
+
+    The signal handler only records the request. A thread started by the
+    first call loads the file, so no thread logging a message waits for the
+    file I/O. Without LOGGING_THREADS, the program loads the file by
+    calling #log_checkCategoryReload, e.g. from its main loop.
+
+    @param filename The name (with path) of the configuration file, see
+        #log_loadCategoryConfig.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The handler could not be installed or the platform has no
+        SIGHUP.
+ */
+extern bool log_installCategoryReloadHandler(char const *filename);
+
+
+
+/** Loads the category configuration if a reload has been requested.
+
+    Only needed without LOGGING_THREADS, see
+    #log_installCategoryReloadHandler.
+ */
+extern void log_checkCategoryReload(void);
+
+
+/** Describes a call site of #log_logRateLimited.
+
+    The limit is a token bucket: the call site may log burst messages at
+    once and rate messages per second on average. It is tracked as the
+    time the bucket will be full again, so a single compare-and-swap
+    decides if a message is logged.
+ */
+typedef struct {
+    /** The average number of messages per second. */
+    unsigned long rate;
+    /** The number of messages that may be logged at once. */
+    unsigned long burst;
+    /** The source file containing the call site. */
+    char const *file;
+    /** The line of the call site in the source file. */
+    unsigned line;
+    /** The time in ns at which the bucket is full again. */
+    LOGGING_ATOMIC(uint64_t) fullTime;
+    /** The number of messages discarded since the last one logged. */
+    LOGGING_ATOMIC(unsigned long) nrSuppressed;
+} log_rate_limit_t;
+
+
+
+/** Checks if a message of a rate limited call site may be logged.
+
+    If messages of the call site have been discarded, their number is
+    logged before this function returns true.
+
+    @param pLimit The call site.
+    @param level The level of the message.
+    @return Shall the message be logged?
+ */
+extern bool log_checkRateLimit(log_rate_limit_t *pLimit, log_level_t level);
+
+
+
+/** Logs a message at most rate times per second on average.
+
+    Up to burst messages are logged at once. Whether a message is logged
+    is decided before its arguments are evaluated or formatted. Messages
+    discarded by the limit are counted and reported by the next message
+    the call site logs.
+
+    <B>Example</B>:
+    <pre>
+    log_logRateLimited(10, 20, LOGLEVEL_ERROR, "recv: %s.", strerror(errno));
+    // Without variadic macros:
+    log_logRateLimited(10, 20, LOGLEVEL_ERROR, (LOGLEVEL_ERROR, "recv: %s.", strerror(errno)));
+    </pre>
+
+    @param rate The average number of messages per second (> 0).
+    @param burst The number of messages that may be logged at once (> 0).
+    @param level The level of the message.
+    @param ... The format string followed by its arguments.
+ */
+#if LOGGING_API_DISABLED
+    #if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        #define log_logRateLimited(rate, burst, level, log)
+    #else
+        #define log_logRateLimited(rate, burst, level, ...)
+    #endif // LOGGING_API_USES_VARIADIC_MACROS
+#elif 0 == LOGGING_API_USES_VARIADIC_MACROS
+    #define log_logRateLimited(rate, burst, level, log) \
+        do { \
+            static log_rate_limit_t log_rateLimit = { (rate), (burst), __FILE__, __LINE__, 0, 0 }; \
+            if (LOGGING_IS_COMPILED_IN(level) && log_checkRateLimit(&log_rateLimit, (level))) { \
+                log_logMessage_impl log; \
+            } \
+        } while (0)
+#else
+    #define log_logRateLimited(rate, burst, level, ...) \
+        do { \
+            static log_rate_limit_t log_rateLimit = { (rate), (burst), __FILE__, __LINE__, 0, 0 }; \
+            if (LOGGING_IS_COMPILED_IN(level) && log_checkRateLimit(&log_rateLimit, (level))) { \
+                log_logMessage_impl((level), __VA_ARGS__); \
+            } \
+        } while (0)
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+
+/** Describes a call site of #log_logSampled. */
+typedef struct {
+    /** One in this many messages is logged. */
+    unsigned long rate;
+    /** The number of messages of an enabled level seen so far. */
+    LOGGING_ATOMIC(unsigned long) counter;
+} log_sample_site_t;
+
+
+
+/** Checks if a message of a sampled call site is logged.
+
+    @param pSite The call site.
+    @param level The level of the message.
+    @param pNumber Receives the number of the message at the call site,
+        counting from 0.
+    @return Shall the message be logged?
+ */
+extern bool log_checkSample(log_sample_site_t *pSite, log_level_t level, unsigned long *pNumber);
+
+
+
+/** Logs a sampled message, see #log_logSampled.
+
+    @param pSite The call site.
+    @param number The number of the message at the call site.
+    @param level The level of the message.
+    @param format A format string as used by @see printf
+ */
+extern void log_logSampled_impl(log_sample_site_t const *pSite, unsigned long number,
+                                log_level_t level, char const *format, ...);
+
+
+
+/** Logs one in rate messages of the call site.
+
+    The first message is logged, then every rate-th. The decision is made
+    by incrementing a counter of the call site, before the arguments are
+    evaluated or formatted. Messages of a level no channel accepts are not
+    counted. See #log_setSamplingSummary to show the number of skipped
+    messages.
+
+    <B>Example</B>:
+    <pre>
+    log_logSampled(1000, LOGLEVEL_DEBUG, "queue length %u", length);
+    // Without variadic macros (no summary):
+    log_logSampled(1000, LOGLEVEL_DEBUG, (LOGLEVEL_DEBUG, "queue length %u", length));
+    </pre>
+
+    @param rate One in this many messages is logged (> 0).
+    @param level The level of the message.
+    @param ... The format string followed by its arguments.
+ */
+#if LOGGING_API_DISABLED
+    #if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        #define log_logSampled(rate, level, log)
+    #else
+        #define log_logSampled(rate, level, ...)
+    #endif // LOGGING_API_USES_VARIADIC_MACROS
+#elif 0 == LOGGING_API_USES_VARIADIC_MACROS
+    #define log_logSampled(rate, level, log) \
+        do { \
+            static log_sample_site_t log_sampleSite = { (rate), 0 }; \
+            unsigned long log_sampleNumber; \
+            if (LOGGING_IS_COMPILED_IN(level) && log_checkSample(&log_sampleSite, (level), &log_sampleNumber)) { \
+                log_logMessage_impl log; \
+            } \
+        } while (0)
+#else
+    #define log_logSampled(rate, level, ...) \
+        do { \
+            static log_sample_site_t log_sampleSite = { (rate), 0 }; \
+            unsigned long log_sampleNumber; \
+            if (LOGGING_IS_COMPILED_IN(level) && log_checkSample(&log_sampleSite, (level), &log_sampleNumber)) { \
+                log_logSampled_impl(&log_sampleSite, log_sampleNumber, (level), __VA_ARGS__); \
+            } \
+        } while (0)
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+
+
+/** Appends the number of skipped messages to sampled messages.
+
+    If enabled, each message logged by #log_logSampled after the first ends
+    with " (N skipped)", N being the number of messages the call site has
+    skipped so far. Disabled by default.
+
+    @param enable Append the summary?
+ */
+extern void log_setSamplingSummary(bool enable);
+
+
+
+
+/** Collapses consecutive identical messages.
+
+    If enabled, a message equal to the previous one (ignoring the
+    timestamp) is not output but counted. The next different message, or
+    the next flush, is preceded by "last message repeated K times".
+    Disabled by default.
+
+    @param enable Collapse identical messages?
+ */
+extern void log_setDuplicateSuppression(bool enable);
+
+
+/** A typed field of a structured log record. */
+typedef struct {
+    /** The name of the field. */
+    char const *key;
+    /** The type of the value. */
+    kv_value_type_t type;
+    /** The value. */
+    kv_value_t value;
+} log_field_t;
+
+/** Initializes a boolean field. */
+#define LOG_FIELD_BOOL(key, v) { (key), KV_VALUE_BOOL, { .b = (v) } }
+/** Initializes an integer field. */
+#define LOG_FIELD_INT(key, v) { (key), KV_VALUE_INTEGER, { .i = (v) } }
+/** Initializes a 64 bit integer field. */
+#define LOG_FIELD_INT64(key, v) { (key), KV_VALUE_INT64, { .i64 = (v) } }
+/** Initializes a floating-point field. */
+#define LOG_FIELD_FLOAT(key, v) { (key), KV_VALUE_FLOAT, { .f = (v) } }
+/** Initializes a string field. The string is not copied. */
+#define LOG_FIELD_STRING(key, v) { (key), KV_VALUE_STRING, { .s = (char *) (v) } }
+
+
+
+/** Opens a JSON-lines log file.
+
+    Records logged using #log_logFields are written to this file in
+    addition to the regular channels, one JSON object per line:
+    <pre>
+    {"ts":1697630000.123456,"level":"INFO","msg":"received","peer":"a","bytes":42}
+    </pre>
+    The timestamp is in seconds since the epoch. The fields follow in the
+    order given; their keys should not be "ts", "level" or "msg".
+
+    If a JSON log file is currently open, it will be closed first.
+
+    @param filename The name (with path) of the file to create.
+    @param append If true, the records are appended to an existing file.
+    @param level All records of this or a higher level are written.
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The file could not be opened. Check errno for details.
+ */
+extern bool log_openJsonLogfile(char const *filename, bool append, log_level_t level);
+
+
+
+/** Closes the JSON-lines log file.
+
+    Afterwards, #log_logFields logs its records only as text.
+
+    @return Did an error occur?
+    @retval false No error occurred.
+    @retval true The file could not be closed.
+ */
+extern bool log_closeJsonLogfile(void);
+
+
+
+/** Logs a structured record consisting of a message and typed fields.
+
+    The record is logged as text like #log_logMessage, the fields
+    appended to the message as key=value with the values in JSON notation.
+    It thus reaches all channels, the asynchronous writer and the flight
+    recorder subject to their levels. If a JSON-lines log file is open and
+    its level is met, the record is written to it as a JSON object as well
+    (see #log_openJsonLogfile).
+
+    The fields are serialized directly into the record, nothing is
+    allocated unless the record is larger than 1 KiB.
+
+    <B>Example</B>:
+    <pre>
+    log_field_t const fields[] = {
+        LOG_FIELD_STRING("peer", peer),
+        LOG_FIELD_INT("bytes", n)
+    };
+
+    log_logFields(LOGLEVEL_INFO, "received", fields, sizeof(fields) / sizeof(fields[0]));
+    </pre>
+
+    @param level The level of the record.
+    @param message The message of the record.
+    @param pFields The fields of the record. May be NULL if nrFields is 0.
+    @param nrFields The number of fields.
+ */
+extern void log_logFields(log_level_t level, char const *message,
+                          log_field_t const *pFields, size_t nrFields);
+#ifdef LOGGING_MIN_LEVEL
+    #define log_logFields(level, message, pFields, nrFields) \
+        do { \
+            if (LOGGING_IS_COMPILED_IN(level)) { \
+                log_logFields((level), (message), (pFields), (nrFields)); \
+            } \
+        } while (0)
+#endif // LOGGING_MIN_LEVEL
 #endif // LOGGING_H
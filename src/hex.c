@@ -52,11 +52,114 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#if !FTR_EMBEDDED
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // !_WIN32
+#endif // !FTR_EMBEDDED
 
 #include "hex.h"
 
 
+#ifndef FTR_HEX_SIMD
+#if FTR_EMBEDDED
+/** If non-zero, hex_encode() uses SSSE3/AVX2 where the CPU supports it. */
+#define FTR_HEX_SIMD 0
+#else
+#define FTR_HEX_SIMD 1
+#endif // FTR_EMBEDDED
+#endif // FTR_HEX_SIMD
+
+// The vector paths are only built for x86 compilers that can target an
+// instruction set per function, so the library itself needs no -m flags.
+#if FTR_HEX_SIMD && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define HEX_SIMD_X86 1
+#define HEX_TARGET(isa) __attribute__((target(isa)))
+#define hex_cpuHasSSSE3() __builtin_cpu_supports("ssse3")
+#define hex_cpuHasAVX2() __builtin_cpu_supports("avx2")
+#include <immintrin.h>
+#elif FTR_HEX_SIMD && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define HEX_SIMD_X86 1
+#define HEX_TARGET(isa)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#define HEX_SIMD_X86 0
+#endif
+
+
+
+#if HEX_SIMD_X86
+/** The hexadecimal digits, used as shuffle tables by the vector paths. */
+static char const hexDigitsUpper[16] = "0123456789ABCDEF";
+static char const hexDigitsLower[16] = "0123456789abcdef";
+#endif // HEX_SIMD_X86
+
+/** Two hexadecimal digits for every byte value, indexed by 2 * value. */
+static char const hexPairsUpper[512] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/** Lowercase variant of hexPairsUpper. */
+static char const hexPairsLower[512] =
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/** The value of every hexadecimal digit, -1 for all other characters. */
+static signed char const hexNibbles[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
 
 void int4ToHex(char *pDest, int_fast8_t value) {
     assert(NULL != pDest);
@@ -89,18 +192,110 @@ void int16ToHex(char *pDest, uint_fast16_t value) {
 
 
 
-void int32ToHex(char *pDest, uint_fast32_t value) {
+/** A byte of 0x01 in each of the eight bytes of a word. */
+#define HEX_SWAR_ONES UINT64_C(0x0101010101010101)
+
+
+/** Loads eight characters into a word, the first one in the most
+   significant byte. */
+static uint64_t hex_swarLoad(char const *pSrc) {
+    uint64_t x = 0;
     int i;
 
-    assert(NULL != pDest);
+    for (i = 0;i < 8;i ++) {
+        x = (x << 8) | (unsigned char) pSrc[i];
+    } // for i
+    return x;
+} // hex_swarLoad()
 
-    for (i = 7;i >= 0;i --, value >>= 4) {
-        *(pDest + i) = nibbleToHexDigit(value & 0x0f);
+
+
+/** Stores the bytes of a word as eight characters, the most significant
+   byte first. */
+static void hex_swarStore(char *pDest, uint64_t x) {
+    int i;
+
+    for (i = 7;i >= 0;i --, x >>= 8) {
+        pDest[i] = (char) (x & 0xff);
     } // for i
+} // hex_swarStore()
+
+
+
+/** Converts a 32 bit value to eight uppercase hexadecimal digits held
+   in a word, the most significant digit in the most significant byte. */
+static uint64_t hex_swarEncode(uint32_t value) {
+    uint64_t x = value;
+    uint64_t letters;
+
+    // Spread the nibbles so that each one occupies a byte.
+    x = ((x & UINT64_C(0xffff0000)) << 16) | (x & UINT64_C(0x0000ffff));
+    x = ((x & UINT64_C(0x0000ff000000ff00)) << 8) | (x & UINT64_C(0x000000ff000000ff));
+    x = ((x & UINT64_C(0x00f000f000f000f0)) << 4) | (x & UINT64_C(0x000f000f000f000f));
+
+    // Nibbles >= 10 carry into bit 4 when 6 is added; those digits are
+    // 'A' - '0' - 10 = 7 characters further.
+    letters = ((x + 6 * HEX_SWAR_ONES) >> 4) & HEX_SWAR_ONES;
+    return x + '0' * HEX_SWAR_ONES + 7 * letters;
+} // hex_swarEncode()
+
+
+
+/** Converts eight hexadecimal digits held in a word to a 32 bit value.
+
+   The digits are not checked, see hex_swarIsValid().
+ */
+static uint32_t hex_swarDecode(uint64_t x) {
+    // Letters are the only digits with bit 6 set, their low nibble is
+    // 9 less than their value.
+    x = (x & 0x0f * HEX_SWAR_ONES) + 9 * ((x >> 6) & HEX_SWAR_ONES);
+
+    // Gather the nibbles, halving the number of fields in each step.
+    x = (x | (x >> 4)) & UINT64_C(0x00ff00ff00ff00ff);
+    x = (x | (x >> 8)) & UINT64_C(0x0000ffff0000ffff);
+    x = (x | (x >> 16)) & UINT64_C(0x00000000ffffffff);
+    return (uint32_t) x;
+} // hex_swarDecode()
+
+
+
+/** Checks if all eight characters held in a word are hexadecimal digits. */
+static bool hex_swarIsValid(uint64_t x) {
+    uint64_t const high = 0x80 * HEX_SWAR_ONES;
+    uint64_t lower, isDigit, isLetter;
+
+    if (0 != (x & high)) {
+        return false;
+    }
+
+    // With bit 7 clear in every byte, adding 0x80 - n sets bit 7 exactly
+    // in the bytes >= n, and no carry crosses into the next byte.
+    isDigit = (x + (0x80 - '0') * HEX_SWAR_ONES) & ~(x + (0x7f - '9') * HEX_SWAR_ONES);
+    lower = x | 0x20 * HEX_SWAR_ONES;
+    isLetter = (lower + (0x80 - 'a') * HEX_SWAR_ONES) & ~(lower + (0x7f - 'f') * HEX_SWAR_ONES);
+
+    return high == ((isDigit | isLetter) & high);
+} // hex_swarIsValid()
+
+
+
+void int32ToHex(char *pDest, uint_fast32_t value) {
+    assert(NULL != pDest);
+
+    hex_swarStore(pDest, hex_swarEncode((uint32_t) value));
 } // int32ToHex()
 
 
 
+void int64ToHex(char *pDest, uint_fast64_t value) {
+    assert(NULL != pDest);
+
+    hex_swarStore(pDest, hex_swarEncode((uint32_t) (value >> 32)));
+    hex_swarStore(pDest + 8, hex_swarEncode((uint32_t) value));
+} // int64ToHex()
+
+
+
 uint_fast8_t hexToInt8(char const *pSrc) {
     uint_fast8_t n;
 
@@ -132,19 +327,347 @@ uint_fast16_t hexToInt16(char const *pSrc) {
 
 
 uint_fast32_t hexToInt32(char const *pSrc) {
-    uint_fast32_t n = 0;
-    int i;
+    uint64_t x;
 
     assert(NULL != pSrc);
 
-    for (i = 0;i < 8;i ++, pSrc++) {
-        assert(isxdigit((int) *pSrc));
-        n <<= 4;
-        n += (uint_fast16_t) hexdigitToNibble(*pSrc);
+    x = hex_swarLoad(pSrc);
+    assert(hex_swarIsValid(x));
+    return hex_swarDecode(x);
+} // hexToInt32()
+
+
+
+uint_fast64_t hexToInt64(char const *pSrc) {
+    uint64_t high, low;
+
+    assert(NULL != pSrc);
+
+    high = hex_swarLoad(pSrc);
+    low = hex_swarLoad(pSrc + 8);
+    assert(hex_swarIsValid(high) && hex_swarIsValid(low));
+    return ((uint_fast64_t) hex_swarDecode(high) << 32) | hex_swarDecode(low);
+} // hexToInt64()
+
+
+
+bool hexToInt32Checked(char const *pSrc, uint32_t *pValue) {
+    uint64_t x;
+
+    assert(NULL != pSrc);
+    assert(NULL != pValue);
+
+    x = hex_swarLoad(pSrc);
+    if (!hex_swarIsValid(x)) {
+        return true;
+    }
+    *pValue = hex_swarDecode(x);
+    return false;
+} // hexToInt32Checked()
+
+
+
+bool hexToInt64Checked(char const *pSrc, uint64_t *pValue) {
+    uint64_t high, low;
+
+    assert(NULL != pSrc);
+    assert(NULL != pValue);
+
+    high = hex_swarLoad(pSrc);
+    low = hex_swarLoad(pSrc + 8);
+    if (!hex_swarIsValid(high) || !hex_swarIsValid(low)) {
+        return true;
+    }
+    *pValue = ((uint64_t) hex_swarDecode(high) << 32) | hex_swarDecode(low);
+    return false;
+} // hexToInt64Checked()
+
+
+
+#if HEX_SIMD_X86
+#ifdef _MSC_VER
+/** Bit in hexCpuFeatures: the CPU supports SSSE3. */
+#define HEX_CPU_SSSE3 1u
+/** Bit in hexCpuFeatures: the CPU and the OS support AVX2. */
+#define HEX_CPU_AVX2 2u
+/** Bit in hexCpuFeatures: the features have been determined. */
+#define HEX_CPU_KNOWN 0x80u
+
+/** The CPU features used by the vector paths. Determining them twice
+   from different threads is harmless since the result is the same. */
+static volatile unsigned hexCpuFeatures = 0;
+
+
+/** Determines the CPU features once and returns them. */
+static unsigned hex_cpuFeatures(void) {
+    unsigned features = hexCpuFeatures;
+
+    if (0 == (features & HEX_CPU_KNOWN)) {
+        int regs[4];
+
+        features = HEX_CPU_KNOWN;
+        __cpuid(regs, 0);
+        if (regs[0] >= 1) {
+            __cpuid(regs, 1);
+            if (regs[2] & (1 << 9)) {
+                features |= HEX_CPU_SSSE3;
+            }
+            // AVX2 also requires the OS to save the YMM registers.
+            if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28))
+             && ((_xgetbv(0) & 6) == 6)) {
+                __cpuidex(regs, 7, 0);
+                if (regs[1] & (1 << 5)) {
+                    features |= HEX_CPU_AVX2;
+                }
+            }
+        }
+        hexCpuFeatures = features;
+    }
+
+    return features;
+} // hex_cpuFeatures()
+
+#define hex_cpuHasSSSE3() (hex_cpuFeatures() & HEX_CPU_SSSE3)
+#define hex_cpuHasAVX2() (hex_cpuFeatures() & HEX_CPU_AVX2)
+#endif // _MSC_VER
+
+
+
+/** Encodes blocks of 16 bytes using SSSE3.
+
+   Each nibble selects its digit from pDigits with a byte shuffle, the high
+   and low digits are then interleaved into output order.
+
+   @return The number of bytes encoded, a multiple of 16.
+ */
+HEX_TARGET("ssse3")
+static size_t hex_encodeSSSE3(char *pDest, unsigned char const *pSrc,
+                              size_t nrBytes, char const *pDigits) {
+    __m128i const digits = _mm_loadu_si128((__m128i const *) pDigits);
+    __m128i const mask = _mm_set1_epi8(0x0f);
+    size_t i;
+
+    for (i = 0;i + 16 <= nrBytes;i += 16) {
+        __m128i v = _mm_loadu_si128((__m128i const *) (pSrc + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+
+        _mm_storeu_si128((__m128i *) (pDest + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *) (pDest + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
     } // for i
 
-    return n;
-} // hexToInt32()
+    return i;
+} // hex_encodeSSSE3()
+
+
+
+/** Encodes blocks of 32 bytes using AVX2.
+
+   Works like hex_encodeSSSE3(), but since the unpack instructions operate
+   within 128 bit lanes, the lanes are recombined before storing.
+
+   @return The number of bytes encoded, a multiple of 32.
+ */
+HEX_TARGET("avx2")
+static size_t hex_encodeAVX2(char *pDest, unsigned char const *pSrc,
+                             size_t nrBytes, char const *pDigits) {
+    __m256i const digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((__m128i const *) pDigits));
+    __m256i const mask = _mm256_set1_epi8(0x0f);
+    size_t i;
+
+    for (i = 0;i + 32 <= nrBytes;i += 32) {
+        __m256i v = _mm256_loadu_si256((__m256i const *) (pSrc + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, mask));
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);   // bytes 0..7, 16..23
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);  // bytes 8..15, 24..31
+
+        _mm256_storeu_si256((__m256i *) (pDest + 2 * i),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *) (pDest + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    } // for i
+
+    return i;
+} // hex_encodeAVX2()
+
+
+
+/** Converts 16 hexadecimal digits to their values.
+
+   @param c The characters.
+   @param pValid Receives 0xff for every character that is a hexadecimal
+       digit and 0 for every other character.
+   @return The value of each digit, undefined for invalid characters.
+ */
+HEX_TARGET("ssse3")
+static __m128i hex_nibblesSSSE3(__m128i c, __m128i *pValid) {
+    // Only '0'..'9' map to 0..9, only 'A'..'F' and 'a'..'f' map to 0..5.
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    *pValid = _mm_or_si128(isDigit, isLetter);
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+} // hex_nibblesSSSE3()
+
+
+
+/** Decodes blocks of 32 digits to 16 bytes using SSSE3.
+
+   Stops before the first block containing an invalid character, so
+   the caller can locate it.
+
+   @return The number of bytes decoded, a multiple of 16.
+ */
+HEX_TARGET("ssse3")
+static size_t hex_decodeSSSE3(unsigned char *pDest, char const *pSrc, size_t nrBytes) {
+    // Combines each pair of nibbles to high * 16 + low.
+    __m128i const weights = _mm_set1_epi16(0x0110);
+    size_t i;
+
+    for (i = 0;i + 16 <= nrBytes;i += 16) {
+        __m128i valid1, valid2;
+        __m128i v1 = hex_nibblesSSSE3(_mm_loadu_si128((__m128i const *) (pSrc + 2 * i)), &valid1);
+        __m128i v2 = hex_nibblesSSSE3(_mm_loadu_si128((__m128i const *) (pSrc + 2 * i + 16)), &valid2);
+
+        if (_mm_movemask_epi8(_mm_and_si128(valid1, valid2)) != 0xffff) {
+            break;
+        }
+        _mm_storeu_si128((__m128i *) (pDest + i),
+                         _mm_packus_epi16(_mm_maddubs_epi16(v1, weights),
+                                          _mm_maddubs_epi16(v2, weights)));
+    } // for i
+
+    return i;
+} // hex_decodeSSSE3()
+
+
+
+/** Converts 32 hexadecimal digits to their values, see hex_nibblesSSSE3(). */
+HEX_TARGET("avx2")
+static __m256i hex_nibblesAVX2(__m256i c, __m256i *pValid) {
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+
+    *pValid = _mm256_or_si256(isDigit, isLetter);
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+} // hex_nibblesAVX2()
+
+
+
+/** Decodes blocks of 64 digits to 32 bytes using AVX2.
+
+   Works like hex_decodeSSSE3(), but since packing operates within 128 bit
+   lanes, the 64 bit quarters are put back in order before storing.
+
+   @return The number of bytes decoded, a multiple of 32.
+ */
+HEX_TARGET("avx2")
+static size_t hex_decodeAVX2(unsigned char *pDest, char const *pSrc, size_t nrBytes) {
+    __m256i const weights = _mm256_set1_epi16(0x0110);
+    size_t i;
+
+    for (i = 0;i + 32 <= nrBytes;i += 32) {
+        __m256i valid1, valid2;
+        __m256i v1 = hex_nibblesAVX2(_mm256_loadu_si256((__m256i const *) (pSrc + 2 * i)), &valid1);
+        __m256i v2 = hex_nibblesAVX2(_mm256_loadu_si256((__m256i const *) (pSrc + 2 * i + 32)), &valid2);
+        __m256i packed;
+
+        if (_mm256_movemask_epi8(_mm256_and_si256(valid1, valid2)) != -1) {
+            break;
+        }
+        packed = _mm256_packus_epi16(_mm256_maddubs_epi16(v1, weights),
+                                     _mm256_maddubs_epi16(v2, weights));
+        _mm256_storeu_si256((__m256i *) (pDest + i),
+                            _mm256_permute4x64_epi64(packed, 0xd8));
+    } // for i
+
+    return i;
+} // hex_decodeAVX2()
+#endif // HEX_SIMD_X86
+
+
+
+void hex_encode(char *pDest, void const *pSrc, size_t nrBytes, bool lowercase) {
+    unsigned char const *pValue = (unsigned char const *) pSrc;
+    char const *pPairs = lowercase ? hexPairsLower : hexPairsUpper;
+    size_t i = 0;
+
+    assert((NULL != pDest) || (0 == nrBytes));
+    assert((NULL != pSrc) || (0 == nrBytes));
+
+#if HEX_SIMD_X86
+    if (nrBytes >= 32 && hex_cpuHasAVX2()) {
+        i = hex_encodeAVX2(pDest, pValue, nrBytes,
+                           lowercase ? hexDigitsLower : hexDigitsUpper);
+    } else if (nrBytes >= 16 && hex_cpuHasSSSE3()) {
+        i = hex_encodeSSSE3(pDest, pValue, nrBytes,
+                            lowercase ? hexDigitsLower : hexDigitsUpper);
+    }
+#endif // HEX_SIMD_X86
+
+    // Encode the remaining bytes two digits at a time.
+    for (;i < nrBytes;i ++) {
+        char const *pPair = pPairs + 2 * (size_t) pValue[i];
+
+        pDest[2 * i]     = pPair[0];
+        pDest[2 * i + 1] = pPair[1];
+    } // for i
+} // hex_encode()
+
+
+
+bool hex_decode(void *pDest, char const *pSrc, size_t nrChars,
+                size_t *pErrorPosition) {
+    unsigned char *pValue = (unsigned char *) pDest;
+    size_t nrBytes = nrChars / 2;
+    size_t i = 0;
+
+    assert((NULL != pDest) || (nrChars < 2));
+    assert((NULL != pSrc) || (0 == nrChars));
+
+#if HEX_SIMD_X86
+    if (nrBytes >= 32 && hex_cpuHasAVX2()) {
+        i = hex_decodeAVX2(pValue, pSrc, nrBytes);
+    } else if (nrBytes >= 16 && hex_cpuHasSSSE3()) {
+        i = hex_decodeSSSE3(pValue, pSrc, nrBytes);
+    }
+#endif // HEX_SIMD_X86
+
+    // Decode the remaining digits, or locate the invalid character in
+    // the block the vector path rejected.
+    for (;i < nrBytes;i ++) {
+        signed char high = hexNibbles[(unsigned char) pSrc[2 * i]];
+        signed char low = hexNibbles[(unsigned char) pSrc[2 * i + 1]];
+
+        if ((high | low) < 0) {
+            if (NULL != pErrorPosition) {
+                *pErrorPosition = 2 * i + (high < 0 ? 0 : 1);
+            }
+            return true;
+        }
+        pValue[i] = (unsigned char) ((high << 4) | low);
+    } // for i
+
+    if (0 != (nrChars & 1)) {
+        // The last digit has no partner, which is reported as an invalid
+        // character after the end unless the digit itself is invalid.
+        if (NULL != pErrorPosition) {
+            *pErrorPosition = nrChars
+                - (hexNibbles[(unsigned char) pSrc[nrChars - 1]] < 0 ? 1 : 0);
+        }
+        return true;
+    }
+
+    return false;
+} // hex_decode()
 
 
 
@@ -263,10 +786,10 @@ char *hexbuf2String(char const *pValueBuffer, size_t nrBytes,
         } // if showASCII
 
         // Terminate the line
-        *pStringBuffer++ = '\n';
         if (useCRLF) {
             *pStringBuffer++ = '\r';
         }
+        *pStringBuffer++ = '\n';
 
         // Continue with next line (if any).
         currentOffset += lineWidth;
@@ -281,6 +804,217 @@ char *hexbuf2String(char const *pValueBuffer, size_t nrBytes,
 #endif // ENOMEM
 
 
+
+/** The longest line of a streaming hex dump: a 16 digit offset, the
+   values, the ASCII representation, and CR+LF. */
+#define HEX_DUMP_MAX_LINE_LENGTH (16 + 3 * HEX_DUMP_MAX_LINE_WIDTH + 1 + HEX_DUMP_MAX_LINE_WIDTH + 2)
+
+#if HEX_DUMP_BUFFER_SIZE < HEX_DUMP_MAX_LINE_LENGTH
+#error HEX_DUMP_BUFFER_SIZE must be able to hold at least one line.
+#endif
+
+
+
+/** Passes the buffered output of a streaming hex dump to the sink.
+
+   @param pDump The state of the dump.
+   @return Has the sink failed?
+ */
+static bool hex_dumpFlushBuffer(hex_dump_t *pDump) {
+    if ((pDump->bufferLength > 0) && !pDump->failed) {
+        pDump->failed = pDump->sink(pDump->pSinkContext, pDump->buffer, pDump->bufferLength);
+    }
+    pDump->bufferLength = 0;
+    return pDump->failed;
+} // hex_dumpFlushBuffer()
+
+
+
+/** Appends one line to the output buffer of a streaming hex dump in the
+   format of hexbuf2String().
+
+   @param pDump The state of the dump.
+   @param pData The bytes of the line.
+   @param nrBytes The number of bytes in the line, at most lineWidth.
+   @return Has the sink failed?
+ */
+static bool hex_dumpLine(hex_dump_t *pDump, unsigned char const *pData, unsigned nrBytes) {
+    char *pOut;
+    unsigned i;
+
+    if (HEX_DUMP_BUFFER_SIZE - pDump->bufferLength < HEX_DUMP_MAX_LINE_LENGTH) {
+        if (hex_dumpFlushBuffer(pDump)) {
+            return true;
+        }
+    }
+    pOut = pDump->buffer + pDump->bufferLength;
+
+    if (pDump->showOffset) {
+        uint64_t offset = (uint64_t) pDump->offset;
+
+        if (0 != (offset >> 32)) {
+            int64ToHex(pOut, offset);
+            pOut += 16;
+        } else {
+            int32ToHex(pOut, (uint_fast32_t) offset);
+            pOut += 8;
+        }
+    }
+
+    for (i = 0;i < nrBytes;i ++) {
+        *pOut++ = ' ';
+        memcpy(pOut, hexPairsUpper + 2 * (size_t) pData[i], 2);
+        pOut += 2;
+    } // for i
+
+    if (pDump->showASCII) {
+        *pOut++ = ' ';
+        // Align the ASCII representation of a short last line.
+        memset(pOut, ' ', 3 * (size_t) (pDump->lineWidth - nrBytes));
+        pOut += 3 * (size_t) (pDump->lineWidth - nrBytes);
+        for (i = 0;i < nrBytes;i ++) {
+            *pOut++ = isprint(pData[i]) ? (char) pData[i] : '.';
+        } // for i
+    }
+
+    if (pDump->useCRLF) {
+        *pOut++ = '\r';
+    }
+    *pOut++ = '\n';
+
+    pDump->bufferLength = (size_t) (pOut - pDump->buffer);
+    pDump->offset += nrBytes;
+    return false;
+} // hex_dumpLine()
+
+
+
+bool hex_dumpInit(hex_dump_t *pDump,
+                  hex_dump_sink_t sink, void *pSinkContext,
+                  bool useCRLF, bool showASCII, unsigned lineWidth,
+                  bool showOffset, size_t initialOffset) {
+    assert(NULL != pDump);
+    assert(NULL != sink);
+
+    if ((0 == lineWidth) || (lineWidth > HEX_DUMP_MAX_LINE_WIDTH)) {
+        return true;
+    }
+
+    pDump->sink = sink;
+    pDump->pSinkContext = pSinkContext;
+    pDump->lineWidth = lineWidth;
+    pDump->useCRLF = useCRLF;
+    pDump->showASCII = showASCII;
+    pDump->showOffset = showOffset;
+    pDump->failed = false;
+    pDump->offset = initialOffset;
+    pDump->nrPartialBytes = 0;
+    pDump->bufferLength = 0;
+    return false;
+} // hex_dumpInit()
+
+
+
+bool hex_dumpWrite(hex_dump_t *pDump, void const *pData, size_t nrBytes) {
+    unsigned char const *pValue = (unsigned char const *) pData;
+    unsigned lineWidth;
+
+    assert(NULL != pDump);
+    assert((NULL != pData) || (0 == nrBytes));
+
+    if (pDump->failed) {
+        return true;
+    }
+    lineWidth = pDump->lineWidth;
+
+    // Complete the line left over from the previous chunk.
+    if (pDump->nrPartialBytes > 0) {
+        size_t n = lineWidth - pDump->nrPartialBytes;
+
+        if (n > nrBytes) {
+            n = nrBytes;
+        }
+        memcpy(pDump->partialLine + pDump->nrPartialBytes, pValue, n);
+        pDump->nrPartialBytes += (unsigned) n;
+        pValue += n;
+        nrBytes -= n;
+        if (pDump->nrPartialBytes < lineWidth) {
+            return false;
+        }
+        pDump->nrPartialBytes = 0;
+        if (hex_dumpLine(pDump, pDump->partialLine, lineWidth)) {
+            return true;
+        }
+    }
+
+    // Complete lines are formatted directly from the chunk.
+    while (nrBytes >= lineWidth) {
+        if (hex_dumpLine(pDump, pValue, lineWidth)) {
+            return true;
+        }
+        pValue += lineWidth;
+        nrBytes -= lineWidth;
+    } // while nrBytes
+
+    memcpy(pDump->partialLine, pValue, nrBytes);
+    pDump->nrPartialBytes = (unsigned) nrBytes;
+    return false;
+} // hex_dumpWrite()
+
+
+
+bool hex_dumpFinish(hex_dump_t *pDump) {
+    assert(NULL != pDump);
+
+    if (pDump->nrPartialBytes > 0) {
+        unsigned nrBytes = pDump->nrPartialBytes;
+
+        pDump->nrPartialBytes = 0;
+        if (hex_dumpLine(pDump, pDump->partialLine, nrBytes)) {
+            return true;
+        }
+    }
+    return hex_dumpFlushBuffer(pDump);
+} // hex_dumpFinish()
+
+
+
+bool hex_dumpFileSink(void *pFile, char const *pText, size_t length) {
+    assert(NULL != pFile);
+
+    return fwrite(pText, 1, length, (FILE *) pFile) != length;
+} // hex_dumpFileSink()
+
+
+
+#if !FTR_EMBEDDED
+bool hex_dumpFdSink(void *pFd, char const *pText, size_t length) {
+    int fd;
+
+    assert(NULL != pFd);
+    fd = *(int *) pFd;
+
+    while (length > 0) {
+#ifdef _WIN32
+        int written = write(fd, pText, (unsigned) length);
+#else
+        ssize_t written = write(fd, pText, length);
+#endif // !_WIN32
+
+        if (written <= 0) {
+            if ((written < 0) && (EINTR == errno)) {
+                continue;
+            }
+            return true;
+        }
+        pText += written;
+        length -= (size_t) written;
+    } // while length
+    return false;
+} // hex_dumpFdSink()
+#endif // !FTR_EMBEDDED
+
+
 #ifdef TEST
 // To compile and run the test harness, use
 //
@@ -60,6 +60,97 @@
 #pragma warning(disable: 4996)
 #endif // _MSC_VER
 
+
+/** The number of buckets in a newly created hash index. Must be a power of 2. */
+#define KV_MINIMUM_BUCKETS 16
+
+
+
+/** Calculates the hash value of a key using FNV-1a.
+
+   @param pKey The key to hash.
+   @return The hash value.
+ */
+static uint32_t kv_hashKey(kv_key_t pKey) {
+    uint32_t hash = 2166136261ul;
+    unsigned char const *p = (unsigned char const *) pKey;
+
+    while ('\0' != *p) {
+        hash ^= *p++;
+        hash *= 16777619ul;
+    }
+
+    return hash;
+} // end kv_hashKey()
+
+
+
+/** Rebuilds the hash index of the collection with the given number of buckets.
+
+   If the index can not be allocated, the collection is left without an index.
+
+   @param pCollection The collection to index.
+   @param nrBuckets The number of buckets. Must be a power of 2.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true Out of memory.
+ */
+static bool kv_rebuildIndex(kv_collection_t *pCollection, size_t nrBuckets) {
+    kv_object_t **pBuckets;
+    kv_object_t *pObject;
+
+    assert(NULL != pCollection);
+    assert((nrBuckets & (nrBuckets - 1)) == 0);
+
+    free(pCollection->pBuckets);
+    pCollection->pBuckets = NULL;
+    pCollection->nrBuckets = 0;
+
+    if (NULL == (pBuckets = calloc(nrBuckets, sizeof(kv_object_t *)))) {
+        // Out of memory, continue without an index.
+        return true;
+    }
+
+    for (pObject = pCollection->first; NULL != pObject; pObject = pObject->next) {
+        kv_object_t **ppBucket = &pBuckets[pObject->hash & (nrBuckets - 1)];
+
+        pObject->nextInBucket = *ppBucket;
+        *ppBucket = pObject;
+    }
+
+    pCollection->pBuckets = pBuckets;
+    pCollection->nrBuckets = nrBuckets;
+    return false;
+} // end kv_rebuildIndex()
+
+
+
+/** Releases the memory occupied by the value of the object (if any).
+
+   Only strings and blobs own memory, and only if they are not borrowed.
+
+   @param pObject The object whose value is released.
+ */
+static void kv_freeValue(kv_object_t *pObject) {
+    assert(NULL != pObject);
+
+    if (!pObject->borrowed) {
+        if (KV_VALUE_STRING == pObject->type) {
+            if (NULL != pObject->value.s) {
+                free(pObject->value.s);
+            }
+        } else if (KV_VALUE_BLOB == pObject->type) {
+            if (NULL != pObject->value.blob.p) {
+                free(pObject->value.blob.p);
+            }
+        }
+    }
+
+    pObject->borrowed = false;
+} // end kv_freeValue()
+
+
+
 kv_object_t *kv_initializeIterator(kv_iterator_t *pIterator,
                                    kv_collection_t const *pCollection) {
     assert(NULL != pIterator);
@@ -93,6 +184,8 @@ kv_collection_t *kv_createCollection(void) {
     if (NULL != pCollection) {
         pCollection->first = NULL;
         pCollection->last  = NULL;
+        pCollection->pBuckets = NULL;
+        pCollection->pCounters = NULL;
     }
 
     return pCollection;
@@ -117,6 +210,11 @@ void kv_clearCollection(kv_collection_t *pCollection) {
 
     pCollection->first = NULL;
     pCollection->last  = NULL;
+    pCollection->nrObjects = 0;
+    if (NULL != pCollection->pBuckets) {
+        memset(pCollection->pBuckets, 0,
+               pCollection->nrBuckets * sizeof(kv_object_t *));
+    }
 } // end kv_clearCollection()
 
 
@@ -125,11 +223,114 @@ void kv_freeCollection(kv_collection_t *pCollection) {
     assert(NULL != pCollection);
 
     kv_clearCollection(pCollection);
+    free(pCollection->pBuckets);
+    free(pCollection->pCounters);
     free(pCollection);
 } // end kv_freeCollection()
 
 
 
+bool kv_reserve(kv_collection_t *pCollection, size_t nrObjects) {
+    size_t nrBuckets = KV_MINIMUM_BUCKETS;
+
+    assert(NULL != pCollection);
+
+    while (nrBuckets < nrObjects) {
+        nrBuckets *= 2;
+    }
+    if (nrBuckets <= pCollection->nrBuckets) {
+        // The index is already large enough.
+        return false;
+    }
+
+    return kv_rebuildIndex(pCollection, nrBuckets);
+} // end kv_reserve()
+
+
+
+bool kv_enableLookupCounters(kv_collection_t *pCollection, bool enable) {
+    assert(NULL != pCollection);
+
+    free(pCollection->pCounters);
+    pCollection->pCounters = NULL;
+
+    if (enable) {
+        if (NULL == (pCollection->pCounters = calloc(1ul, sizeof(kv_lookup_counters_t)))) {
+            // Out of memory.
+            return true;
+        }
+    }
+
+    return false;
+} // end kv_enableLookupCounters()
+
+
+
+void kv_getStatistics(kv_collection_t const *pCollection,
+                      kv_statistics_t *pStatistics) {
+    kv_iterator_t iterator;
+    kv_object_t *pObject;
+    size_t i;
+
+    assert(NULL != pCollection);
+    assert(NULL != pStatistics);
+
+    memset(pStatistics, 0, sizeof(*pStatistics));
+
+    // Memory occupied by the objects.
+    for (pObject = kv_initializeIterator(&iterator, pCollection);
+         NULL != pObject;
+         pObject = kv_iterateNext(&iterator)) {
+        pStatistics->nrObjects++;
+        pStatistics->objectBytes += sizeof(kv_object_t);
+        pStatistics->keyBytes += strlen(pObject->key) + 1;
+        if (!pObject->borrowed) {
+            if ((KV_VALUE_STRING == pObject->type) && (NULL != pObject->value.s)) {
+                pStatistics->valueBytes += strlen(pObject->value.s) + 1;
+            } else if (KV_VALUE_BLOB == pObject->type) {
+                pStatistics->valueBytes += pObject->value.blob.length;
+            }
+        }
+    }
+
+    // Shape of the index.
+    pStatistics->indexBytes = sizeof(kv_collection_t)
+        + pCollection->nrBuckets * sizeof(kv_object_t *)
+        + ((NULL != pCollection->pCounters) ? sizeof(kv_lookup_counters_t) : 0);
+    if (NULL == pCollection->pBuckets) {
+        // Every lookup walks the list.
+        pStatistics->averageChainLength = (double) pStatistics->nrObjects;
+        pStatistics->maximumChainLength = pStatistics->nrObjects;
+    } else {
+        pStatistics->nrBuckets = pCollection->nrBuckets;
+        for (i = 0; i < pCollection->nrBuckets; i++) {
+            size_t chainLength = 0;
+
+            for (pObject = pCollection->pBuckets[i];
+                 NULL != pObject;
+                 pObject = pObject->nextInBucket) {
+                chainLength++;
+            }
+            if (chainLength > 0) {
+                pStatistics->nrUsedBuckets++;
+            }
+            if (chainLength > pStatistics->maximumChainLength) {
+                pStatistics->maximumChainLength = chainLength;
+            }
+        }
+        if (pStatistics->nrUsedBuckets > 0) {
+            pStatistics->averageChainLength =
+                (double) pStatistics->nrObjects / (double) pStatistics->nrUsedBuckets;
+        }
+    }
+
+    if (NULL != pCollection->pCounters) {
+        pStatistics->counters = *pCollection->pCounters;
+    }
+} // end kv_getStatistics()
+
+
+
 kv_object_t *kv_createObject(kv_key_t pKey) {
     kv_object_t *pObject;
     assert(NULL != pKey);
@@ -146,6 +347,8 @@ kv_object_t *kv_createObject(kv_key_t pKey) {
     }
 
     pObject->next = NULL;
+    pObject->nextInBucket = NULL;
+    pObject->hash = kv_hashKey(pKey);
     return pObject;
 } // end kv_createObject()
 
@@ -154,12 +357,8 @@ kv_object_t *kv_createObject(kv_key_t pKey) {
 void kv_freeObject(kv_object_t *pObject) {
     assert(NULL != pObject);
 
-    if (KV_VALUE_STRING == pObject->type) {
-        if (NULL != pObject->value.s) {
-            free(pObject->value.s);
-        }
-    }
-
+    kv_freeValue(pObject);
+    free((char *) pObject->key);
     free(pObject);
 } // end freeObject()
 
@@ -168,22 +367,50 @@ void kv_freeObject(kv_object_t *pObject) {
 kv_object_t *kv_findObjectForKey(kv_collection_t const *pCollection, kv_key_t pKey) {
     kv_iterator_t iterator;
     kv_object_t   *pObject;
+    unsigned long nrProbes = 0;
 
 
     assert(NULL != pCollection);
     assert(NULL != pKey);
 
-    // Find the object matching the given key.
-    pObject = kv_initializeIterator(&iterator, pCollection);
-    while (NULL != pObject) {
-        assert(NULL != pObject->key);
-        if (strcmp((char *) pKey, (char *) pObject->key) == 0) {
-            return pObject;
+    if (NULL != pCollection->pBuckets) {
+        // Search only the objects in the bucket of the key.
+        uint32_t hash = kv_hashKey(pKey);
+
+        pObject = pCollection->pBuckets[hash & (pCollection->nrBuckets - 1)];
+        while (NULL != pObject) {
+            assert(NULL != pObject->key);
+            nrProbes++;
+            if ((hash == pObject->hash)
+             && (strcmp((char *) pKey, (char *) pObject->key) == 0)) {
+                break;
+            }
+            pObject = pObject->nextInBucket;
+        } // while pObject
+    } else {
+        // Find the object matching the given key.
+        pObject = kv_initializeIterator(&iterator, pCollection);
+        while (NULL != pObject) {
+            assert(NULL != pObject->key);
+            nrProbes++;
+            if (strcmp((char *) pKey, (char *) pObject->key) == 0) {
+                break;
+            }
+            pObject = kv_iterateNext(&iterator);
+        } // while pObject
+    }
+
+    if (NULL != pCollection->pCounters) {
+        pCollection->pCounters->nrLookups++;
+        pCollection->pCounters->nrProbes += nrProbes;
+        if (NULL == pObject) {
+            pCollection->pCounters->nrMisses++;
+        } else {
+            pCollection->pCounters->nrHits++;
         }
-        pObject = kv_iterateNext(&iterator);
-    } // while pObject
+    }
 
-    return NULL;
+    return pObject;
 } // end kv_findObjectForKey()
 
 
@@ -196,12 +423,24 @@ void kv_addObjectToCollection(kv_collection_t *pCollection, kv_object_t *pObject
     if (NULL == pCollection->first) {
         // This is the first (and only) object in the collection.
         pCollection->first = pCollection->last = pObject;
-        return;
+    } else {
+        // Insert object at the end of the list.
+        pCollection->last->next = pObject;
+        pCollection->last = pObject;
+    }
+    pCollection->nrObjects++;
+
+    if (pCollection->nrObjects > pCollection->nrBuckets) {
+        // Grow the index to keep the buckets short. This also adds the
+        // new object to the index.
+        (void) kv_reserve(pCollection, 2 * pCollection->nrObjects);
+    } else if (NULL != pCollection->pBuckets) {
+        kv_object_t **ppBucket =
+            &pCollection->pBuckets[pObject->hash & (pCollection->nrBuckets - 1)];
+
+        pObject->nextInBucket = *ppBucket;
+        *ppBucket = pObject;
     }
-
-    // Insert object at the end of the list.
-    pCollection->last->next = pObject;
-    pCollection->last = pObject;
 } // end kv_addObjectToCollection()
 
 
@@ -334,9 +573,7 @@ kv_object_t *kv_insertString(kv_collection_t *pCollection, kv_key_t const pKey,
     } else {
         // The key exists, so the value must be replaced.
         assert(KV_VALUE_STRING == pObject->type);
-        if (NULL != pObject->value.s) {
-            free(pObject->value.s);
-        }
+        kv_freeValue(pObject);
     }
 
     // Enter the value.
@@ -346,6 +583,272 @@ kv_object_t *kv_insertString(kv_collection_t *pCollection, kv_key_t const pKey,
 
 
 
+kv_object_t *kv_insertBorrowedString(kv_collection_t *pCollection, kv_key_t const pKey, char const *value) {
+    kv_object_t   *pObject;
+
+    assert(NULL != pCollection);
+    assert(NULL != pKey);
+
+
+    // Find the object matching the given key.
+    pObject = kv_findObjectForKey(pCollection, pKey);
+    if (NULL == pObject) {
+        // No object was found, so create it and add it to the collection.
+        if ((pObject = kv_createObject(pKey)) == NULL) {
+            // Out of memory error.
+            return NULL;
+        }
+        pObject->type = KV_VALUE_STRING;
+        kv_addObjectToCollection(pCollection, pObject);
+    } else {
+        // The key exists, so the value must be replaced.
+        assert(KV_VALUE_STRING == pObject->type);
+        kv_freeValue(pObject);
+    }
+
+    // Enter the value without copying it.
+    pObject->value.s = (char *) value;
+    pObject->borrowed = true;
+    return pObject;
+} // end kv_insertBorrowedString()
+
+
+
+kv_object_t *kv_insertInt64(kv_collection_t *pCollection, kv_key_t pKey, int64_t value) {
+    kv_object_t   *pObject;
+
+    assert(NULL != pCollection);
+    assert(NULL != pKey);
+
+
+    // Find the object matching the given key.
+    pObject = kv_findObjectForKey(pCollection, pKey);
+    if (NULL == pObject) {
+        // No object was found, so create it and add it to the collection.
+        if ((pObject = kv_createObject(pKey)) == NULL) {
+            // Out of memory error.
+            return NULL;
+        }
+        pObject->type = KV_VALUE_INT64;
+        kv_addObjectToCollection(pCollection, pObject);
+    }
+
+    // Enter the value.
+    assert(KV_VALUE_INT64 == pObject->type);
+    pObject->value.i64 = value;
+    return pObject;
+} // end kv_insertInt64()
+
+
+
+kv_object_t *kv_insertBlob(kv_collection_t *pCollection, kv_key_t pKey, void const *pData, size_t length) {
+    kv_object_t   *pObject;
+    void          *pCopy = NULL;
+
+    assert(NULL != pCollection);
+    assert(NULL != pKey);
+    assert((NULL != pData) || (0 == length));
+
+
+    // Copy the data first so a failure leaves the collection unchanged.
+    if (length > 0) {
+        if ((pCopy = malloc(length)) == NULL) {
+            // Out of memory error.
+            return NULL;
+        }
+        memcpy(pCopy, pData, length);
+    }
+
+    // Find the object matching the given key.
+    pObject = kv_findObjectForKey(pCollection, pKey);
+    if (NULL == pObject) {
+        // No object was found, so create it and add it to the collection.
+        if ((pObject = kv_createObject(pKey)) == NULL) {
+            // Out of memory error.
+            free(pCopy);
+            return NULL;
+        }
+        pObject->type = KV_VALUE_BLOB;
+        kv_addObjectToCollection(pCollection, pObject);
+    } else {
+        // The key exists, so the value must be replaced.
+        assert(KV_VALUE_BLOB == pObject->type);
+        kv_freeValue(pObject);
+    }
+
+    // Enter the value.
+    pObject->value.blob.p = pCopy;
+    pObject->value.blob.length = length;
+    return pObject;
+} // end kv_insertBlob()
+
+
+
+/** Compares the values of two objects.
+
+   @param pObject1 The first object.
+   @param pObject2 The second object.
+   @return Are type and value of both objects identical?
+ */
+static bool kv_isEqualValue(kv_object_t const *pObject1, kv_object_t const *pObject2) {
+    assert(NULL != pObject1);
+    assert(NULL != pObject2);
+
+    if (pObject1->type != pObject2->type) {
+        return false;
+    }
+
+    switch (pObject1->type) {
+        case KV_VALUE_BOOL:
+            return pObject1->value.b == pObject2->value.b;
+        case KV_VALUE_INTEGER:
+            return pObject1->value.i == pObject2->value.i;
+        case KV_VALUE_FLOAT:
+            return pObject1->value.f == pObject2->value.f;
+        case KV_VALUE_POINTER:
+            return pObject1->value.p == pObject2->value.p;
+        case KV_VALUE_INT64:
+            return pObject1->value.i64 == pObject2->value.i64;
+        case KV_VALUE_STRING:
+            if ((NULL == pObject1->value.s) || (NULL == pObject2->value.s)) {
+                return pObject1->value.s == pObject2->value.s;
+            }
+            return strcmp(pObject1->value.s, pObject2->value.s) == 0;
+        case KV_VALUE_BLOB:
+            return (pObject1->value.blob.length == pObject2->value.blob.length)
+                && ((0 == pObject1->value.blob.length)
+                    || (memcmp(pObject1->value.blob.p, pObject2->value.blob.p,
+                               pObject1->value.blob.length) == 0));
+        case KV_VALUE_UNSPECIFIED:
+        case KV_VALUE_UNKNOWN:
+            //!fallthrough
+        default:
+            return true;
+    } // switch type
+} // end kv_isEqualValue()
+
+
+
+/** Replaces the value of an object with a copy of the value of another.
+
+   @param pDestination The object receiving the value.
+   @param pSource The object whose value is copied.
+   @return Did an error occur?
+   @retval false No error occurred.
+   @retval true Out of memory, the destination is unchanged.
+ */
+static bool kv_copyValue(kv_object_t *pDestination, kv_object_t const *pSource) {
+    kv_value_t value = pSource->value;
+
+    assert(NULL != pDestination);
+    assert(NULL != pSource);
+
+    // Copy owned memory first so a failure leaves the destination unchanged.
+    if ((KV_VALUE_STRING == pSource->type) && (NULL != pSource->value.s)) {
+        if ((value.s = strdup(pSource->value.s)) == NULL) {
+            // Out of memory error.
+            return true;
+        }
+    } else if ((KV_VALUE_BLOB == pSource->type) && (pSource->value.blob.length > 0)) {
+        if ((value.blob.p = malloc(pSource->value.blob.length)) == NULL) {
+            // Out of memory error.
+            return true;
+        }
+        memcpy(value.blob.p, pSource->value.blob.p, pSource->value.blob.length);
+    }
+
+    kv_freeValue(pDestination);
+    pDestination->type = pSource->type;
+    pDestination->value = value;
+    return false;
+} // end kv_copyValue()
+
+
+
+bool kv_diff(kv_collection_t const *pOldCollection,
+             kv_collection_t const *pNewCollection,
+             kv_diff_callback_t callback,
+             void *pContext) {
+    kv_iterator_t iterator;
+    kv_object_t *pObject, *pOtherObject;
+
+    assert(NULL != pOldCollection);
+    assert(NULL != pNewCollection);
+    assert(NULL != callback);
+
+    // Keys that were removed or changed.
+    for (pObject = kv_initializeIterator(&iterator, pOldCollection);
+         NULL != pObject;
+         pObject = kv_iterateNext(&iterator)) {
+        pOtherObject = kv_findObjectForKey(pNewCollection, pObject->key);
+        if (NULL == pOtherObject) {
+            if (callback(pContext, KV_CHANGE_REMOVED, pObject, NULL)) {
+                return true;
+            }
+        } else if (!kv_isEqualValue(pObject, pOtherObject)) {
+            if (callback(pContext, KV_CHANGE_CHANGED, pObject, pOtherObject)) {
+                return true;
+            }
+        }
+    }
+
+    // Keys that were added.
+    for (pObject = kv_initializeIterator(&iterator, pNewCollection);
+         NULL != pObject;
+         pObject = kv_iterateNext(&iterator)) {
+        if (NULL == kv_findObjectForKey(pOldCollection, pObject->key)) {
+            if (callback(pContext, KV_CHANGE_ADDED, NULL, pObject)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+} // end kv_diff()
+
+
+
+bool kv_merge(kv_collection_t *pDestination,
+              kv_collection_t const *pSource,
+              kv_merge_policy_t policy) {
+    kv_iterator_t iterator;
+    kv_object_t *pObject, *pDestinationObject;
+
+    assert(NULL != pDestination);
+    assert(NULL != pSource);
+    assert(pDestination != pSource);
+
+    // Grow the index once instead of repeatedly while appending. A failure
+    // only makes the merge slower.
+    (void) kv_reserve(pDestination, pDestination->nrObjects + pSource->nrObjects);
+
+    for (pObject = kv_initializeIterator(&iterator, pSource);
+         NULL != pObject;
+         pObject = kv_iterateNext(&iterator)) {
+        pDestinationObject = kv_findObjectForKey(pDestination, pObject->key);
+        if (NULL == pDestinationObject) {
+            if ((pDestinationObject = kv_createObject(pObject->key)) == NULL) {
+                // Out of memory error.
+                return true;
+            }
+            if (kv_copyValue(pDestinationObject, pObject)) {
+                kv_freeObject(pDestinationObject);
+                return true;
+            }
+            kv_addObjectToCollection(pDestination, pDestinationObject);
+        } else if ((KV_MERGE_OVERWRITE == policy)
+                && !kv_isEqualValue(pDestinationObject, pObject)) {
+            if (kv_copyValue(pDestinationObject, pObject)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+} // end kv_merge()
+
+
+
 bool kv_remove(kv_collection_t *pCollection, kv_key_t pKey) {
     kv_iterator_t iterator;
     kv_object_t   *pObject, *pPreviousObject = NULL;
@@ -381,6 +884,19 @@ bool kv_remove(kv_collection_t *pCollection, kv_key_t pKey) {
     if (pCollection->last == pObject) {
         pCollection->last = pPreviousObject;
     }
+    pCollection->nrObjects--;
+
+    // Remove the object from the hash index.
+    if (NULL != pCollection->pBuckets) {
+        kv_object_t **ppBucket =
+            &pCollection->pBuckets[pObject->hash & (pCollection->nrBuckets - 1)];
+
+        while (*ppBucket != pObject) {
+            assert(NULL != *ppBucket);
+            ppBucket = &(*ppBucket)->nextInBucket;
+        }
+        *ppBucket = pObject->nextInBucket;
+    }
 
     kv_freeObject(pObject);
     return true;
@@ -441,6 +957,27 @@ char const *kv_getStringValueFromObject(kv_object_t const *pObject) {
 
 
 
+int64_t kv_getInt64ValueFromObject(kv_object_t const *pObject) {
+    assert(NULL != pObject);
+    assert(KV_VALUE_INT64 == pObject->type);
+
+    return pObject->value.i64;
+} // end kv_getInt64ValueFromObject()
+
+
+
+void const *kv_getBlobValueFromObject(kv_object_t const *pObject, size_t *pLength) {
+    assert(NULL != pObject);
+    assert(KV_VALUE_BLOB == pObject->type);
+
+    if (NULL != pLength) {
+        *pLength = pObject->value.blob.length;
+    }
+    return pObject->value.blob.p;
+} // end kv_getBlobValueFromObject()
+
+
+
 bool kv_getBool(kv_collection_t const *pCollection, kv_key_t const pKey) {
     kv_object_t *obj = kv_findObjectForKey(pCollection, pKey);
 
@@ -508,3 +1045,34 @@ char const *kv_getString(kv_collection_t const *pCollection, kv_key_t const pKey
     assert(KV_VALUE_STRING == obj->type);
     return kv_getStringValueFromObject(obj);
 } // end kv_getString()
+
+
+
+int64_t kv_getInt64(kv_collection_t const *pCollection, kv_key_t const pKey) {
+    kv_object_t *obj = kv_findObjectForKey(pCollection, pKey);
+
+
+    if (NULL == obj) {
+        return 0;
+    }
+
+    assert(KV_VALUE_INT64 == obj->type);
+    return kv_getInt64ValueFromObject(obj);
+} // end kv_getInt64()
+
+
+
+void const *kv_getBlob(kv_collection_t const *pCollection, kv_key_t const pKey, size_t *pLength) {
+    kv_object_t *obj = kv_findObjectForKey(pCollection, pKey);
+
+
+    if (NULL == obj) {
+        if (NULL != pLength) {
+            *pLength = 0;
+        }
+        return NULL;
+    }
+
+    assert(KV_VALUE_BLOB == obj->type);
+    return kv_getBlobValueFromObject(obj, pLength);
+} // end kv_getBlob()
@@ -0,0 +1,519 @@
+/** Loads INI-style key-value files into key-value collections.
+
+
+    @file keyvalue_ini.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+#include "keyvalue.h"
+
+
+#ifdef _MSC_VER
+// Disable warnings for functions VS C considers deprecated.
+#pragma warning(disable: 4996)
+#endif // _MSC_VER
+
+
+/** The initial size of the buffer used to assemble keys and values. */
+#define KV_INI_SCRATCH_SIZE 256
+
+
+// Provided by keyvalue_json.c.
+extern bool kv_jsonStrtod(char const *pNumber, size_t length, double *pValue);
+
+
+
+/** True if the character is whitespace within a line.
+
+   This is cheaper than isspace() and does not depend on the locale.
+ */
+#define isBlank(c) ((' ' == (c)) || ('\t' == (c)) || ('\r' == (c)) || ('\f' == (c)) || ('\v' == (c)))
+
+
+
+/** Records an error in the (optional) error description.
+
+   @param pError The error description or NULL.
+   @param line The line number of the error.
+   @param message The description of the error.
+   @return Always true, so the result can be returned directly.
+ */
+static bool kv_iniError(kv_parse_error_t *pError, unsigned long line, char const *message) {
+    if (NULL != pError) {
+        pError->line = line;
+        pError->message = message;
+    }
+    return true;
+} // end kv_iniError()
+
+
+
+/** Compares a value to a lowercase word, ignoring the case of the value.
+
+   @param pValue The start of the value.
+   @param length The length of the value.
+   @param word The lowercase word to compare against.
+   @return Is the value equal to the word?
+ */
+static bool kv_iniIsWord(char const *pValue, size_t length, char const *word) {
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        char c = pValue[i];
+
+        if (('A' <= c) && (c <= 'Z')) {
+            c = (char) (c - 'A' + 'a');
+        }
+        if (c != word[i]) {
+            // Also handles the end of the word.
+            return false;
+        }
+    }
+
+    return '\0' == word[length];
+} // end kv_iniIsWord()
+
+
+
+/** Parses a decimal or 0x-prefixed hexadecimal integer.
+
+   @param pValue The start of the value.
+   @param length The length of the value.
+   @param pResult Returns the integer value.
+   @return Is the value an integer that fits into 64 bits?
+ */
+static bool kv_iniParseInteger(char const *pValue, size_t length, int64_t *pResult) {
+    char const *pEnd = pValue + length;
+    bool negative = false;
+    uint64_t value = 0;
+
+    if ((pValue < pEnd) && (('-' == *pValue) || ('+' == *pValue))) {
+        negative = ('-' == *pValue);
+        pValue++;
+    }
+    if (pValue == pEnd) {
+        return false;
+    }
+
+    if ((pEnd - pValue > 2) && ('0' == pValue[0])
+     && (('x' == pValue[1]) || ('X' == pValue[1]))) {
+        pValue += 2;
+        if (pEnd - pValue > 16) {
+            return false;
+        }
+        for (; pValue < pEnd; pValue++) {
+            char c = *pValue;
+
+            if (('0' <= c) && (c <= '9')) {
+                value = (value << 4) | (uint64_t) (c - '0');
+            } else if (('a' <= c) && (c <= 'f')) {
+                value = (value << 4) | (uint64_t) (c - 'a' + 10);
+            } else if (('A' <= c) && (c <= 'F')) {
+                value = (value << 4) | (uint64_t) (c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        if (negative) {
+            return false;
+        }
+        // Hexadecimal values are bit patterns, so 0xffffffffffffffff is -1.
+        *pResult = (int64_t) value;
+        return true;
+    }
+
+    for (; pValue < pEnd; pValue++) {
+        unsigned digit = (unsigned) (*pValue - '0');
+
+        if (digit > 9) {
+            return false;
+        }
+        if (value > (UINT64_C(0x8000000000000000) - digit) / 10) {
+            // Overflow.
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+
+    if (negative) {
+        *pResult = (value == UINT64_C(0x8000000000000000))
+                   ? INT64_MIN : -(int64_t) value;
+    } else {
+        if (value > (uint64_t) INT64_MAX) {
+            return false;
+        }
+        *pResult = (int64_t) value;
+    }
+    return true;
+} // end kv_iniParseInteger()
+
+
+
+/** Infers the type of the value and inserts it into the collection.
+
+   @param pCollection The collection to insert the value into.
+   @param pKey The NUL-terminated key.
+   @param pValue The NUL-terminated value.
+   @param length The length of the value.
+   @param isQuoted True if the value was quoted and must be a string.
+   @return The object containing the value or NULL if out of memory.
+ */
+static kv_object_t *kv_iniInsert(kv_collection_t *pCollection,
+                                 char const *pKey,
+                                 char const *pValue, size_t length,
+                                 bool isQuoted) {
+    kv_value_type_t type = KV_VALUE_STRING;
+    bool b = false;
+    int64_t i = 0;
+    double f = 0.0;
+    kv_object_t *pObject;
+
+    if (!isQuoted && (length > 0)) {
+        if (kv_iniIsWord(pValue, length, "true")
+         || kv_iniIsWord(pValue, length, "yes")
+         || kv_iniIsWord(pValue, length, "on")) {
+            type = KV_VALUE_BOOL;
+            b = true;
+        } else if (kv_iniIsWord(pValue, length, "false")
+                || kv_iniIsWord(pValue, length, "no")
+                || kv_iniIsWord(pValue, length, "off")) {
+            type = KV_VALUE_BOOL;
+            b = false;
+        } else if (kv_iniParseInteger(pValue, length, &i)) {
+            type = ((i >= INT_MIN) && (i <= INT_MAX))
+                   ? KV_VALUE_INTEGER : KV_VALUE_INT64;
+        } else if (((('0' <= *pValue) && (*pValue <= '9'))
+                 || ('-' == *pValue) || ('+' == *pValue) || ('.' == *pValue))
+                && (strspn(pValue, "0123456789+-.eE") == length)) {
+            // Only numbers are passed to strtod(), it would accept
+            // words such as "nan" or "infinity" as well. The decimal point
+            // is always '.', whatever the locale.
+            if (!kv_jsonStrtod(pValue, length, &f) && isfinite(f)) {
+                type = KV_VALUE_FLOAT;
+            }
+        }
+    }
+
+    // A key may change its type if it occurs more than once.
+    pObject = kv_findObjectForKey(pCollection, pKey);
+    if ((NULL != pObject) && (type != pObject->type)) {
+        (void) kv_remove(pCollection, pKey);
+    }
+
+    switch (type) {
+        case KV_VALUE_BOOL:
+            return kv_insertBool(pCollection, pKey, b);
+        case KV_VALUE_INTEGER:
+            return kv_insertInt(pCollection, pKey, (int) i);
+        case KV_VALUE_INT64:
+            return kv_insertInt64(pCollection, pKey, i);
+        case KV_VALUE_FLOAT:
+            return kv_insertFloat(pCollection, pKey, f);
+        default:
+            pObject = kv_insertString(pCollection, pKey, pValue);
+            if ((NULL != pObject) && (NULL == pObject->value.s)) {
+                // The string could not be copied.
+                return NULL;
+            }
+            return pObject;
+    } // switch type
+} // end kv_iniInsert()
+
+
+
+bool kv_parseIni(kv_collection_t *pCollection,
+                 char const *pText, size_t length,
+                 kv_parse_error_t *pError) {
+    char const *pEndOfText = pText + length;
+    char const *pLine;
+    unsigned long lineNumber = 0;
+    char *pScratch;
+    size_t scratchSize = KV_INI_SCRATCH_SIZE;
+    size_t sectionLength = 0;
+    size_t nrLines = 0;
+    bool result = false;
+
+    assert(NULL != pCollection);
+    assert((NULL != pText) || (0 == length));
+
+    if (NULL != pError) {
+        pError->line = 0;
+        pError->message = NULL;
+    }
+
+    // Size the index for the worst case of one key per line so that it
+    // does not have to grow while inserting.
+    for (pLine = pText; pLine < pEndOfText; nrLines++) {
+        pLine = memchr(pLine, '\n', (size_t) (pEndOfText - pLine));
+        if (NULL == pLine) {
+            break;
+        }
+        pLine++;
+    }
+    (void) kv_reserve(pCollection, pCollection->nrObjects + nrLines + 1);
+
+    // The scratch buffer holds the current section prefix followed by
+    // the key and the value of the current line, each NUL-terminated.
+    if (NULL == (pScratch = malloc(scratchSize))) {
+        return kv_iniError(pError, 0, "out of memory");
+    }
+
+    for (pLine = pText; pLine < pEndOfText; ) {
+        char const *pEndOfLine, *pNextLine, *pDelimiter;
+        char const *pKey, *pEndOfKey, *pValue, *pEndOfValue;
+        size_t keyLength, valueLength, requiredSize;
+        bool isQuoted = false;
+
+        lineNumber++;
+        pEndOfLine = memchr(pLine, '\n', (size_t) (pEndOfText - pLine));
+        if (NULL == pEndOfLine) {
+            pEndOfLine = pEndOfText;
+            pNextLine = pEndOfText;
+        } else {
+            pNextLine = pEndOfLine + 1;
+        }
+
+        // Trim the line by moving the pointers, the text is never modified.
+        while ((pLine < pEndOfLine) && isBlank(*pLine)) {
+            pLine++;
+        }
+        while ((pEndOfLine > pLine) && isBlank(*(pEndOfLine - 1))) {
+            pEndOfLine--;
+        }
+
+        if ((pLine == pEndOfLine) || (';' == *pLine) || ('#' == *pLine)) {
+            // Empty line or comment.
+            pLine = pNextLine;
+            continue;
+        }
+
+        if ('[' == *pLine) {
+            // Section header.
+            if (']' != *(pEndOfLine - 1)) {
+                result = kv_iniError(pError, lineNumber, "missing ']' in section header");
+                break;
+            }
+            pKey = pLine + 1;
+            pEndOfKey = pEndOfLine - 1;
+            while ((pKey < pEndOfKey) && isBlank(*pKey)) {
+                pKey++;
+            }
+            while ((pEndOfKey > pKey) && isBlank(*(pEndOfKey - 1))) {
+                pEndOfKey--;
+            }
+            sectionLength = (size_t) (pEndOfKey - pKey);
+            if (sectionLength + 1 > scratchSize) {
+                char *pNew;
+
+                scratchSize = 2 * (sectionLength + 1);
+                if (NULL == (pNew = realloc(pScratch, scratchSize))) {
+                    result = kv_iniError(pError, lineNumber, "out of memory");
+                    break;
+                }
+                pScratch = pNew;
+            }
+            memcpy(pScratch, pKey, sectionLength);
+            if (sectionLength > 0) {
+                // Separate the section from the keys.
+                pScratch[sectionLength++] = '.';
+            }
+            pLine = pNextLine;
+            continue;
+        }
+
+        // Key-value pair.
+        pDelimiter = memchr(pLine, '=', (size_t) (pEndOfLine - pLine));
+        if (NULL == pDelimiter) {
+            result = kv_iniError(pError, lineNumber, "missing '=' after key");
+            break;
+        }
+        pKey = pLine;
+        pEndOfKey = pDelimiter;
+        while ((pEndOfKey > pKey) && isBlank(*(pEndOfKey - 1))) {
+            pEndOfKey--;
+        }
+        if (pKey == pEndOfKey) {
+            result = kv_iniError(pError, lineNumber, "missing key before '='");
+            break;
+        }
+        pValue = pDelimiter + 1;
+        pEndOfValue = pEndOfLine;
+        while ((pValue < pEndOfValue) && isBlank(*pValue)) {
+            pValue++;
+        }
+        if ((pEndOfValue - pValue >= 2)
+         && ('"' == *pValue) && ('"' == *(pEndOfValue - 1))) {
+            pValue++;
+            pEndOfValue--;
+            isQuoted = true;
+        }
+        keyLength = (size_t) (pEndOfKey - pKey);
+        valueLength = (size_t) (pEndOfValue - pValue);
+
+        // Assemble section.key\0value\0 in the scratch buffer.
+        requiredSize = sectionLength + keyLength + 1 + valueLength + 1;
+        if (requiredSize > scratchSize) {
+            char *pNew;
+
+            scratchSize = 2 * requiredSize;
+            if (NULL == (pNew = realloc(pScratch, scratchSize))) {
+                result = kv_iniError(pError, lineNumber, "out of memory");
+                break;
+            }
+            pScratch = pNew;
+        }
+        memcpy(pScratch + sectionLength, pKey, keyLength);
+        pScratch[sectionLength + keyLength] = '\0';
+        memcpy(pScratch + sectionLength + keyLength + 1, pValue, valueLength);
+        pScratch[sectionLength + keyLength + 1 + valueLength] = '\0';
+
+        if (NULL == kv_iniInsert(pCollection, pScratch,
+                                 pScratch + sectionLength + keyLength + 1,
+                                 valueLength, isQuoted)) {
+            result = kv_iniError(pError, lineNumber, "out of memory");
+            break;
+        }
+
+        pLine = pNextLine;
+    } // for pLine
+
+    free(pScratch);
+    return result;
+} // end kv_parseIni()
+
+
+
+bool kv_loadIniFile(kv_collection_t *pCollection,
+                    char const *filename,
+                    kv_parse_error_t *pError) {
+    bool result;
+
+    assert(NULL != pCollection);
+    assert(NULL != filename);
+
+#ifdef _WIN32
+    {
+        FILE *fp;
+        long fileSize;
+        char *pText;
+
+        if (NULL == (fp = fopen(filename, "rb"))) {
+            return kv_iniError(pError, 0, strerror(errno));
+        }
+        if ((fseek(fp, 0, SEEK_END) != 0) || ((fileSize = ftell(fp)) < 0)
+         || (fseek(fp, 0, SEEK_SET) != 0)) {
+            (void) fclose(fp);
+            return kv_iniError(pError, 0, strerror(errno));
+        }
+        if (NULL == (pText = malloc((size_t) fileSize + 1))) {
+            (void) fclose(fp);
+            return kv_iniError(pError, 0, "out of memory");
+        }
+        if (fread(pText, 1, (size_t) fileSize, fp) != (size_t) fileSize) {
+            free(pText);
+            (void) fclose(fp);
+            return kv_iniError(pError, 0, "unable to read file");
+        }
+        (void) fclose(fp);
+
+        result = kv_parseIni(pCollection, pText, (size_t) fileSize, pError);
+        free(pText);
+    }
+#else
+    {
+        int fd;
+        struct stat fileStatus;
+        void *pText;
+
+        if ((fd = open(filename, O_RDONLY)) < 0) {
+            return kv_iniError(pError, 0, strerror(errno));
+        }
+        if (fstat(fd, &fileStatus) != 0) {
+            int savedErrno = errno;
+
+            (void) close(fd);
+            errno = savedErrno;
+            return kv_iniError(pError, 0, strerror(errno));
+        }
+        if (0 == fileStatus.st_size) {
+            // An empty file can not be mapped, but it is valid.
+            (void) close(fd);
+            return kv_parseIni(pCollection, NULL, 0, pError);
+        }
+
+        pText = mmap(NULL, (size_t) fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        (void) close(fd);
+        if (MAP_FAILED == pText) {
+            return kv_iniError(pError, 0, strerror(errno));
+        }
+#ifdef MADV_SEQUENTIAL
+        (void) madvise(pText, (size_t) fileStatus.st_size, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+
+        result = kv_parseIni(pCollection, (char const *) pText,
+                             (size_t) fileStatus.st_size, pError);
+        (void) munmap(pText, (size_t) fileStatus.st_size);
+    }
+#endif // !_WIN32
+
+    return result;
+} // end kv_loadIniFile()
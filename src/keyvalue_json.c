@@ -0,0 +1,986 @@
+/** Converts key-value collections to and from JSON.
+
+
+    @file keyvalue_json.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+#include <assert.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hex.h"
+#include "keyvalue.h"
+
+
+#ifdef _MSC_VER
+// Disable warnings for functions VS C considers deprecated.
+#pragma warning(disable: 4996)
+#endif // _MSC_VER
+
+
+/** The size of the buffer collecting output for a sink. */
+#define KV_JSON_CHUNK_SIZE 4096
+
+/** The size of the buffer used to convert a number for strtod() if the
+   locale does not use '.' as the decimal point. Longer numbers are
+   copied to a malloc()ed buffer. */
+#define KV_JSON_NUMBER_SIZE 64
+
+
+/** Collects JSON output either in a caller-supplied buffer or in a chunk
+   that is passed to a sink whenever it is full.
+ */
+typedef struct {
+    /** The buffer receiving the output. */
+    char *pBuffer;
+    /** The size of the buffer in bytes. */
+    size_t bufferSize;
+    /** The number of bytes currently in the buffer. */
+    size_t used;
+    /** The total number of bytes produced. */
+    size_t total;
+    /** The sink receiving full chunks or NULL to write to the buffer only. */
+    kv_sink_t sink;
+    /** The context passed to the sink. */
+    void *pContext;
+    /** True if the sink reported an error. */
+    bool failed;
+} kv_json_writer_t;
+
+
+/** Pairs of decimal digits for 00 to 99, used to format two digits at once. */
+static char const kv_digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+
+/** Passes the collected output to the sink.
+
+   @param pWriter The writer to flush.
+ */
+static void kv_jsonFlush(kv_json_writer_t *pWriter) {
+    if ((NULL != pWriter->sink) && (pWriter->used > 0) && !pWriter->failed) {
+        pWriter->failed = pWriter->sink(pWriter->pContext, pWriter->pBuffer, pWriter->used);
+    }
+    pWriter->used = 0;
+} // end kv_jsonFlush()
+
+
+
+/** Appends data to the output.
+
+   @param pWriter The writer to append to.
+   @param pData The data to append.
+   @param length The number of bytes to append.
+ */
+static void kv_jsonPut(kv_json_writer_t *pWriter, char const *pData, size_t length) {
+    pWriter->total += length;
+
+    if (NULL == pWriter->sink) {
+        // Copy as much as fits, keeping room for the NUL terminator.
+        if (pWriter->used + 1 < pWriter->bufferSize) {
+            size_t n = pWriter->bufferSize - 1 - pWriter->used;
+
+            if (n > length) {
+                n = length;
+            }
+            memcpy(pWriter->pBuffer + pWriter->used, pData, n);
+            pWriter->used += n;
+        }
+        return;
+    }
+
+    while ((length > 0) && !pWriter->failed) {
+        size_t n = pWriter->bufferSize - pWriter->used;
+
+        if (n > length) {
+            n = length;
+        }
+        memcpy(pWriter->pBuffer + pWriter->used, pData, n);
+        pWriter->used += n;
+        pData += n;
+        length -= n;
+        if (pWriter->used == pWriter->bufferSize) {
+            kv_jsonFlush(pWriter);
+        }
+    }
+} // end kv_jsonPut()
+
+
+
+/** Terminates the output in the caller-supplied buffer.
+
+   @param pWriter The writer to terminate.
+   @return The total number of bytes produced.
+ */
+static size_t kv_jsonFinish(kv_json_writer_t *pWriter) {
+    if ((NULL == pWriter->sink) && (pWriter->bufferSize > 0)) {
+        pWriter->pBuffer[pWriter->used] = '\0';
+    }
+    return pWriter->total;
+} // end kv_jsonFinish()
+
+
+
+/** Formats an unsigned integer in decimal, two digits at a time.
+
+   @param pEnd The end of the buffer. The digits are placed immediately
+       before it.
+   @param value The value to format.
+   @return The start of the digits.
+ */
+static char *kv_formatDecimal(char *pEnd, uint64_t value) {
+    while (value >= 100) {
+        unsigned pair = (unsigned) (value % 100) * 2;
+
+        value /= 100;
+        *--pEnd = kv_digitPairs[pair + 1];
+        *--pEnd = kv_digitPairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned) value * 2;
+
+        *--pEnd = kv_digitPairs[pair + 1];
+        *--pEnd = kv_digitPairs[pair];
+    } else {
+        *--pEnd = (char) ('0' + value);
+    }
+
+    return pEnd;
+} // end kv_formatDecimal()
+
+
+
+/** Appends a signed integer in decimal.
+
+   @param pWriter The writer to append to.
+   @param value The value to append.
+ */
+static void kv_jsonPutInteger(kv_json_writer_t *pWriter, int64_t value) {
+    char digits[24];
+    char *pEnd = digits + sizeof(digits);
+    char *pStart;
+
+    if (value < 0) {
+        pStart = kv_formatDecimal(pEnd, 0 - (uint64_t) value);
+        *--pStart = '-';
+    } else {
+        pStart = kv_formatDecimal(pEnd, (uint64_t) value);
+    }
+    kv_jsonPut(pWriter, pStart, (size_t) (pEnd - pStart));
+} // end kv_jsonPutInteger()
+
+
+
+/** Appends a floating-point number.
+
+   Integral values are formatted without the printf() engine. Other values
+   use the shortest of 15 or 17 significant digits that converts back to
+   the same value. The decimal point is always '.', whatever the locale.
+
+   @param pWriter The writer to append to.
+   @param value The value to append.
+ */
+static void kv_jsonPutFloat(kv_json_writer_t *pWriter, double value) {
+    char digits[32];
+    char const *pDecimalPoint;
+    char *pPoint;
+
+    if (!isfinite(value)) {
+        // JSON has no representation for NaN or infinity.
+        kv_jsonPut(pWriter, "null", 4);
+        return;
+    }
+
+    if ((0.0 == value) && signbit(value)) {
+        // The integer path would lose the sign.
+        kv_jsonPut(pWriter, "-0.0", 4);
+        return;
+    }
+
+    if ((floor(value) == value) && (fabs(value) < 9007199254740992.0)) {
+        // Exactly representable as an integer.
+        kv_jsonPutInteger(pWriter, (int64_t) value);
+        kv_jsonPut(pWriter, ".0", 2);
+        return;
+    }
+
+    // snprintf() and strtod() agree on the decimal point of the locale,
+    // which is replaced only after the round trip.
+    (void) snprintf(digits, sizeof(digits), "%.15g", value);
+    if (strtod(digits, NULL) != value) {
+        (void) snprintf(digits, sizeof(digits), "%.17g", value);
+    }
+    pDecimalPoint = localeconv()->decimal_point;
+    if ((0 != strcmp(pDecimalPoint, ".")) && ('\0' != *pDecimalPoint)
+        && (NULL != (pPoint = strstr(digits, pDecimalPoint)))) {
+        size_t pointLength = strlen(pDecimalPoint);
+
+        *pPoint = '.';
+        memmove(pPoint + 1, pPoint + pointLength, strlen(pPoint + pointLength) + 1);
+    }
+    kv_jsonPut(pWriter, digits, strlen(digits));
+} // end kv_jsonPutFloat()
+
+
+
+/** Appends a quoted and escaped string.
+
+   @param pWriter The writer to append to.
+   @param pString The NUL-terminated string or NULL.
+ */
+static void kv_jsonPutString(kv_json_writer_t *pWriter, char const *pString) {
+    char const *pRun;
+
+    if (NULL == pString) {
+        kv_jsonPut(pWriter, "null", 4);
+        return;
+    }
+
+    kv_jsonPut(pWriter, "\"", 1);
+    for (pRun = pString; ; pString++) {
+        unsigned char c = (unsigned char) *pString;
+        char escape[6];
+
+        if ((c >= 0x20) && ('"' != c) && ('\\' != c)) {
+            // Most characters are copied in runs.
+            continue;
+        }
+
+        kv_jsonPut(pWriter, pRun, (size_t) (pString - pRun));
+        if ('\0' == c) {
+            break;
+        }
+        pRun = pString + 1;
+
+        escape[0] = '\\';
+        switch (c) {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b';  break;
+            case '\f': escape[1] = 'f';  break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                int8ToHex(&escape[4], c);
+                kv_jsonPut(pWriter, escape, 6);
+                continue;
+        } // switch c
+        kv_jsonPut(pWriter, escape, 2);
+    } // for pString
+    kv_jsonPut(pWriter, "\"", 1);
+} // end kv_jsonPutString()
+
+
+
+/** Appends a value of any type.
+
+   @param pWriter The writer to append to.
+   @param type The type of the value.
+   @param pValue The value to append.
+ */
+static void kv_jsonPutValue(kv_json_writer_t *pWriter,
+                            kv_value_type_t type, kv_value_t const *pValue) {
+    switch (type) {
+        case KV_VALUE_BOOL:
+            if (pValue->b) {
+                kv_jsonPut(pWriter, "true", 4);
+            } else {
+                kv_jsonPut(pWriter, "false", 5);
+            }
+            break;
+
+        case KV_VALUE_INTEGER:
+            kv_jsonPutInteger(pWriter, pValue->i);
+            break;
+
+        case KV_VALUE_INT64:
+            kv_jsonPutInteger(pWriter, pValue->i64);
+            break;
+
+        case KV_VALUE_FLOAT:
+            kv_jsonPutFloat(pWriter, pValue->f);
+            break;
+
+        case KV_VALUE_STRING:
+            kv_jsonPutString(pWriter, pValue->s);
+            break;
+
+        case KV_VALUE_BLOB: {
+            unsigned char const *pData = (unsigned char const *) pValue->blob.p;
+            size_t i;
+
+            kv_jsonPut(pWriter, "\"", 1);
+            for (i = 0; i < pValue->blob.length; i++) {
+                char hex[2];
+
+                int8ToHex(hex, pData[i]);
+                kv_jsonPut(pWriter, hex, 2);
+            }
+            kv_jsonPut(pWriter, "\"", 1);
+            break;
+        }
+
+        case KV_VALUE_POINTER: {
+            char hex[2 + 2 * sizeof(uintptr_t)];
+            uintptr_t address = (uintptr_t) pValue->p;
+            size_t i;
+
+            if (NULL == pValue->p) {
+                kv_jsonPut(pWriter, "null", 4);
+                break;
+            }
+            hex[0] = '0';
+            hex[1] = 'x';
+            for (i = sizeof(hex) - 1; i >= 2; i--, address >>= 4) {
+                hex[i] = nibbleToHexdigit((unsigned) (address & 0x0f));
+            }
+            kv_jsonPut(pWriter, "\"", 1);
+            kv_jsonPut(pWriter, hex, sizeof(hex));
+            kv_jsonPut(pWriter, "\"", 1);
+            break;
+        }
+
+        default:
+            // Unspecified or unknown types have no representation.
+            kv_jsonPut(pWriter, "null", 4);
+            break;
+    } // switch type
+} // end kv_jsonPutValue()
+
+
+
+/** Appends the collection as a flat JSON object.
+
+   @param pWriter The writer to append to.
+   @param pCollection The collection to append.
+ */
+static void kv_jsonPutCollection(kv_json_writer_t *pWriter, kv_collection_t const *pCollection) {
+    kv_iterator_t iterator;
+    kv_object_t *pObject;
+    bool first = true;
+
+    kv_jsonPut(pWriter, "{", 1);
+    for (pObject = kv_initializeIterator(&iterator, pCollection);
+         (NULL != pObject) && !pWriter->failed;
+         pObject = kv_iterateNext(&iterator)) {
+        if (!first) {
+            kv_jsonPut(pWriter, ",", 1);
+        }
+        first = false;
+        kv_jsonPutString(pWriter, pObject->key);
+        kv_jsonPut(pWriter, ":", 1);
+        kv_jsonPutValue(pWriter, pObject->type, &pObject->value);
+    }
+    kv_jsonPut(pWriter, "}", 1);
+} // end kv_jsonPutCollection()
+
+
+
+size_t kv_stringToJSON(char *pBuffer, size_t bufferSize, char const *pString) {
+    kv_json_writer_t writer;
+
+    assert((NULL != pBuffer) || (0 == bufferSize));
+
+    memset(&writer, 0, sizeof(writer));
+    writer.pBuffer = pBuffer;
+    writer.bufferSize = bufferSize;
+    kv_jsonPutString(&writer, pString);
+    return kv_jsonFinish(&writer);
+} // end kv_stringToJSON()
+
+
+
+size_t kv_valueToJSON(char *pBuffer, size_t bufferSize,
+                      kv_value_type_t type, kv_value_t const *pValue) {
+    kv_json_writer_t writer;
+
+    assert((NULL != pBuffer) || (0 == bufferSize));
+    assert(NULL != pValue);
+
+    memset(&writer, 0, sizeof(writer));
+    writer.pBuffer = pBuffer;
+    writer.bufferSize = bufferSize;
+    kv_jsonPutValue(&writer, type, pValue);
+    return kv_jsonFinish(&writer);
+} // end kv_valueToJSON()
+
+
+
+size_t kv_toJSON(kv_collection_t const *pCollection,
+                 char *pBuffer, size_t bufferSize) {
+    kv_json_writer_t writer;
+
+    assert(NULL != pCollection);
+    assert((NULL != pBuffer) || (0 == bufferSize));
+
+    memset(&writer, 0, sizeof(writer));
+    writer.pBuffer = pBuffer;
+    writer.bufferSize = bufferSize;
+    kv_jsonPutCollection(&writer, pCollection);
+    return kv_jsonFinish(&writer);
+} // end kv_toJSON()
+
+
+
+bool kv_writeJSON(kv_collection_t const *pCollection,
+                  kv_sink_t sink, void *pContext) {
+    kv_json_writer_t writer;
+    char chunk[KV_JSON_CHUNK_SIZE];
+
+    assert(NULL != pCollection);
+    assert(NULL != sink);
+
+    memset(&writer, 0, sizeof(writer));
+    writer.pBuffer = chunk;
+    writer.bufferSize = sizeof(chunk);
+    writer.sink = sink;
+    writer.pContext = pContext;
+    kv_jsonPutCollection(&writer, pCollection);
+    kv_jsonFlush(&writer);
+    return writer.failed;
+} // end kv_writeJSON()
+
+
+
+/** The state of the JSON parser. */
+typedef struct {
+    /** The start of the text, used to calculate line numbers. */
+    char *pStart;
+    /** The current position in the text. */
+    char *p;
+    /** The end of the text. */
+    char *pEnd;
+    /** The error description or NULL. */
+    kv_parse_error_t *pError;
+} kv_json_parser_t;
+
+
+
+/** Records an error at the current position of the parser.
+
+   @param pParser The parser.
+   @param message The description of the error.
+   @return Always true, so the result can be returned directly.
+ */
+static bool kv_jsonError(kv_json_parser_t *pParser, char const *message) {
+    if (NULL != pParser->pError) {
+        char const *p;
+        unsigned long line = 1;
+
+        for (p = pParser->pStart; p < pParser->p; p++) {
+            if ('\n' == *p) {
+                line++;
+            }
+        }
+        pParser->pError->line = line;
+        pParser->pError->message = message;
+    }
+    return true;
+} // end kv_jsonError()
+
+
+
+/** Skips whitespace.
+
+   @param pParser The parser.
+   @return Is there more text after the whitespace?
+ */
+static bool kv_jsonSkipWhitespace(kv_json_parser_t *pParser) {
+    while ((pParser->p < pParser->pEnd)
+        && ((' ' == *pParser->p) || ('\t' == *pParser->p)
+         || ('\n' == *pParser->p) || ('\r' == *pParser->p))) {
+        pParser->p++;
+    }
+    return pParser->p < pParser->pEnd;
+} // end kv_jsonSkipWhitespace()
+
+
+
+/** Parses four hexadecimal digits of a \\u escape.
+
+   @param p The first digit.
+   @return The value of the digits or -1 if they are not hexadecimal.
+ */
+static long kv_jsonParseHex4(char const *p) {
+    long value = 0;
+    int i;
+
+    for (i = 0; i < 4; i++, p++) {
+        value <<= 4;
+        if (('0' <= *p) && (*p <= '9')) {
+            value |= *p - '0';
+        } else if (('a' <= *p) && (*p <= 'f')) {
+            value |= *p - 'a' + 10;
+        } else if (('A' <= *p) && (*p <= 'F')) {
+            value |= *p - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+
+    return value;
+} // end kv_jsonParseHex4()
+
+
+
+/** Parses a string in place.
+
+   The string is unescaped and NUL-terminated within the text. Since each
+   escape sequence is at least as long as the characters it represents, the
+   result always fits.
+
+   @param pParser The parser, positioned at the opening quote.
+   @param ppString Returns the start of the unescaped string.
+   @return Did an error occur?
+ */
+static bool kv_jsonParseString(kv_json_parser_t *pParser, char **ppString) {
+    char *pRead, *pWrite;
+
+    assert('"' == *pParser->p);
+
+    pRead = pWrite = ++pParser->p;
+    *ppString = pWrite;
+    for (;;) {
+        unsigned char c;
+
+        if (pRead >= pParser->pEnd) {
+            pParser->p = pRead;
+            return kv_jsonError(pParser, "unterminated string");
+        }
+        c = (unsigned char) *pRead;
+        if ('"' == c) {
+            break;
+        }
+        if (c < 0x20) {
+            pParser->p = pRead;
+            return kv_jsonError(pParser, "control character in string");
+        }
+        if ('\\' != c) {
+            *pWrite++ = *pRead++;
+            continue;
+        }
+
+        // Escape sequence.
+        if (pRead + 1 >= pParser->pEnd) {
+            pParser->p = pRead;
+            return kv_jsonError(pParser, "unterminated string");
+        }
+        switch (pRead[1]) {
+            case '"':  *pWrite++ = '"';  pRead += 2; break;
+            case '\\': *pWrite++ = '\\'; pRead += 2; break;
+            case '/':  *pWrite++ = '/';  pRead += 2; break;
+            case 'b':  *pWrite++ = '\b'; pRead += 2; break;
+            case 'f':  *pWrite++ = '\f'; pRead += 2; break;
+            case 'n':  *pWrite++ = '\n'; pRead += 2; break;
+            case 'r':  *pWrite++ = '\r'; pRead += 2; break;
+            case 't':  *pWrite++ = '\t'; pRead += 2; break;
+            case 'u': {
+                long codepoint;
+
+                if ((pParser->pEnd - pRead < 6)
+                 || ((codepoint = kv_jsonParseHex4(pRead + 2)) < 0)) {
+                    pParser->p = pRead;
+                    return kv_jsonError(pParser, "invalid \\u escape");
+                }
+                pRead += 6;
+                if ((codepoint >= 0xd800) && (codepoint <= 0xdbff)) {
+                    // High surrogate, must be followed by a low surrogate.
+                    long low;
+
+                    if ((pParser->pEnd - pRead < 6) || ('\\' != pRead[0]) || ('u' != pRead[1])
+                     || ((low = kv_jsonParseHex4(pRead + 2)) < 0xdc00) || (low > 0xdfff)) {
+                        pParser->p = pRead;
+                        return kv_jsonError(pParser, "invalid surrogate pair");
+                    }
+                    pRead += 6;
+                    codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+                } else if ((codepoint >= 0xdc00) && (codepoint <= 0xdfff)) {
+                    pParser->p = pRead;
+                    return kv_jsonError(pParser, "invalid surrogate pair");
+                } else if (0 == codepoint) {
+                    pParser->p = pRead;
+                    return kv_jsonError(pParser, "NUL character in string");
+                }
+
+                // Encode as UTF-8.
+                if (codepoint < 0x80) {
+                    *pWrite++ = (char) codepoint;
+                } else if (codepoint < 0x800) {
+                    *pWrite++ = (char) (0xc0 | (codepoint >> 6));
+                    *pWrite++ = (char) (0x80 | (codepoint & 0x3f));
+                } else if (codepoint < 0x10000) {
+                    *pWrite++ = (char) (0xe0 | (codepoint >> 12));
+                    *pWrite++ = (char) (0x80 | ((codepoint >> 6) & 0x3f));
+                    *pWrite++ = (char) (0x80 | (codepoint & 0x3f));
+                } else {
+                    *pWrite++ = (char) (0xf0 | (codepoint >> 18));
+                    *pWrite++ = (char) (0x80 | ((codepoint >> 12) & 0x3f));
+                    *pWrite++ = (char) (0x80 | ((codepoint >> 6) & 0x3f));
+                    *pWrite++ = (char) (0x80 | (codepoint & 0x3f));
+                }
+                break;
+            }
+            default:
+                pParser->p = pRead;
+                return kv_jsonError(pParser, "invalid escape sequence");
+        } // switch escape
+    } // for
+
+    // pWrite never passes pRead, so the terminator replaces at most the quote.
+    *pWrite = '\0';
+    pParser->p = pRead + 1;
+    return false;
+} // end kv_jsonParseString()
+
+
+
+/** Checks if the text at the parser position is the given literal.
+
+   @param pParser The parser.
+   @param literal The literal to compare with.
+   @return Is the literal at the parser position? If so, it is skipped.
+ */
+static bool kv_jsonMatch(kv_json_parser_t *pParser, char const *literal) {
+    size_t length = strlen(literal);
+
+    if (((size_t) (pParser->pEnd - pParser->p) >= length)
+     && (memcmp(pParser->p, literal, length) == 0)) {
+        pParser->p += length;
+        return true;
+    }
+    return false;
+} // end kv_jsonMatch()
+
+
+
+/** Removes the object with the key if it stores a different type.
+
+   @param pCollection The collection.
+   @param pKey The key about to be inserted.
+   @param type The type about to be inserted.
+ */
+static void kv_jsonPrepareInsert(kv_collection_t *pCollection, char const *pKey, kv_value_type_t type) {
+    kv_object_t *pObject = kv_findObjectForKey(pCollection, pKey);
+
+    if ((NULL != pObject) && (type != pObject->type)) {
+        (void) kv_remove(pCollection, pKey);
+    }
+} // end kv_jsonPrepareInsert()
+
+
+
+/** Converts a validated JSON number with strtod(), which expects the
+   decimal point of the current locale instead of '.'.
+
+   This is also used by keyvalue_ini.c, whose numbers are validated the
+   same way.
+
+   @param pNumber The first character of the number.
+   @param length The number of characters in the number.
+   @param pValue Returns the value.
+   @return Did an error occur?
+ */
+bool kv_jsonStrtod(char const *pNumber, size_t length, double *pValue) {
+    char const *pDecimalPoint = localeconv()->decimal_point;
+    char buffer[KV_JSON_NUMBER_SIZE];
+    char *pCopy = buffer;
+    char *pEnd;
+    char const *pDot;
+    size_t pointLength, copyLength;
+    bool error;
+
+    pDot = memchr(pNumber, '.', length);
+    if ((NULL == pDot) || (0 == strcmp(pDecimalPoint, "."))) {
+        *pValue = strtod(pNumber, &pEnd);
+        return pEnd != pNumber + length;
+    }
+
+    // Replace '.' with the decimal point of the locale.
+    pointLength = strlen(pDecimalPoint);
+    copyLength = length - 1 + pointLength;
+    if ((copyLength >= sizeof(buffer))
+        && (NULL == (pCopy = (char *) malloc(copyLength + 1)))) {
+        return true;
+    }
+    memcpy(pCopy, pNumber, (size_t) (pDot - pNumber));
+    memcpy(pCopy + (pDot - pNumber), pDecimalPoint, pointLength);
+    memcpy(pCopy + (pDot - pNumber) + pointLength, pDot + 1, length - (size_t) (pDot - pNumber) - 1);
+    pCopy[copyLength] = '\0';
+
+    *pValue = strtod(pCopy, &pEnd);
+    error = (pEnd != pCopy + copyLength);
+    if (buffer != pCopy) {
+        free(pCopy);
+    }
+    return error;
+} // end kv_jsonStrtod()
+
+
+
+/** Parses a number and inserts it into the collection.
+
+   @param pParser The parser, positioned at the first character of the number.
+   @param pCollection The collection.
+   @param pKey The key of the number.
+   @param ppObject Returns the object containing the number or NULL if out
+       of memory.
+   @return Did an error occur?
+ */
+static bool kv_jsonParseNumber(kv_json_parser_t *pParser,
+                               kv_collection_t *pCollection, char const *pKey,
+                               kv_object_t **ppObject) {
+    char *pNumber = pParser->p;
+    char *p = pNumber;
+    bool negative = false, integral = true, overflow = false;
+    uint64_t value = 0;
+
+    if ('-' == *p) {
+        negative = true;
+        p++;
+    }
+    if ((p >= pParser->pEnd) || (*p < '0') || (*p > '9')) {
+        return kv_jsonError(pParser, "invalid number");
+    }
+    if ('0' == *p) {
+        p++;
+    } else {
+        while ((p < pParser->pEnd) && ('0' <= *p) && (*p <= '9')) {
+            unsigned digit = (unsigned) (*p++ - '0');
+
+            if (value > (UINT64_C(0x8000000000000000) - digit) / 10) {
+                overflow = true;
+            } else {
+                value = value * 10 + digit;
+            }
+        }
+    }
+    if ((p < pParser->pEnd) && ('.' == *p)) {
+        integral = false;
+        p++;
+        if ((p >= pParser->pEnd) || (*p < '0') || (*p > '9')) {
+            pParser->p = p;
+            return kv_jsonError(pParser, "invalid number");
+        }
+        while ((p < pParser->pEnd) && ('0' <= *p) && (*p <= '9')) {
+            p++;
+        }
+    }
+    if ((p < pParser->pEnd) && (('e' == *p) || ('E' == *p))) {
+        integral = false;
+        p++;
+        if ((p < pParser->pEnd) && (('+' == *p) || ('-' == *p))) {
+            p++;
+        }
+        if ((p >= pParser->pEnd) || (*p < '0') || (*p > '9')) {
+            pParser->p = p;
+            return kv_jsonError(pParser, "invalid number");
+        }
+        while ((p < pParser->pEnd) && ('0' <= *p) && (*p <= '9')) {
+            p++;
+        }
+    }
+    if (p >= pParser->pEnd) {
+        // The object must still be closed, this also keeps strtod() from
+        // reading beyond the end of the text.
+        pParser->p = p;
+        return kv_jsonError(pParser, "unexpected end of text");
+    }
+    pParser->p = p;
+
+    if (!integral || overflow || (!negative && (value > (uint64_t) INT64_MAX))) {
+        double f;
+
+        if (kv_jsonStrtod(pNumber, (size_t) (p - pNumber), &f)) {
+            return kv_jsonError(pParser, "invalid number");
+        }
+        kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_FLOAT);
+        *ppObject = kv_insertFloat(pCollection, pKey, f);
+    } else {
+        int64_t i = negative ? (int64_t) (0 - value) : (int64_t) value;
+
+        if ((i >= INT_MIN) && (i <= INT_MAX)) {
+            kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_INTEGER);
+            *ppObject = kv_insertInt(pCollection, pKey, (int) i);
+        } else {
+            kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_INT64);
+            *ppObject = kv_insertInt64(pCollection, pKey, i);
+        }
+    }
+
+    return false;
+} // end kv_jsonParseNumber()
+
+
+
+bool kv_fromJSON(kv_collection_t *pCollection,
+                 char *pText, size_t length,
+                 bool borrowStrings,
+                 kv_parse_error_t *pError) {
+    kv_json_parser_t parser;
+
+    assert(NULL != pCollection);
+    assert((NULL != pText) || (0 == length));
+
+    parser.pStart = parser.p = pText;
+    parser.pEnd = pText + length;
+    parser.pError = pError;
+    if (NULL != pError) {
+        pError->line = 0;
+        pError->message = NULL;
+    }
+
+    if (!kv_jsonSkipWhitespace(&parser) || ('{' != *parser.p)) {
+        return kv_jsonError(&parser, "expected '{'");
+    }
+    parser.p++;
+
+    if (!kv_jsonSkipWhitespace(&parser)) {
+        return kv_jsonError(&parser, "unexpected end of text");
+    }
+    if ('}' != *parser.p) {
+        for (;;) {
+            char *pKey;
+            kv_object_t *pObject = NULL;
+
+            // Member name.
+            if (!kv_jsonSkipWhitespace(&parser) || ('"' != *parser.p)) {
+                return kv_jsonError(&parser, "expected member name");
+            }
+            if (kv_jsonParseString(&parser, &pKey)) {
+                return true;
+            }
+            if (!kv_jsonSkipWhitespace(&parser) || (':' != *parser.p)) {
+                return kv_jsonError(&parser, "expected ':'");
+            }
+            parser.p++;
+
+            // Member value.
+            if (!kv_jsonSkipWhitespace(&parser)) {
+                return kv_jsonError(&parser, "unexpected end of text");
+            }
+            switch (*parser.p) {
+                case '"': {
+                    char *pString;
+
+                    if (kv_jsonParseString(&parser, &pString)) {
+                        return true;
+                    }
+                    kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_STRING);
+                    if (borrowStrings) {
+                        pObject = kv_insertBorrowedString(pCollection, pKey, pString);
+                    } else {
+                        pObject = kv_insertString(pCollection, pKey, pString);
+                        if ((NULL != pObject) && (NULL == pObject->value.s)) {
+                            pObject = NULL;
+                        }
+                    }
+                    break;
+                }
+
+                case '{':
+                case '[':
+                    return kv_jsonError(&parser, "nested values are not supported");
+
+                default:
+                    if (kv_jsonMatch(&parser, "true")) {
+                        kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_BOOL);
+                        pObject = kv_insertBool(pCollection, pKey, true);
+                    } else if (kv_jsonMatch(&parser, "false")) {
+                        kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_BOOL);
+                        pObject = kv_insertBool(pCollection, pKey, false);
+                    } else if (kv_jsonMatch(&parser, "null")) {
+                        kv_jsonPrepareInsert(pCollection, pKey, KV_VALUE_POINTER);
+                        pObject = kv_insertPointer(pCollection, pKey, NULL);
+                    } else if (kv_jsonParseNumber(&parser, pCollection, pKey, &pObject)) {
+                        return true;
+                    }
+                    break;
+            } // switch value
+            if (NULL == pObject) {
+                return kv_jsonError(&parser, "out of memory");
+            }
+
+            // Separator or end of object.
+            if (!kv_jsonSkipWhitespace(&parser)) {
+                return kv_jsonError(&parser, "unexpected end of text");
+            }
+            if ('}' == *parser.p) {
+                break;
+            }
+            if (',' != *parser.p) {
+                return kv_jsonError(&parser, "expected ',' or '}'");
+            }
+            parser.p++;
+        } // for members
+    }
+    parser.p++;
+
+    // Only whitespace may follow the object.
+    if (kv_jsonSkipWhitespace(&parser)) {
+        return kv_jsonError(&parser, "unexpected text after object");
+    }
+    return false;
+} // end kv_fromJSON()
@@ -51,7 +51,11 @@
 
 
 #include <assert.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifdef _WIN32
 #include <errno.h>
 #else
@@ -60,139 +64,2326 @@
 #include "hex.h"
 #include "logging.h"
 
+#if LOGGING_THREADS
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif // LOGGING_THREADS
+
+// Memory-mapped log files need POSIX mmap().
+#if !defined(_WIN32) && !FTR_EMBEDDED
+#define LOG_MAPPED_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define LOG_MAPPED_FILES 0
+#endif // !_WIN32 && !FTR_EMBEDDED
+
+// The flight recorder dumps its ring using the POSIX I/O functions, which
+// are async-signal-safe.
+#if !FTR_EMBEDDED
+#define LOG_FLIGHT_RECORDER 1
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // !_WIN32
+#else
+#define LOG_FLIGHT_RECORDER 0
+#endif // !FTR_EMBEDDED
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif // !O_BINARY
+
+// The functions themselves are defined here, not the level check around them.
+#undef log_logData
+#undef log_logDataLimited
+
 #ifdef _MSC_VER
 // Disable warnings for functions VS C considers deprecated.
 #pragma warning(disable: 4996)
 #endif // _MSC_VER
 
-#define FTR_LOG_GLOBAL_BUFFER
-#define FTR_LOG_BUFFER_SIZE 4096
+#ifdef _WIN32
+// Provided by winsix_clock_gettime.c.
+extern int clock_gettime(int option, struct timespec *pTS);
+#define CLOCK_REALTIME 0
+#endif // _WIN32
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC CLOCK_REALTIME
+#endif // !CLOCK_MONOTONIC
+
+#define FTR_LOG_BUFFER_SIZE 4096
+
+#ifdef _WIN32
+#define USE_CRLF true
+#else
+#define USE_CRLF false
+#endif // !_WIN32
+
+#if defined(_MSC_VER)
+#define LOG_THREAD_LOCAL __declspec(thread)
+#elif FTR_EMBEDDED
+#define LOG_THREAD_LOCAL
+#else
+#define LOG_THREAD_LOCAL __thread
+#endif // !_MSC_VER
+
+/** Each thread formats its messages into this buffer. */
+static LOG_THREAD_LOCAL char logRenderBuffer[FTR_LOG_BUFFER_SIZE];
+/** Each thread assembles the line built by log_logMessageStart() and
+ * log_logMessageContinue() in this buffer, so it is output as one record.
+ */
+static LOG_THREAD_LOCAL char logLineBuffer[FTR_LOG_BUFFER_SIZE];
+/** The number of bytes in logLineBuffer. */
+static LOG_THREAD_LOCAL size_t logLineLength = 0;
+/** The level of the line in logLineBuffer. */
+static LOG_THREAD_LOCAL log_level_t logLineLevel = LOGLEVEL_NONE;
+/** The length of the timestamp at the start of logLineBuffer. */
+static LOG_THREAD_LOCAL size_t logLineTimestampLength = 0;
+
+/** The length of the timestamp "YYYY-MM-DD HH:MM:SS.uuuuuu " of a line. */
+#define LOG_TIMESTAMP_LENGTH 27
+/** The length of the part of the timestamp that changes once per second. */
+#define LOG_TIMESTAMP_SECOND_LENGTH 20
+/** The second of the timestamp in logTimestampSecondText. */
+static LOG_THREAD_LOCAL time_t logTimestampSecond = 0;
+/** The date and time up to the second, formatted once per second. */
+static LOG_THREAD_LOCAL char logTimestampSecondText[LOG_TIMESTAMP_SECOND_LENGTH + 1];
+/** The decimal digits of all numbers from 0 to 99. */
+static char const logDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+/** If true, each line starts with a timestamp. */
+static LOGGING_ATOMIC(bool) logTimestamps = false;
+
+/** If true, sampled messages tell how many messages were skipped. */
+static LOGGING_ATOMIC(bool) logSamplingSummary = false;
+
+/** If true, consecutive identical records are collapsed. */
+static LOGGING_ATOMIC(bool) logSuppressDuplicates = false;
+/** The last record output while duplicates are suppressed. Records are
+ * compared by their length and hash, ignoring the timestamp.
+ */
+static struct {
+    /** The level of the record, #LOGLEVEL_NONE if there is none. */
+    log_level_t level;
+    /** The number of bytes in the record. */
+    size_t length;
+    /** The hash of the record. */
+    uint64_t hash;
+    /** The number of times the record was repeated since it was output. */
+    unsigned long nrRepeats;
+} logLastRecord = { LOGLEVEL_NONE, 0, 0, 0 };
+#if LOGGING_THREADS
+/** Protects logLastRecord. */
+static pthread_mutex_t logLastRecordMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif // LOGGING_THREADS
+
+/** The file handle of the logfile to use or NULL if no file is currently in use.
+ *
+ * Threads announce their use of the handle in logFileUsers, so the handle
+ * can be exchanged without a lock on the logging path: whoever replaces
+ * the handle advances logFileEpoch and waits until all users of the
+ * previous epoch are done before closing the old file. New users are
+ * counted for the new epoch, so they can not starve the wait.
+ */
+static LOGGING_ATOMIC(FILE *) logFileHandle = NULL;
+/** A log file written through a shared memory mapping.
+
+    The whole window is mapped when the file is opened, so the address of
+    the mapping never changes. The file is extended in chunks as the tail
+    advances; bytes beyond the end of the file must never be touched.
+ */
+typedef struct {
+    /** The descriptor of the file. */
+    int fd;
+    /** The start of the mapping. */
+    char *pBase;
+    /** The size of the mapping, the largest size the file can reach. */
+    size_t windowSize;
+    /** The current size of the file. */
+    LOGGING_ATOMIC(size_t) fileSize;
+    /** The offset the next message is written to. */
+    LOGGING_ATOMIC(size_t) tail;
+#if LOGGING_THREADS
+    /** Serializes extending the file. */
+    pthread_mutex_t mutex;
+#endif // LOGGING_THREADS
+} log_mapping_t;
+
+/** The size of the mapping if none is specified. */
+#define LOG_MAPPED_WINDOW_SIZE ((sizeof(void *) > 4) ? ((size_t) 1 << 30) : ((size_t) 64 << 20))
+/** The mapped log file is extended in steps of this size. */
+#define LOG_MAPPED_CHUNK_SIZE ((size_t) 4 << 20)
+
+/** The memory-mapped log file or NULL if none is in use. It is protected
+ * just like logFileHandle. At most one of both is in use.
+ */
+static LOGGING_ATOMIC(log_mapping_t *) logMapping = NULL;
+/** The number of bytes in the current log file. */
+static LOGGING_ATOMIC(unsigned long) logFileBytes = 0;
+/** The name of the current log file, to open it again on rotation, or NULL. */
+static char *logFileName = NULL;
+/** Was the current log file opened by #log_openMappedLogfile? */
+static bool logFileIsMapped = false;
+/** The maximum size passed to #log_openMappedLogfile. */
+static size_t logFileMappedSize = 0;
+/** Selects the counter in logFileUsers new users increment. */
+static LOGGING_ATOMIC(unsigned) logFileEpoch = 0;
+/** The number of threads using logFileHandle, by epoch. */
+static LOGGING_ATOMIC(unsigned) logFileUsers[2];
+#if LOGGING_THREADS
+/** Serializes opening and closing the log file. */
+static pthread_mutex_t logFileMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif // LOGGING_THREADS
+/** All message of the specified or higher level will be output to the log
+ * file (if open).
+ */
+static LOGGING_ATOMIC(log_level_t) logLevelFile = LOGLEVEL_INFO;
+/** All message of the specified or higher level will be output to stderr. */
+static LOGGING_ATOMIC(log_level_t) logLevelStderr = LOGLEVEL_ERROR;
+/** All message of the specified or higher level will be output to stdout. */
+static LOGGING_ATOMIC(log_level_t) logLevelStdout = LOGLEVEL_WARNING;
+/** If true, messages sent to stderr will be suppressed on stdout. */
+static LOGGING_ATOMIC(bool) logSuppressStdout = true;
+/** The lowest level of messages without a category that is output.
+ * Such messages below this level are discarded before they are formatted.
+ */
+static LOGGING_ATOMIC(log_level_t) logMinimumLevel = LOGLEVEL_WARNING;
+/** The lowest level accepted by any channel, including the flight recorder.
+ * Messages of a category below this level are discarded before they are
+ * formatted.
+ */
+static LOGGING_ATOMIC(log_level_t) logAcceptedLevel = LOGLEVEL_WARNING;
+/** The level of messages without a category, see #log_setUncategorizedLevel. */
+static LOGGING_ATOMIC(log_level_t) logUncategorizedLevel = LOGLEVEL_NONE;
+/** The lowest level accepted by any channel except the flight recorder. */
+static LOGGING_ATOMIC(log_level_t) logChannelMinimumLevel = LOGLEVEL_WARNING;
+
+/** When the log file is flushed. */
+static LOGGING_ATOMIC(log_flush_policy_t) logFlushPolicy = LOG_FLUSH_EVERY_MESSAGE;
+/** The parameter of the flush policy. */
+static LOGGING_ATOMIC(unsigned long) logFlushParameter = 0;
+/** The number of bytes written to the log file since it was last flushed
+ * (#LOG_FLUSH_BYTES only).
+ */
+static LOGGING_ATOMIC(unsigned long) logUnflushedBytes = 0;
+/** Was the log file written since it was last flushed (#LOG_FLUSH_INTERVAL
+ * only)?
+ */
+static LOGGING_ATOMIC(bool) logFileDirty = false;
+
+/** The text prepended to each message, indexed by level. */
+static char const * const logLevelPrefixes[] = {
+    NULL,               // LOGLEVEL_NONE
+    "DEBUG3: ",         // LOGLEVEL_DEBUG3
+    "DEBUG2: ",         // LOGLEVEL_DEBUG2
+    "DEBUG1: ",         // LOGLEVEL_DEBUG1
+    "DEBUG: ",          // LOGLEVEL_DEBUG
+    "INFO: ",           // LOGLEVEL_INFO
+    "WARNING: ",        // LOGLEVEL_WARNING
+    "ERROR: ",          // LOGLEVEL_ERROR
+    "FATAL ERROR: ",    // LOGLEVEL_FATAL
+    "ALWAYS: "          // LOGLEVEL_ALWAYS
+};
+
+
+#if LOGGING_THREADS
+/** The number of bytes in a slot of the queue. */
+#define LOG_QUEUE_SLOT_SIZE 128
+/** The number of text bytes a slot of the queue can hold. */
+#define LOG_QUEUE_TEXT_SIZE (LOG_QUEUE_SLOT_SIZE - 16)
+/** The smallest queue, its slots hold 7 KiB of text. */
+#define LOG_QUEUE_MINIMUM_SIZE 8192
+/** Ends a record too long for the whole queue. */
+#define LOG_QUEUE_TRUNCATED " [truncated]\n"
+/** The longest time the writer sleeps before checking the queue, in ns. */
+#define LOG_WRITER_IDLE_NS 100000000L
+
+/** A slot in the queue of the asynchronous writer.
+
+    A record occupies as many consecutive slots as its text requires. The
+    sequence number tells who owns the slot: if it equals the position of
+    the slot, a producer may fill it; if it equals position + 1, the writer
+    may read it. Only the first slot of a record carries length and level.
+ */
+typedef struct {
+    /** The sequence number of the slot. */
+    atomic_size_t sequence;
+    /** The total number of text bytes in the record. */
+    uint32_t length;
+    /** The level of the record. */
+    uint32_t level;
+    /** The text stored in this slot. */
+    char text[LOG_QUEUE_TEXT_SIZE];
+} log_queue_slot_t;
+
+/** The state of the asynchronous writer.
+
+    The queue is a bounded multi-producer, single-consumer queue after
+    Dmitry Vyukov. Producers claim slots with a CAS on enqueuePosition, the
+    writer is the only one advancing dequeuePosition. The positions are
+    kept on separate cache lines to avoid false sharing.
+ */
+static struct {
+    /** The slots, NULL if asynchronous logging is not active. */
+    log_queue_slot_t *pSlots;
+    /** The number of slots - 1, the number of slots is a power of 2. */
+    size_t mask;
+    /** Receives the text of the record the writer takes from the queue. */
+    char *pRecord;
+    /** What to do if the queue is full. */
+    log_queue_policy_t policy;
+    /** Is the writer running? Checked by every message. */
+    atomic_bool active;
+    char padding1[64];
+    /** The next position a producer will claim. */
+    atomic_size_t enqueuePosition;
+    char padding2[64];
+    /** The next position the writer will read. */
+    atomic_size_t dequeuePosition;
+    /** All records before this position have been written. */
+    atomic_size_t writtenPosition;
+    /** Is the writer waiting for the condition? */
+    atomic_bool sleeping;
+    /** Shall the writer terminate once the queue is empty? */
+    atomic_bool stop;
+    char padding3[64];
+    /** The number of messages dropped because the queue was full. */
+    atomic_ulong nrDropped;
+    /** The writer thread. */
+    pthread_t thread;
+    /** Protects the condition the writer sleeps on. */
+    pthread_mutex_t mutex;
+    /** Signalled when the writer shall wake up. */
+    pthread_cond_t condition;
+} logAsync = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER
+};
+
+/** The timer thread flushing the log file for #LOG_FLUSH_INTERVAL. */
+static struct {
+    /** Is the thread running? */
+    bool running;
+    /** Shall the thread terminate? */
+    bool stop;
+    /** The thread. */
+    pthread_t thread;
+    /** Protects stop. */
+    pthread_mutex_t mutex;
+    /** Signalled to stop the thread. */
+    pthread_cond_t condition;
+} logFlusher = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER
+};
+
+/** The thread rotating the log file, see #log_setRotation. */
+static struct {
+    /** Is the thread running? */
+    bool running;
+    /** Shall the thread terminate? */
+    bool stop;
+    /** Has a writer seen the file reach its maximum size? */
+    bool pending;
+    /** Rotate when the file reaches this size, 0 if not. */
+    LOGGING_ATOMIC(unsigned long) maximumBytes;
+    /** Rotate after this many seconds, 0 if not. */
+    unsigned long interval;
+    /** The number of rotated files kept. */
+    unsigned nrKeptFiles;
+    /** The thread. */
+    pthread_t thread;
+    /** Held while the log file is rotated, opened or closed. */
+    pthread_mutex_t mutex;
+    /** Protects stop and pending, never held while waiting for others. */
+    pthread_mutex_t wakeMutex;
+    /** Signalled when the file is due for rotation or the thread shall stop. */
+    pthread_cond_t condition;
+} logRotation = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wakeMutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER
+};
+#endif // LOGGING_THREADS
+
+/** The flight recorder, see #log_startFlightRecorder.
+
+    Writers claim space in the ring by advancing the free-running offset
+    head, so recording takes no lock. The ring is used like the log file
+    (see logFileHandle), so it can be freed once no thread uses it.
+ */
+static struct {
+    /** The ring or NULL if the flight recorder is not running. */
+    LOGGING_ATOMIC(char *) pRing;
+    /** The size of the ring - 1, the size is a power of 2. */
+    size_t mask;
+    /** The number of bytes ever written to the ring. */
+    LOGGING_ATOMIC(size_t) head;
+    /** All records of this or a higher level are recorded. */
+    LOGGING_ATOMIC(log_level_t) level;
+    /** Is the ring being dumped? */
+    LOGGING_ATOMIC(bool) dumping;
+    /** The name of the dump file. */
+    char *filename;
+} logRecorder = { NULL, 0, 0, LOGLEVEL_NONE, false, NULL };
+
+
+
+/** Announces the use of the log file by the calling thread.
+
+    The memory-mapped log file (logMapping) may be used until the
+    matching call of #log_releaseLogfile, too.
+
+    @param ppFile Receives the log file or NULL if none is open.
+    @return The epoch to pass to #log_releaseLogfile.
+ */
+static unsigned log_acquireLogfile(FILE **ppFile) {
+    unsigned epoch;
+
+    for (;;) {
+        epoch = logFileEpoch;
+        logFileUsers[epoch & 1]++;
+        if (epoch == logFileEpoch) {
+            break;
+        }
+        // The handle is being exchanged, count this use for the new epoch.
+        logFileUsers[epoch & 1]--;
+    }
+
+    *ppFile = logFileHandle;
+    return epoch;
+} // log_acquireLogfile()
+
+
+
+/** Ends the use of the log file announced by #log_acquireLogfile.
+
+    @param epoch The value returned by #log_acquireLogfile.
+ */
+static void log_releaseLogfile(unsigned epoch) {
+    logFileUsers[epoch & 1]--;
+} // log_releaseLogfile()
+
+
+
+/** Waits until no thread uses what it acquired by #log_acquireLogfile
+    before the call.
+
+    The caller must hold logFileMutex.
+ */
+static void log_waitForLogfileUsers(void) {
+    unsigned epoch = logFileEpoch++;
+
+    while (0 != logFileUsers[epoch & 1]) {
+#if LOGGING_THREADS
+        (void) sched_yield();
+#endif // LOGGING_THREADS
+    }
+} // log_waitForLogfileUsers()
+
+
+
+/** Replaces the log file, waiting until no thread uses the old one.
+
+    The caller must hold logFileMutex.
+
+    @param pFile The new log file or NULL.
+    @param pMapping The new memory-mapped log file or NULL.
+    @param ppOldMapping Receives the old memory-mapped log file, which is
+        no longer in use, or NULL.
+    @return The old log file, which is no longer in use, or NULL.
+ */
+static FILE *log_exchangeLogfile(FILE *pFile, log_mapping_t *pMapping,
+                                 log_mapping_t **ppOldMapping) {
+    FILE *pOldFile;
+
+#if LOGGING_THREADS
+    pOldFile = atomic_exchange(&logFileHandle, pFile);
+    *ppOldMapping = atomic_exchange(&logMapping, pMapping);
+#else
+    pOldFile = logFileHandle;
+    logFileHandle = pFile;
+    *ppOldMapping = logMapping;
+    logMapping = pMapping;
+#endif // !LOGGING_THREADS
+
+    log_waitForLogfileUsers();
+
+    return pOldFile;
+} // log_exchangeLogfile()
+
+
+
+#if LOG_FLIGHT_RECORDER
+/** Writes a buffer completely to a file descriptor. Async-signal-safe.
+
+    @param fd The file descriptor.
+    @param pData The data to write.
+    @param length The number of bytes to write.
+    @return Did an error occur?
+ */
+static bool log_writeAll(int fd, char const *pData, size_t length) {
+    while (length > 0) {
+#ifdef _WIN32
+        int written = write(fd, pData, (unsigned) length);
+#else
+        ssize_t written = write(fd, pData, length);
+#endif // !_WIN32
+
+        if (written <= 0) {
+            if ((written < 0) && (EINTR == errno)) {
+                continue;
+            }
+            return true;
+        }
+        pData += written;
+        length -= (size_t) written;
+    }
+    return false;
+} // log_writeAll()
+
+
+
+/** Writes the ring of the flight recorder to the dump file, oldest record
+    first. Async-signal-safe.
+
+    @param pRing The ring.
+    @return Did an error occur?
+ */
+static bool log_dumpRing(char const *pRing) {
+    size_t head = logRecorder.head, size = logRecorder.mask + 1;
+    size_t start = 0, length = head, first;
+    bool failed;
+    int fd;
+
+    if (head > size) {
+        // The ring has wrapped around: skip the partially overwritten
+        // record at its start.
+        start = head & logRecorder.mask;
+        length = size;
+        while ((length > 0) && ('\n' != pRing[start])) {
+            start = (start + 1) & logRecorder.mask;
+            length--;
+        }
+        if (length > 0) {
+            start = (start + 1) & logRecorder.mask;
+            length--;
+        }
+    }
+
+    if ((fd = open(logRecorder.filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644)) < 0) {
+        return true;
+    }
+    first = size - start;
+    if (first > length) {
+        first = length;
+    }
+    failed = log_writeAll(fd, pRing + start, first);
+    failed |= log_writeAll(fd, pRing, length - first);
+    failed |= (close(fd) != 0);
+    return failed;
+} // log_dumpRing()
+
+
+
+/** Dumps the ring of the flight recorder unless another dump is in
+    progress. Async-signal-safe.
+
+    @param pRing The ring.
+    @return Did an error occur?
+ */
+static bool log_dumpRingOnce(char const *pRing) {
+    bool failed;
+
+#if LOGGING_THREADS
+    if (atomic_exchange(&logRecorder.dumping, true)) {
+        return true;
+    }
+#else
+    if (logRecorder.dumping) {
+        return true;
+    }
+    logRecorder.dumping = true;
+#endif // !LOGGING_THREADS
+    failed = log_dumpRing(pRing);
+    logRecorder.dumping = false;
+    return failed;
+} // log_dumpRingOnce()
+
+
+
+/** Copies a record into the ring of the flight recorder and dumps the ring
+    if the record is fatal.
+
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+ */
+static void log_recordFlight(log_level_t level, char const *pText, size_t length) {
+    FILE *pFile;
+    unsigned epoch = log_acquireLogfile(&pFile);
+    char *pRing = logRecorder.pRing;
+
+    if ((NULL != pRing) && (level >= logRecorder.level)) {
+        size_t size = logRecorder.mask + 1, start, first;
+
+        if (length > size) {
+            // Keep the end of an overly long record.
+            pText += length - size;
+            length = size;
+        }
+#if LOGGING_THREADS
+        start = atomic_fetch_add_explicit(&logRecorder.head, length, memory_order_relaxed);
+#else
+        start = logRecorder.head;
+        logRecorder.head += length;
+#endif // !LOGGING_THREADS
+        start &= logRecorder.mask;
+        first = size - start;
+        if (first > length) {
+            first = length;
+        }
+        memcpy(pRing + start, pText, first);
+        memcpy(pRing, pText + first, length - first);
+    }
+    if ((NULL != pRing) && (LOGLEVEL_FATAL == level)) {
+        (void) log_dumpRingOnce(pRing);
+    }
+
+    log_releaseLogfile(epoch);
+} // log_recordFlight()
+#endif // LOG_FLIGHT_RECORDER
+
+
+
+/** Determines the lowest level accepted by any channel and the lowest
+    level of messages without a category that is output.
+
+    Must be called whenever a level changes or the log file is opened or
+    closed.
+ */
+static void log_updateMinimumLevel(void) {
+    log_level_t minimumLevel = LOGLEVEL_ALWAYS;
+
+    if (logLevelStderr < minimumLevel) {
+        minimumLevel = logLevelStderr;
+    }
+    if (logLevelStdout < minimumLevel) {
+        minimumLevel = logLevelStdout;
+    }
+    if (((NULL != logFileHandle) || (NULL != logMapping)) && (logLevelFile < minimumLevel)) {
+        minimumLevel = logLevelFile;
+    }
+    logChannelMinimumLevel = minimumLevel;
+    if ((NULL != logRecorder.pRing) && (logRecorder.level < minimumLevel)) {
+        minimumLevel = logRecorder.level;
+    }
+    logAcceptedLevel = minimumLevel;
+    if (logUncategorizedLevel > minimumLevel) {
+        minimumLevel = logUncategorizedLevel;
+    }
+    logMinimumLevel = minimumLevel;
+} // log_updateMinimumLevel()
+
+
+
+/** Flushes the log file if the flush policy demands it after a record.
+
+    @param pFile The log file.
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @param inBatch Was the record written as part of a batch by the
+        asynchronous writer? The writer flushes after each batch instead of
+        after each message.
+ */
+static void log_applyFlushPolicy(FILE *pFile,
+                                 log_level_t level, char const *pText, size_t length,
+                                 bool inBatch) {
+    switch (logFlushPolicy) {
+        case LOG_FLUSH_EVERY_MESSAGE:
+            if (!inBatch && (length > 0) && ('\n' == pText[length - 1])) {
+                (void) fflush(pFile);
+            }
+            break;
+        case LOG_FLUSH_BYTES:
+            if ((logUnflushedBytes += length) >= logFlushParameter) {
+                logUnflushedBytes = 0;
+                (void) fflush(pFile);
+            }
+            break;
+        case LOG_FLUSH_INTERVAL:
+            logFileDirty = true;
+            break;
+        case LOG_FLUSH_ERROR:
+            if (level >= LOGLEVEL_ERROR) {
+                (void) fflush(pFile);
+            }
+            break;
+        default:
+            assert(false);
+            break;
+    } // switch logFlushPolicy
+} // log_applyFlushPolicy()
+
+
+
+#if LOG_MAPPED_FILES
+/** Extends the memory-mapped log file to hold the given number of bytes.
+
+    @param pMapping The memory-mapped log file.
+    @param needed The number of bytes the file must hold.
+    @return Did an error occur?
+    @retval false The file holds at least the given number of bytes.
+    @retval true The file could not be extended.
+ */
+static bool log_extendMapping(log_mapping_t *pMapping, size_t needed) {
+    bool failed = false;
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&pMapping->mutex);
+#endif // LOGGING_THREADS
+    if (pMapping->fileSize < needed) {
+        size_t size = (needed + LOG_MAPPED_CHUNK_SIZE - 1) / LOG_MAPPED_CHUNK_SIZE * LOG_MAPPED_CHUNK_SIZE;
+
+        if (size > pMapping->windowSize) {
+            size = pMapping->windowSize;
+        }
+        if (ftruncate(pMapping->fd, (off_t) size) != 0) {
+            failed = true;
+        } else {
+            pMapping->fileSize = size;
+        }
+    }
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&pMapping->mutex);
+#endif // LOGGING_THREADS
+
+    return failed;
+} // log_extendMapping()
+
+
+
+/** Copies a record into the memory-mapped log file.
+
+    Only when the record reaches beyond the end of the file is the file
+    extended, otherwise no system call is made. A record that does not fit
+    into the mapping is discarded.
+
+    @param pMapping The memory-mapped log file.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @return Was the record discarded?
+ */
+static bool log_writeMapping(log_mapping_t *pMapping, char const *pText, size_t length) {
+    size_t offset;
+
+#if LOGGING_THREADS
+    offset = atomic_fetch_add(&pMapping->tail, length);
+#else
+    offset = pMapping->tail;
+    pMapping->tail += length;
+#endif // !LOGGING_THREADS
+
+    if ((offset > pMapping->windowSize) || (length > pMapping->windowSize - offset)) {
+        return true;
+    }
+    if ((offset + length > pMapping->fileSize) && log_extendMapping(pMapping, offset + length)) {
+        return true;
+    }
+    memcpy(pMapping->pBase + offset, pText, length);
+    return false;
+} // log_writeMapping()
+
+
+
+/** Creates a memory-mapped log file.
+
+    @param filename The name (with path) of the file.
+    @param append If true, the new messages are appended to the file.
+    @param windowSize The largest number of bytes to add to the file.
+    @return The memory-mapped log file or NULL if an error occurred.
+ */
+static log_mapping_t *log_createMapping(char const *filename, bool append, size_t windowSize) {
+    log_mapping_t *pMapping;
+    struct stat status;
+    void *pBase;
+
+    if (NULL == (pMapping = calloc(1, sizeof(log_mapping_t)))) {
+        return NULL;
+    }
+    pMapping->fd = open(filename, O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+    if (pMapping->fd < 0) {
+        free(pMapping);
+        return NULL;
+    }
+    if (fstat(pMapping->fd, &status) != 0) {
+        (void) close(pMapping->fd);
+        free(pMapping);
+        return NULL;
+    }
+
+    pMapping->tail = (size_t) status.st_size;
+    pMapping->fileSize = (size_t) status.st_size;
+    pMapping->windowSize = (size_t) status.st_size + windowSize;
+    pBase = mmap(NULL, pMapping->windowSize, PROT_READ | PROT_WRITE, MAP_SHARED, pMapping->fd, 0);
+    if (MAP_FAILED == pBase) {
+        (void) close(pMapping->fd);
+        free(pMapping);
+        return NULL;
+    }
+    pMapping->pBase = pBase;
+#if LOGGING_THREADS
+    (void) pthread_mutex_init(&pMapping->mutex, NULL);
+#endif // LOGGING_THREADS
+
+    return pMapping;
+} // log_createMapping()
+
+
+
+/** Closes a memory-mapped log file that is no longer in use.
+
+    The file is truncated to the bytes actually written.
+
+    @param pMapping The memory-mapped log file.
+    @return Did an error occur?
+ */
+static bool log_destroyMapping(log_mapping_t *pMapping) {
+    size_t length = pMapping->tail;
+    bool failed = false;
+
+    if (length > pMapping->fileSize) {
+        // Records that did not fit were discarded, possibly leaving a gap.
+        length = pMapping->fileSize;
+        while ((length > 0) && ('\0' == pMapping->pBase[length - 1])) {
+            length--;
+        }
+    }
+
+    if (munmap(pMapping->pBase, pMapping->windowSize) != 0) {
+        failed = true;
+    }
+    if (ftruncate(pMapping->fd, (off_t) length) != 0) {
+        failed = true;
+    }
+    if (close(pMapping->fd) != 0) {
+        failed = true;
+    }
+#if LOGGING_THREADS
+    (void) pthread_mutex_destroy(&pMapping->mutex);
+#endif // LOGGING_THREADS
+    free(pMapping);
+
+    return failed;
+} // log_destroyMapping()
+#else
+static bool log_writeMapping(log_mapping_t *pMapping, char const *pText, size_t length) {
+    (void) pMapping;
+    (void) pText;
+    (void) length;
+    return true;
+} // log_writeMapping()
+
+
+
+static bool log_destroyMapping(log_mapping_t *pMapping) {
+    (void) pMapping;
+    return false;
+} // log_destroyMapping()
+#endif // !LOG_MAPPED_FILES
+
+
+
+/** Writes a formatted record to all channels accepting its level.
+
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @param inBatch Is the record written by the asynchronous writer?
+ */
+static void log_writeRecord(log_level_t level, char const *pText, size_t length,
+                            bool inBatch) {
+    if (logLevelStderr <= level) {
+        (void) fwrite(pText, 1, length, stderr);
+    }
+    if (logLevelStdout <= level) {
+        // If suppression is active, log only what has not been output to stderr.
+        if (!logSuppressStdout || (logLevelStderr > level)) {
+            (void) fwrite(pText, 1, length, stdout);
+        }
+    }
+    if (logLevelFile <= level) {
+        FILE *pFile;
+        unsigned epoch = log_acquireLogfile(&pFile);
+        size_t written = 0;
+
+        if (NULL != pFile) {
+            written = fwrite(pText, 1, length, pFile);
+            log_applyFlushPolicy(pFile, level, pText, length, inBatch);
+        } else {
+            log_mapping_t *pMapping = logMapping;
+
+            if ((NULL != pMapping) && !log_writeMapping(pMapping, pText, length)) {
+                written = length;
+            }
+        }
+        log_releaseLogfile(epoch);
+
+#if LOGGING_THREADS
+        // Only the bytes that reached the file count towards its rotation.
+        if (0 != written) {
+            unsigned long maximumBytes = logRotation.maximumBytes;
+            unsigned long bytes = atomic_fetch_add(&logFileBytes, (unsigned long) written) + written;
+
+            // Only wake the rotation thread, it does the work. The rotation
+            // lock may be held by a thread waiting for this one to flush, so
+            // the wakeup uses a lock of its own.
+            if ((0 != maximumBytes) && (bytes >= maximumBytes) && (bytes - written < maximumBytes)) {
+                (void) pthread_mutex_lock(&logRotation.wakeMutex);
+                logRotation.pending = true;
+                (void) pthread_cond_signal(&logRotation.condition);
+                (void) pthread_mutex_unlock(&logRotation.wakeMutex);
+            }
+        }
+#else
+        (void) written;
+#endif // LOGGING_THREADS
+    }
+} // log_writeRecord()
+
+
+
+#if LOGGING_THREADS
+/** Wakes the writer thread. */
+static void log_wakeWriter(void) {
+    (void) pthread_mutex_lock(&logAsync.mutex);
+    (void) pthread_cond_signal(&logAsync.condition);
+    (void) pthread_mutex_unlock(&logAsync.mutex);
+} // log_wakeWriter()
+
+
+
+/** Sleeps for a short time while waiting for the writer. */
+static void log_pause(void) {
+    struct timespec pause = { 0, 50000L };
+
+    (void) nanosleep(&pause, NULL);
+} // log_pause()
+
+
+
+/** Copies a part of a record, which may end in #LOG_QUEUE_TRUNCATED.
+
+    @param pDest Receives the part.
+    @param offset The offset of the part in the record.
+    @param size The number of bytes in the part.
+    @param pText The text of the record.
+    @param textLength The number of bytes of the text, the marker follows.
+ */
+static void log_copyRecordPart(char *pDest, size_t offset, size_t size,
+                               char const *pText, size_t textLength) {
+    if (offset < textLength) {
+        size_t textSize = (textLength - offset < size) ? textLength - offset : size;
+
+        memcpy(pDest, pText + offset, textSize);
+        pDest += textSize;
+        offset += textSize;
+        size -= textSize;
+    }
+    memcpy(pDest, LOG_QUEUE_TRUNCATED + (offset - textLength), size);
+} // log_copyRecordPart()
+
+
+
+/** Places a record in the queue of the asynchronous writer.
+
+    A record occupies as many slots as it needs. A record longer than the
+    whole queue is cut and ends in #LOG_QUEUE_TRUNCATED instead.
+
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @return Was the record dropped?
+ */
+static bool log_enqueue(log_level_t level, char const *pText, size_t length) {
+    size_t nrSlots = (length + LOG_QUEUE_TEXT_SIZE - 1) / LOG_QUEUE_TEXT_SIZE;
+    size_t textLength = length, offset = 0;
+    size_t position, i;
+
+    if (0 == nrSlots) {
+        nrSlots = 1;
+    } else if (nrSlots > logAsync.mask + 1) {
+        nrSlots = logAsync.mask + 1;
+        length = nrSlots * LOG_QUEUE_TEXT_SIZE;
+        textLength = length - (sizeof(LOG_QUEUE_TRUNCATED) - 1);
+    }
+
+    // Claim nrSlots consecutive slots. The writer frees slots in order, so
+    // if the last one is free, all of them are.
+    position = atomic_load_explicit(&logAsync.enqueuePosition, memory_order_relaxed);
+    for (;;) {
+        log_queue_slot_t *pLastSlot = &logAsync.pSlots[(position + nrSlots - 1) & logAsync.mask];
+        size_t sequence = atomic_load_explicit(&pLastSlot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + nrSlots - 1);
+
+        if (0 == difference) {
+            if (atomic_compare_exchange_weak_explicit(&logAsync.enqueuePosition,
+                                                      &position, position + nrSlots,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The queue is full.
+            if (LOG_QUEUE_BLOCK != logAsync.policy) {
+                atomic_fetch_add_explicit(&logAsync.nrDropped, 1, memory_order_relaxed);
+                return true;
+            }
+            log_wakeWriter();
+            log_pause();
+            position = atomic_load_explicit(&logAsync.enqueuePosition, memory_order_relaxed);
+        } else {
+            // Another producer claimed the slots first.
+            position = atomic_load_explicit(&logAsync.enqueuePosition, memory_order_relaxed);
+        }
+    } // for ever
+
+    // Fill the slots and hand each one over to the writer.
+    for (i = 0; i < nrSlots; i++) {
+        log_queue_slot_t *pSlot = &logAsync.pSlots[(position + i) & logAsync.mask];
+        size_t chunkSize = (length > LOG_QUEUE_TEXT_SIZE) ? LOG_QUEUE_TEXT_SIZE : length;
+
+        if (0 == i) {
+            pSlot->length = (uint32_t) length;
+            pSlot->level = (uint32_t) level;
+        }
+        log_copyRecordPart(pSlot->text, offset, chunkSize, pText, textLength);
+        offset += chunkSize;
+        length -= chunkSize;
+        atomic_store_explicit(&pSlot->sequence, position + i + 1, memory_order_release);
+    }
+
+    // Only wake the writer if it sleeps. The fence orders the stores
+    // above before the load of the flag, pairing with the writer.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&logAsync.sleeping, memory_order_relaxed)) {
+        log_wakeWriter();
+    }
+    return false;
+} // log_enqueue()
+
+
+
+/** Checks if the writer has a record to read.
+
+    @return Is the first slot of a record ready?
+ */
+static bool log_isRecordQueued(void) {
+    size_t position = atomic_load_explicit(&logAsync.dequeuePosition, memory_order_relaxed);
+    log_queue_slot_t *pSlot = &logAsync.pSlots[position & logAsync.mask];
+
+    return atomic_load_explicit(&pSlot->sequence, memory_order_acquire) == position + 1;
+} // log_isRecordQueued()
+
+
+
+/** Takes the next record from the queue of the asynchronous writer.
+
+    @param pBuffer Receives the text, as many bytes as the slots hold.
+    @param pLevel Receives the level of the record.
+    @param pLength Receives the number of bytes in the record.
+    @return Was a record available?
+ */
+static bool log_dequeue(char *pBuffer, log_level_t *pLevel, size_t *pLength) {
+    size_t position = atomic_load_explicit(&logAsync.dequeuePosition, memory_order_relaxed);
+    log_queue_slot_t *pSlot = &logAsync.pSlots[position & logAsync.mask];
+    size_t nrSlots, length, i;
+
+    if (atomic_load_explicit(&pSlot->sequence, memory_order_acquire) != position + 1) {
+        // The queue is empty.
+        return false;
+    }
+
+    length = pSlot->length;
+    *pLevel = (log_level_t) pSlot->level;
+    *pLength = length;
+    nrSlots = (length + LOG_QUEUE_TEXT_SIZE - 1) / LOG_QUEUE_TEXT_SIZE;
+    if (0 == nrSlots) {
+        nrSlots = 1;
+    }
+
+    for (i = 0; i < nrSlots; i++) {
+        size_t chunkSize = (length > LOG_QUEUE_TEXT_SIZE) ? LOG_QUEUE_TEXT_SIZE : length;
+
+        pSlot = &logAsync.pSlots[(position + i) & logAsync.mask];
+        while (atomic_load_explicit(&pSlot->sequence, memory_order_acquire) != position + i + 1) {
+            // The producer is still filling the remaining slots.
+            (void) sched_yield();
+        }
+        memcpy(pBuffer, pSlot->text, chunkSize);
+        pBuffer += chunkSize;
+        length -= chunkSize;
+        // Hand the slot back to the producers for the next lap.
+        atomic_store_explicit(&pSlot->sequence, position + i + logAsync.mask + 1,
+                              memory_order_release);
+    }
+
+    atomic_store_explicit(&logAsync.dequeuePosition, position + nrSlots, memory_order_release);
+    return true;
+} // log_dequeue()
+
+
+
+/** The writer thread of the asynchronous mode.
+
+    Writes all queued records, flushes the log file once the queue is
+    empty, and sleeps until more records arrive.
+
+    @param pArgument Not used.
+    @return Always NULL.
+ */
+static void *log_writerThread(void *pArgument) {
+    char *record = logAsync.pRecord;
+    unsigned long nrReportedDrops = 0;
+    log_level_t level;
+    size_t length;
+
+    (void) pArgument;
+
+    for (;;) {
+        unsigned long nrDropped;
+        bool wroteRecords = false;
+
+        while (log_dequeue(record, &level, &length)) {
+            log_writeRecord(level, record, length, true);
+            atomic_store_explicit(&logAsync.writtenPosition,
+                                  atomic_load_explicit(&logAsync.dequeuePosition, memory_order_relaxed),
+                                  memory_order_release);
+            wroteRecords = true;
+        }
+
+        nrDropped = atomic_load_explicit(&logAsync.nrDropped, memory_order_relaxed);
+        if ((LOG_QUEUE_DROP_REPORT == logAsync.policy) && (nrDropped != nrReportedDrops)) {
+            int reportLength = snprintf(record, (logAsync.mask + 1) * LOG_QUEUE_TEXT_SIZE,
+                                        "WARNING: %lu log messages dropped.\n",
+                                        nrDropped - nrReportedDrops);
+
+            log_writeRecord(LOGLEVEL_WARNING, record, (size_t) reportLength, true);
+            nrReportedDrops = nrDropped;
+            wroteRecords = true;
+        }
+
+        if (wroteRecords) {
+            // Flush once per batch instead of once per message.
+            if (LOG_FLUSH_EVERY_MESSAGE == logFlushPolicy) {
+                log_flushLogfile();
+            }
+            continue;
+        }
+
+        if (atomic_load(&logAsync.stop)) {
+            break;
+        }
+
+        // The queue is empty, sleep until a producer signals or the
+        // timeout expires.
+        (void) pthread_mutex_lock(&logAsync.mutex);
+        atomic_store(&logAsync.sleeping, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!log_isRecordQueued() && !atomic_load(&logAsync.stop)) {
+            struct timespec timeout;
+
+            (void) clock_gettime(CLOCK_REALTIME, &timeout);
+            timeout.tv_nsec += LOG_WRITER_IDLE_NS;
+            if (timeout.tv_nsec >= 1000000000L) {
+                timeout.tv_sec++;
+                timeout.tv_nsec -= 1000000000L;
+            }
+            (void) pthread_cond_timedwait(&logAsync.condition, &logAsync.mutex, &timeout);
+        }
+        atomic_store(&logAsync.sleeping, false);
+        (void) pthread_mutex_unlock(&logAsync.mutex);
+    } // for ever
+
+    return NULL;
+} // log_writerThread()
+
+
+
+bool log_startAsync(size_t queueSize, log_queue_policy_t policy) {
+    size_t nrSlots = LOG_QUEUE_MINIMUM_SIZE / LOG_QUEUE_SLOT_SIZE;
+    size_t i;
+
+    if (NULL != logAsync.pSlots) {
+        // The writer is already running.
+        return true;
+    }
+
+    while (nrSlots * LOG_QUEUE_SLOT_SIZE < queueSize) {
+        nrSlots *= 2;
+    }
+    if (NULL == (logAsync.pRecord = malloc(nrSlots * LOG_QUEUE_TEXT_SIZE))) {
+        return true;
+    }
+    if (NULL == (logAsync.pSlots = malloc(nrSlots * sizeof(log_queue_slot_t)))) {
+        free(logAsync.pRecord);
+        logAsync.pRecord = NULL;
+        return true;
+    }
+    for (i = 0; i < nrSlots; i++) {
+        atomic_init(&logAsync.pSlots[i].sequence, i);
+    }
+    logAsync.mask = nrSlots - 1;
+    logAsync.policy = policy;
+    atomic_store(&logAsync.enqueuePosition, 0);
+    atomic_store(&logAsync.dequeuePosition, 0);
+    atomic_store(&logAsync.writtenPosition, 0);
+    atomic_store(&logAsync.sleeping, false);
+    atomic_store(&logAsync.stop, false);
+
+    if (pthread_create(&logAsync.thread, NULL, log_writerThread, NULL) != 0) {
+        free(logAsync.pSlots);
+        logAsync.pSlots = NULL;
+        free(logAsync.pRecord);
+        logAsync.pRecord = NULL;
+        return true;
+    }
+
+    atomic_store_explicit(&logAsync.active, true, memory_order_release);
+    return false;
+} // log_startAsync()
+
+
+
+void log_stopAsync(void) {
+    if (NULL == logAsync.pSlots) {
+        // Asynchronous logging is not active.
+        return;
+    }
+
+    // New messages are written synchronously from now on, the writer
+    // empties the queue before it terminates.
+    atomic_store(&logAsync.active, false);
+    atomic_store(&logAsync.stop, true);
+    log_wakeWriter();
+    (void) pthread_join(logAsync.thread, NULL);
+
+    free(logAsync.pSlots);
+    logAsync.pSlots = NULL;
+    free(logAsync.pRecord);
+    logAsync.pRecord = NULL;
+} // log_stopAsync()
+
+
+
+unsigned long log_getDroppedCount(void) {
+    return atomic_load_explicit(&logAsync.nrDropped, memory_order_relaxed);
+} // log_getDroppedCount()
+#else
+bool log_startAsync(size_t queueSize, log_queue_policy_t policy) {
+    (void) queueSize;
+    (void) policy;
+
+    // Not supported without threads.
+    return true;
+} // log_startAsync()
+
+
+
+void log_stopAsync(void) {
+} // log_stopAsync()
+
+
+
+unsigned long log_getDroppedCount(void) {
+    return 0;
+} // log_getDroppedCount()
+#endif // !LOGGING_THREADS
+
+
+
+#if LOGGING_THREADS
+/** The timer thread of #LOG_FLUSH_INTERVAL.
+
+    @param pArgument Not used.
+    @return Always NULL.
+ */
+static void *log_flusherThread(void *pArgument) {
+    (void) pArgument;
+
+    (void) pthread_mutex_lock(&logFlusher.mutex);
+    while (!logFlusher.stop) {
+        struct timespec timeout;
+
+        (void) clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += (time_t) (logFlushParameter / 1000);
+        timeout.tv_nsec += (long) (logFlushParameter % 1000) * 1000000L;
+        if (timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+        (void) pthread_cond_timedwait(&logFlusher.condition, &logFlusher.mutex, &timeout);
+
+        if (logFileDirty) {
+            logFileDirty = false;
+            log_flushLogfile();
+        }
+    }
+    (void) pthread_mutex_unlock(&logFlusher.mutex);
+
+    return NULL;
+} // log_flusherThread()
+#endif // LOGGING_THREADS
+
+
+
+bool log_setFlushPolicy(log_flush_policy_t policy, unsigned long parameter) {
+    if (((LOG_FLUSH_BYTES == policy) || (LOG_FLUSH_INTERVAL == policy)) && (0 == parameter)) {
+        return true;
+    }
+#if LOGGING_THREADS
+    // Stop the timer thread of the previous policy.
+    if (logFlusher.running) {
+        (void) pthread_mutex_lock(&logFlusher.mutex);
+        logFlusher.stop = true;
+        (void) pthread_cond_signal(&logFlusher.condition);
+        (void) pthread_mutex_unlock(&logFlusher.mutex);
+        (void) pthread_join(logFlusher.thread, NULL);
+        logFlusher.running = false;
+    }
+#else
+    if (LOG_FLUSH_INTERVAL == policy) {
+        // Not supported without threads.
+        return true;
+    }
+#endif // LOGGING_THREADS
+
+    logFlushParameter = parameter;
+    logUnflushedBytes = 0;
+    logFlushPolicy = policy;
+
+#if LOGGING_THREADS
+    if (LOG_FLUSH_INTERVAL == policy) {
+        logFlusher.stop = false;
+        if (pthread_create(&logFlusher.thread, NULL, log_flusherThread, NULL) != 0) {
+            logFlushPolicy = LOG_FLUSH_EVERY_MESSAGE;
+            return true;
+        }
+        logFlusher.running = true;
+    }
+#endif // LOGGING_THREADS
+
+    // Start the new policy with an empty buffer.
+    log_flushLogfile();
+    return false;
+} // log_setFlushPolicy()
+
+
+
+/** Flushes the log file and terminates the program with the signal.
+
+    @param signalNumber The fatal signal.
+ */
+static void log_crashHandler(int signalNumber) {
+    FILE *pFile = logFileHandle;
+
+#if LOG_FLIGHT_RECORDER
+    {
+        char const *pRing = logRecorder.pRing;
+
+        if (NULL != pRing) {
+            (void) log_dumpRingOnce(pRing);
+        }
+    }
+#endif // LOG_FLIGHT_RECORDER
+
+    // Not async-signal-safe, but the program is lost anyway and the
+    // messages are most valuable now.
+    if (NULL != pFile) {
+        (void) fflush(pFile);
+    }
+
+    // The default action was restored before the handler was called.
+    (void) raise(signalNumber);
+} // log_crashHandler()
+
+
+
+bool log_installCrashHandler(void) {
+#ifdef _WIN32
+    static int const signals[] = { SIGSEGV, SIGFPE, SIGILL, SIGABRT };
+#else
+    static int const signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    struct sigaction action;
+#endif // !_WIN32
+    size_t i;
+
+#ifndef _WIN32
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = log_crashHandler;
+    (void) sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND | SA_NODEFER;
+#endif // !_WIN32
+
+    for (i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+#ifdef _WIN32
+        // Windows resets the handler before calling it.
+        if (SIG_ERR == signal(signals[i], log_crashHandler)) {
+            return true;
+        }
+#else
+        if (sigaction(signals[i], &action, NULL) != 0) {
+            return true;
+        }
+#endif // !_WIN32
+    }
+
+    return false;
+} // log_installCrashHandler()
+
+
+
+#if LOG_FLIGHT_RECORDER
+bool log_startFlightRecorder(char const *filename, size_t size, log_level_t level) {
+    size_t ringSize = 1;
+    char *pRing;
+
+    assert(NULL != filename);
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+
+    if (NULL != logRecorder.pRing) {
+        return true;
+    }
+    while (ringSize < size) {
+        ringSize <<= 1;
+    }
+    if (NULL == (pRing = malloc(ringSize))) {
+        return true;
+    }
+    if (NULL == (logRecorder.filename = malloc(strlen(filename) + 1))) {
+        free(pRing);
+        return true;
+    }
+    strcpy(logRecorder.filename, filename);
+    if (log_installCrashHandler()) {
+        free(logRecorder.filename);
+        logRecorder.filename = NULL;
+        free(pRing);
+        return true;
+    }
+
+    logRecorder.mask = ringSize - 1;
+    logRecorder.head = 0;
+    logRecorder.level = level;
+    logRecorder.pRing = pRing;
+    log_updateMinimumLevel();
+    return false;
+} // log_startFlightRecorder()
+
+
+
+void log_stopFlightRecorder(void) {
+    char *pRing;
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logFileMutex);
+    pRing = atomic_exchange(&logRecorder.pRing, NULL);
+#else
+    pRing = logRecorder.pRing;
+    logRecorder.pRing = NULL;
+#endif // !LOGGING_THREADS
+    // Wait until no thread records into the ring any more.
+    log_waitForLogfileUsers();
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logFileMutex);
+#endif // LOGGING_THREADS
+    log_updateMinimumLevel();
+
+    // A dump in progress (e.g. by a signal handler) still reads the ring.
+    while (logRecorder.dumping) {
+#if LOGGING_THREADS
+        (void) sched_yield();
+#endif // LOGGING_THREADS
+    }
+    free(pRing);
+    free(logRecorder.filename);
+    logRecorder.filename = NULL;
+} // log_stopFlightRecorder()
+
+
+
+bool log_dumpFlightRecorder(void) {
+    FILE *pFile;
+    unsigned epoch = log_acquireLogfile(&pFile);
+    char const *pRing = logRecorder.pRing;
+    bool failed = true;
+
+    if (NULL != pRing) {
+        failed = log_dumpRingOnce(pRing);
+    }
+    log_releaseLogfile(epoch);
+    return failed;
+} // log_dumpFlightRecorder()
+#else
+bool log_startFlightRecorder(char const *filename, size_t size, log_level_t level) {
+    (void) filename;
+    (void) size;
+    (void) level;
+    return true;
+} // log_startFlightRecorder()
+
+
+
+void log_stopFlightRecorder(void) {
+} // log_stopFlightRecorder()
+
+
+
+bool log_dumpFlightRecorder(void) {
+    return true;
+} // log_dumpFlightRecorder()
+#endif // !LOG_FLIGHT_RECORDER
+
+
+
+/** Replaces the log file and closes the old one.
+
+    The caller must hold the rotation lock.
+
+    @param pFile The new log file or NULL.
+    @param pMapping The new memory-mapped log file or NULL.
+    @param size The number of bytes already in the new file.
+    @return Could the old log file not be closed?
+ */
+static bool log_replaceLogfile(FILE *pFile, log_mapping_t *pMapping, unsigned long size) {
+    FILE *pOldFile;
+    log_mapping_t *pOldMapping;
+    bool failed = false;
+
+    // Write whatever the asynchronous writer still holds for the old file.
+    log_flush();
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logFileMutex);
+#endif // LOGGING_THREADS
+    pOldFile = log_exchangeLogfile(pFile, pMapping, &pOldMapping);
+    logFileBytes = size;
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logFileMutex);
+#endif // LOGGING_THREADS
+    log_updateMinimumLevel();
+
+    if ((NULL != pOldFile) && (fclose(pOldFile) != 0)) {
+        failed = true;
+    }
+    if ((NULL != pOldMapping) && log_destroyMapping(pOldMapping)) {
+        failed = true;
+    }
+    if (failed) {
+#if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        log_logMessage((LOGLEVEL_ERROR,
+                       "Unable to close logfile: %s",
+                       strerror(errno)));
+#else
+        log_logMessage(LOGLEVEL_ERROR,
+                       "Unable to close logfile: %s",
+                       strerror(errno));
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+    }
+
+    return failed;
+} // log_replaceLogfile()
+
+
+
+/** Locks out rotation while the log file is opened or closed. */
+static void log_lockRotation(void) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logRotation.mutex);
+#endif // LOGGING_THREADS
+} // log_lockRotation()
+
+
+
+/** Allows rotation again. */
+static void log_unlockRotation(void) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logRotation.mutex);
+#endif // LOGGING_THREADS
+} // log_unlockRotation()
+
+
+
+/** Remembers the name of the log file for rotation.
+
+    The caller must hold the rotation lock.
+
+    @param filename The name of the file or NULL.
+    @param isMapped Is the file memory-mapped?
+    @param mappedSize The maximum size of the memory-mapped file.
+ */
+static void log_setLogfileName(char const *filename, bool isMapped, size_t mappedSize) {
+    free(logFileName);
+    logFileName = (NULL == filename) ? NULL : strdup(filename);
+    logFileIsMapped = isMapped;
+    logFileMappedSize = mappedSize;
+} // log_setLogfileName()
+
+
+
+bool log_openLogfile(char const *filename, bool append) {
+    FILE *pFile;
+    long size = 0;
+
+    // Open the new file first, so no message is lost while the files are
+    // exchanged.
+    if (append) {
+        pFile = fopen(filename, "a");
+    } else {
+        pFile = fopen(filename, "w");
+    }
+
+    if (NULL == pFile) {
+        fprintf(stderr, "ERROR: Unable to open logfile '%s' for write: %s\n", filename, strerror(errno));
+        return true;
+    }
+    if (append && (fseek(pFile, 0, SEEK_END) == 0) && ((size = ftell(pFile)) < 0)) {
+        size = 0;
+    }
+
+    log_lockRotation();
+    (void) log_replaceLogfile(pFile, NULL, (unsigned long) size);
+    log_setLogfileName(filename, false, 0);
+    log_unlockRotation();
+    return false;
+} // log_openLogfile()
+
+
+
+bool log_openMappedLogfile(char const *filename, bool append, size_t maximumSize) {
+#if LOG_MAPPED_FILES
+    log_mapping_t *pMapping;
+
+    if (0 == maximumSize) {
+        maximumSize = LOG_MAPPED_WINDOW_SIZE;
+    }
+
+    if (NULL == (pMapping = log_createMapping(filename, append, maximumSize))) {
+        fprintf(stderr, "ERROR: Unable to map logfile '%s' for write: %s\n", filename, strerror(errno));
+        return true;
+    }
+
+    log_lockRotation();
+    (void) log_replaceLogfile(NULL, pMapping, (unsigned long) pMapping->tail);
+    log_setLogfileName(filename, true, maximumSize);
+    log_unlockRotation();
+    return false;
+#else
+    (void) filename;
+    (void) append;
+    (void) maximumSize;
+    return true;
+#endif // !LOG_MAPPED_FILES
+} // log_openMappedLogfile()
+
+
+
+bool log_closeLogfile(void) {
+    bool failed;
+
+    assert((NULL != logFileHandle) || (NULL != logMapping));
+
+    log_lockRotation();
+    failed = log_replaceLogfile(NULL, NULL, 0);
+    log_setLogfileName(NULL, false, 0);
+    log_unlockRotation();
+    return failed;
+} // log_closeLogfile()
+
+
+
+#if LOGGING_THREADS
+/** Builds the name of a rotated log file.
+
+    @param number The number of the rotated file, 0 for the log file itself.
+    @return The name, to be free()d by the caller, or NULL.
+ */
+static char *log_rotatedName(unsigned number) {
+    size_t size = strlen(logFileName) + 12;
+    char *pName = malloc(size);
+
+    if (NULL != pName) {
+        if (0 == number) {
+            (void) snprintf(pName, size, "%s", logFileName);
+        } else {
+            (void) snprintf(pName, size, "%s.%u", logFileName, number);
+        }
+    }
+    return pName;
+} // log_rotatedName()
+
+
+
+/** Renames the log file and continues in a new file of the same name.
+
+    The rotated files are numbered from 1 (the most recent) up to the
+    number of kept files. Threads keep logging into the renamed file until
+    the new one is in place.
+
+    The caller must hold the rotation lock.
+ */
+static void log_rotateLogfile(void) {
+    FILE *pFile = NULL;
+    log_mapping_t *pMapping = NULL;
+    char *pFrom, *pTo;
+    unsigned i;
+
+    if (NULL == logFileName) {
+        return;
+    }
+
+    // Make room for the file that is rotated now.
+    pTo = log_rotatedName((0 == logRotation.nrKeptFiles) ? 1 : logRotation.nrKeptFiles);
+    for (i = (0 == logRotation.nrKeptFiles) ? 0 : logRotation.nrKeptFiles - 1; ; i--) {
+        pFrom = log_rotatedName(i);
+        if ((NULL != pFrom) && (NULL != pTo)) {
+            (void) rename(pFrom, pTo);
+        }
+        free(pTo);
+        pTo = pFrom;
+        if (0 == i) {
+            break;
+        }
+    }
+    free(pTo);
+
+#if LOG_MAPPED_FILES
+    if (logFileIsMapped) {
+        pMapping = log_createMapping(logFileName, false, logFileMappedSize);
+    } else
+#endif // LOG_MAPPED_FILES
+    {
+        pFile = fopen(logFileName, "w");
+    }
+    if ((NULL == pFile) && (NULL == pMapping)) {
+        // Keep logging into the renamed file.
+        fprintf(stderr, "ERROR: Unable to rotate logfile '%s': %s\n", logFileName, strerror(errno));
+        return;
+    }
+    (void) log_replaceLogfile(pFile, pMapping, 0);
+
+    if (0 == logRotation.nrKeptFiles) {
+        if (NULL != (pTo = log_rotatedName(1))) {
+            (void) remove(pTo);
+            free(pTo);
+        }
+    }
+} // log_rotateLogfile()
+
+
+
+/** Rotates the log file when it is due.
+
+    @param pArgument Unused.
+    @return Always NULL.
+ */
+static void *log_rotationThread(void *pArgument) {
+    struct timespec now, due;
+
+    (void) pArgument;
+
+    (void) clock_gettime(CLOCK_REALTIME, &now);
+    due.tv_sec = now.tv_sec + (time_t) logRotation.interval;
+    due.tv_nsec = now.tv_nsec;
+    (void) pthread_mutex_lock(&logRotation.wakeMutex);
+    while (!logRotation.stop) {
+        struct timespec timeout = due;
+
+        if (0 == logRotation.interval) {
+            // Check the size now and then, e.g. to retry a failed rotation.
+            timeout.tv_sec = now.tv_sec + 1;
+            timeout.tv_nsec = now.tv_nsec;
+        }
+        if (!logRotation.pending) {
+            (void) pthread_cond_timedwait(&logRotation.condition, &logRotation.wakeMutex, &timeout);
+        }
+        if (logRotation.stop) {
+            break;
+        }
+        logRotation.pending = false;
+        (void) pthread_mutex_unlock(&logRotation.wakeMutex);
+
+        (void) clock_gettime(CLOCK_REALTIME, &now);
+        (void) pthread_mutex_lock(&logRotation.mutex);
+        if (((0 != logRotation.maximumBytes) && (logFileBytes >= logRotation.maximumBytes))
+            || ((0 != logRotation.interval) && (now.tv_sec >= due.tv_sec))) {
+            log_rotateLogfile();
+            due.tv_sec = now.tv_sec + (time_t) logRotation.interval;
+            due.tv_nsec = now.tv_nsec;
+        }
+        (void) pthread_mutex_unlock(&logRotation.mutex);
+        (void) pthread_mutex_lock(&logRotation.wakeMutex);
+    }
+    (void) pthread_mutex_unlock(&logRotation.wakeMutex);
+
+    return NULL;
+} // log_rotationThread()
+
+
+
+bool log_setRotation(unsigned long maximumBytes, unsigned long interval, unsigned nrKeptFiles) {
+    // Stop the thread of the previous setting.
+    if (logRotation.running) {
+        (void) pthread_mutex_lock(&logRotation.wakeMutex);
+        logRotation.stop = true;
+        (void) pthread_cond_signal(&logRotation.condition);
+        (void) pthread_mutex_unlock(&logRotation.wakeMutex);
+        (void) pthread_join(logRotation.thread, NULL);
+        logRotation.running = false;
+    }
+
+    logRotation.maximumBytes = maximumBytes;
+    logRotation.interval = interval;
+    logRotation.nrKeptFiles = nrKeptFiles;
+
+    if ((0 != maximumBytes) || (0 != interval)) {
+        logRotation.stop = false;
+        logRotation.pending = false;
+        if (pthread_create(&logRotation.thread, NULL, log_rotationThread, NULL) != 0) {
+            logRotation.maximumBytes = 0;
+            return true;
+        }
+        logRotation.running = true;
+    }
+    return false;
+} // log_setRotation()
+#else
+bool log_setRotation(unsigned long maximumBytes, unsigned long interval, unsigned nrKeptFiles) {
+    (void) nrKeptFiles;
+
+    // Rotation needs a thread of its own.
+    return (0 != maximumBytes) || (0 != interval);
+} // log_setRotation()
+#endif // !LOGGING_THREADS
+
+
+
+void log_flushLogfile(void) {
+    FILE *pFile;
+    unsigned epoch = log_acquireLogfile(&pFile);
+
+    if (NULL != pFile) {
+        (void) fflush(pFile);
+    }
+    log_releaseLogfile(epoch);
+} // log_flushLogfile()
+
+
+
+void log_setFileLevel(log_level_t level) {
+    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+
+    logLevelFile = level;
+    log_updateMinimumLevel();
+} // log_setFileLevel()
+
+
+
+void log_setStderrLevel(log_level_t level) {
+    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+
+    logLevelStderr = level;
+    log_updateMinimumLevel();
+} // log_setStderrLevel()
+
+
+
+void log_setStdoutLevel(log_level_t level) {
+    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+
+    logLevelStdout = level;
+    log_updateMinimumLevel();
+} // log_setStdoutLevel()
+
+
+
+void log_setUncategorizedLevel(log_level_t level) {
+    assert(level <= LOGLEVEL_ALWAYS);
+
+    logUncategorizedLevel = level;
+    log_updateMinimumLevel();
+} // log_setUncategorizedLevel()
+
+
+
+void log_setStdoutSupression(bool suppress) {
+    logSuppressStdout = suppress;
+} // log_setStdoutSupression()
+
+
+
+void log_setTimestamps(bool enable) {
+    logTimestamps = enable;
+} // log_setTimestamps()
+
+
+
+/** Writes the timestamp of a line.
+
+    The date and time up to the second are formatted only when the second
+    changes, the microseconds are appended as digit pairs.
+
+    @param pBuffer Receives #LOG_TIMESTAMP_LENGTH characters.
+ */
+static void log_formatTimestamp(char *pBuffer) {
+    struct timespec now;
+    unsigned long microseconds;
+
+    (void) clock_gettime(CLOCK_REALTIME, &now);
+    if ((now.tv_sec != logTimestampSecond) || ('\0' == logTimestampSecondText[0])) {
+        struct tm brokenDown;
+
+#ifdef _WIN32
+        (void) localtime_s(&brokenDown, &now.tv_sec);
+#else
+        (void) localtime_r(&now.tv_sec, &brokenDown);
+#endif // !_WIN32
+        (void) strftime(logTimestampSecondText, sizeof(logTimestampSecondText),
+                        "%Y-%m-%d %H:%M:%S.", &brokenDown);
+        logTimestampSecond = now.tv_sec;
+    }
+    memcpy(pBuffer, logTimestampSecondText, LOG_TIMESTAMP_SECOND_LENGTH);
+    pBuffer += LOG_TIMESTAMP_SECOND_LENGTH;
+
+    microseconds = (unsigned long) now.tv_nsec / 1000ul;
+    memcpy(pBuffer, &logDigitPairs[2 * (microseconds / 10000ul)], 2);
+    memcpy(pBuffer + 2, &logDigitPairs[2 * (microseconds / 100ul % 100ul)], 2);
+    memcpy(pBuffer + 4, &logDigitPairs[2 * (microseconds % 100ul)], 2);
+    pBuffer[6] = ' ';
+} // log_formatTimestamp()
+
+
+
+/** Writes the start of a line: the timestamp (if enabled) and the text
+    describing the level.
+
+    @param pBuffer The buffer to write to. It must be large enough.
+    @param level The level of the line.
+    @return The number of characters written.
+ */
+static size_t log_formatPrefix(char *pBuffer, log_level_t level) {
+    size_t length = 0, prefixLength = strlen(logLevelPrefixes[level]);
+
+    if (logTimestamps) {
+        log_formatTimestamp(pBuffer);
+        length = LOG_TIMESTAMP_LENGTH;
+    }
+    memcpy(pBuffer + length, logLevelPrefixes[level], prefixLength);
+    return length + prefixLength;
+} // log_formatPrefix()
+
 
-#ifdef _WIN32
-#define USE_CRLF true
-#else
-#define USE_CRLF false
-#endif // !_WIN32
 
-#ifdef FTR_LOG_GLOBAL_BUFFER
-static char debugBuffer[FTR_LOG_BUFFER_SIZE];
-#endif // FTR_LOG_GLOBAL_BUFFER
+/** Hands a formatted record to the channels.
 
-/** The file handle of the logfile to use or NULL if no file is currently in use. */
-static FILE *logFileHandle = NULL;
-/** All message of the specified or higher level will be output to the log
- * file (if open).
+    The flight recorder copies the record right away. In asynchronous mode
+    the record is then queued for the writer thread, otherwise it is
+    written to each channel accepting its level.
+
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
  */
-static log_level_t logLevelFile = LOGLEVEL_INFO;
-/** All message of the specified or higher level will be output to stderr. */
-static log_level_t logLevelStderr = LOGLEVEL_ERROR;
-/** All message of the specified or higher level will be output to stdout. */
-static log_level_t logLevelStdout = LOGLEVEL_WARNING;
-/** If true, messages sent to stderr will be suppressed on stdout. */
-static bool logSuppressStdout = true;
+static void log_dispatchRecord(log_level_t level, char const *pText, size_t length) {
+#if LOG_FLIGHT_RECORDER
+    if (NULL != logRecorder.pRing) {
+        log_recordFlight(level, pText, length);
+    }
+#endif // LOG_FLIGHT_RECORDER
+    if (level < logChannelMinimumLevel) {
+        // Only recorded.
+        return;
+    }
 
+#if LOGGING_THREADS
+    if (atomic_load_explicit(&logAsync.active, memory_order_acquire)) {
+        (void) log_enqueue(level, pText, length);
+        return;
+    }
+#endif // LOGGING_THREADS
 
+    log_writeRecord(level, pText, length, false);
+} // log_dispatchRecord()
 
-bool log_openLogfile(char const *filename, bool append) {
-    if (NULL != logFileHandle) {
-        if (log_closeLogfile()) {
-            return true;
-        }
+
+
+/** Computes the FNV-1a hash of a record.
+
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @return The hash.
+ */
+static uint64_t log_hashRecord(char const *pText, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+
+    while (length-- > 0) {
+        hash ^= (unsigned char) *pText++;
+        hash *= 1099511628211ull;
     }
+    return hash;
+} // log_hashRecord()
 
-    if (append) {
-        logFileHandle = fopen(filename, "wa");
+
+
+/** Outputs "last message repeated K times" if the last record has been
+    repeated since it was output.
+
+    The caller must hold logLastRecordMutex.
+ */
+static void log_reportRepeats(void) {
+    char note[LOG_TIMESTAMP_LENGTH + 64];
+    size_t length;
+    int noteLength;
+
+    if (0 == logLastRecord.nrRepeats) {
+        return;
+    }
+
+    length = log_formatPrefix(note, logLastRecord.level);
+    noteLength = snprintf(note + length, sizeof(note) - length,
+                          "last message repeated %lu times\n", logLastRecord.nrRepeats);
+    logLastRecord.nrRepeats = 0;
+    if (noteLength > 0) {
+        log_dispatchRecord(logLastRecord.level, note, length + (size_t) noteLength);
+    }
+} // log_reportRepeats()
+
+
+
+/** Hands a formatted record to the channels unless it repeats the last
+    record and duplicates are suppressed.
+
+    @param level The level of the record.
+    @param pText The text of the record.
+    @param length The number of bytes in the record.
+    @param timestampLength The number of bytes of the timestamp at the start
+        of the record, which are ignored when comparing records.
+ */
+static void log_dispatch(log_level_t level, char const *pText, size_t length,
+                         size_t timestampLength) {
+    uint64_t hash;
+
+    if (!logSuppressDuplicates) {
+        log_dispatchRecord(level, pText, length);
+        return;
+    }
+
+    hash = log_hashRecord(pText + timestampLength, length - timestampLength);
+#if LOGGING_THREADS
+    // The record is output under the lock, so no other record can slip
+    // in between it and the report of repeats.
+    (void) pthread_mutex_lock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+    if ((level == logLastRecord.level) && (length - timestampLength == logLastRecord.length)
+        && (hash == logLastRecord.hash)) {
+        logLastRecord.nrRepeats++;
     } else {
-        logFileHandle = fopen(filename, "w");
+        log_reportRepeats();
+        logLastRecord.level = level;
+        logLastRecord.length = length - timestampLength;
+        logLastRecord.hash = hash;
+        log_dispatchRecord(level, pText, length);
     }
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+} // log_dispatch()
 
-    if (NULL == logFileHandle) {
-        fprintf(stderr, "ERROR: Unable to open logfile '%s' for write: %s\n", filename, strerror(errno));
-        return true;
+
+
+/** Outputs the pending report of repeats of the last record, if any. */
+static void log_flushRepeats(void) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+    log_reportRepeats();
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+} // log_flushRepeats()
+
+
+
+void log_flush(void) {
+    log_flushRepeats();
+
+#if LOGGING_THREADS
+    if (atomic_load_explicit(&logAsync.active, memory_order_acquire)) {
+        // Wait until the writer has caught up with all records claimed so far.
+        size_t target = atomic_load(&logAsync.enqueuePosition);
+
+        log_wakeWriter();
+        while ((intptr_t) (atomic_load(&logAsync.writtenPosition) - target) < 0) {
+            log_pause();
+        }
     }
+#endif // LOGGING_THREADS
 
-    return false;
-} // log_openLogfile()
+    log_flushLogfile();
+} // log_flush()
 
 
 
-bool log_closeLogfile(void) {
-    assert(NULL != logFileHandle);
+void log_setDuplicateSuppression(bool enable) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+    log_reportRepeats();
+    logLastRecord.level = LOGLEVEL_NONE;
+    logSuppressDuplicates = enable;
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logLastRecordMutex);
+#endif // LOGGING_THREADS
+} // log_setDuplicateSuppression()
 
-    if (fclose(logFileHandle) != 0) {
-        logFileHandle = NULL;
-#if 0 == LOGGING_API_USES_VARIADIC_MACROS
-        log_logMessage((LOGLEVEL_ERROR,
-                       "Unable to close logfile: %s",
-                       strerror(errno)));
+
+
+/** Reports the messages a rate limit has suppressed.
+
+    @param pLimit The state of the call site.
+    @param level The level of the messages.
+    @param nrSuppressed The number of messages suppressed.
+ */
+static void log_reportSuppressed(log_rate_limit_t const *pLimit, log_level_t level,
+                                 unsigned long nrSuppressed) {
+    char note[LOG_TIMESTAMP_LENGTH + 256];
+    size_t length, prefixLength;
+    int noteLength;
+
+    prefixLength = log_formatPrefix(note, level);
+    noteLength = snprintf(note + prefixLength, sizeof(note) - prefixLength,
+                          "%lu messages from %s:%u suppressed by rate limit.\n",
+                          nrSuppressed, pLimit->file, pLimit->line);
+    if (noteLength < 0) {
+        return;
+    }
+    length = prefixLength + (size_t) noteLength;
+    if (length >= sizeof(note)) {
+        // Keep the EOL marker of a note truncated by a long file name.
+        length = sizeof(note) - 1;
+        note[length - 1] = '\n';
+    }
+    log_dispatch(level, note, length, prefixLength - strlen(logLevelPrefixes[level]));
+} // log_reportSuppressed()
+
+
+
+bool log_checkRateLimit(log_rate_limit_t *pLimit, log_level_t level) {
+    struct timespec ts;
+    uint64_t now, interval, fullTime, newFullTime;
+    unsigned long nrSuppressed;
+
+    assert(NULL != pLimit);
+    assert((0 != pLimit->rate) && (0 != pLimit->burst));
+
+    if (level < logMinimumLevel) {
+        return false;
+    }
+
+    interval = 1000000000ull / pLimit->rate;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+
+    // Each message moves the time the bucket is full by one interval. If
+    // that is more than burst intervals ahead, the bucket is empty.
+#if LOGGING_THREADS
+    fullTime = atomic_load_explicit(&pLimit->fullTime, memory_order_relaxed);
+    do {
+        newFullTime = ((fullTime > now) ? fullTime : now) + interval;
+        if (newFullTime - now > interval * pLimit->burst) {
+            (void) atomic_fetch_add_explicit(&pLimit->nrSuppressed, 1, memory_order_relaxed);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&pLimit->fullTime, &fullTime, newFullTime,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    nrSuppressed = (0 == atomic_load_explicit(&pLimit->nrSuppressed, memory_order_relaxed))
+                   ? 0 : atomic_exchange_explicit(&pLimit->nrSuppressed, 0, memory_order_relaxed);
 #else
-        log_logMessage(LOGLEVEL_ERROR,
-                       "Unable to close logfile: %s",
-                       strerror(errno));
-#endif // LOGGING_API_USES_VARIADIC_MACROS
-        return true;
+    fullTime = pLimit->fullTime;
+    newFullTime = ((fullTime > now) ? fullTime : now) + interval;
+    if (newFullTime - now > interval * pLimit->burst) {
+        pLimit->nrSuppressed++;
+        return false;
     }
-    logFileHandle = NULL;
-    return false;
-} // log_closeLogfile()
+    pLimit->fullTime = newFullTime;
+    nrSuppressed = pLimit->nrSuppressed;
+    pLimit->nrSuppressed = 0;
+#endif // !LOGGING_THREADS
 
+    if (0 != nrSuppressed) {
+        log_reportSuppressed(pLimit, level, nrSuppressed);
+    }
+    return true;
+} // log_checkRateLimit()
 
 
-void log_flushLogfile(void) {
-    assert(NULL != logFileHandle);
 
-    fflush(logFileHandle);
-} // log_flushLogfile()
+/** Formats a message once and hands it to the channels.
+
+    The message is formatted into the buffer of the calling thread. Only
+    messages too long for that buffer are formatted into an allocated
+    buffer.
 
+    @param level The level of the message.
+    @param addPrefix Prepend the text describing the level?
+    @param addEOL Append an EOL marker?
+    @param format A format string as used by @see printf
+    @param arglist A list of parameters as used by @see vprintf
+ */
+static void log_render(log_level_t level, bool addPrefix, bool addEOL,
+                       char const *format, va_list arglist) {
+    char *pBuffer = logRenderBuffer;
+    size_t prefixLength = 0, length;
+    int messageLength;
+    va_list argcopy;
+
+    if (addPrefix) {
+        prefixLength = log_formatPrefix(pBuffer, level);
+    }
 
+    va_copy(argcopy, arglist);
+    messageLength = vsnprintf(pBuffer + prefixLength,
+                              sizeof(logRenderBuffer) - prefixLength,
+                              format, arglist);
+    if (messageLength < 0) {
+        // Invalid format string.
+        va_end(argcopy);
+        return;
+    }
+    length = prefixLength + (size_t) messageLength;
 
-void log_setFileLevel(log_level_t level) {
-    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+    if (length + 1 >= sizeof(logRenderBuffer)) {
+        // The message does not fit, so format it again into a buffer of
+        // the proper size. If that fails, log the truncated message.
+        char *pLargeBuffer = malloc(length + 2);
 
-    logLevelFile = level;
-} // log_setFileLevel()
+        if (NULL == pLargeBuffer) {
+            length = sizeof(logRenderBuffer) - 2;
+        } else {
+            memcpy(pLargeBuffer, pBuffer, prefixLength);
+            (void) vsnprintf(pLargeBuffer + prefixLength, (size_t) messageLength + 1,
+                             format, argcopy);
+            pBuffer = pLargeBuffer;
+        }
+    }
+    va_end(argcopy);
 
+    if (addEOL) {
+        pBuffer[length++] = '\n';
+    }
 
+    log_dispatch(level, pBuffer, length,
+                 addPrefix ? prefixLength - strlen(logLevelPrefixes[level]) : 0);
 
-void log_setStderrLevel(log_level_t level) {
-    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+    if (pBuffer != logRenderBuffer) {
+        free(pBuffer);
+    }
+} // log_render()
 
-    logLevelStderr = level;
-} // log_setStderrLevel()
 
 
+/** Hands the line assembled by the calling thread to the channels. */
+static void log_flushLine(void) {
+    if (0 != logLineLength) {
+        log_dispatch(logLineLevel, logLineBuffer, logLineLength, logLineTimestampLength);
+        logLineLength = 0;
+        logLineTimestampLength = 0;
+    }
+} // log_flushLine()
 
-void log_setStdoutLevel(log_level_t level) {
-    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
 
-    logLevelStdout = level;
-} // log_setStdoutLevel()
 
+/** Starts a new line of a multi-part message for the calling thread with
+    the text describing the level. A pending line is handed to the channels
+    first.
 
+    @param level The level of the message.
+ */
+static void log_startLine(log_level_t level) {
+    log_flushLine();
+    logLineLevel = level;
+    logLineLength = log_formatPrefix(logLineBuffer, level);
+    logLineTimestampLength = logLineLength - strlen(logLevelPrefixes[level]);
+} // log_startLine()
 
-void log_setStdoutSupression(bool suppress) {
-    logSuppressStdout = suppress;
-} // log_setStdoutSupression()
 
 
+/** Appends a part of a multi-part message to the line of the calling thread.
 
-void log_logVMessageContinue(log_level_t level, char const *format, va_list arglist) {
-    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
-    assert(NULL != format);
+    The line is handed to the channels as one record once a part ends with
+    an EOL marker, so lines of concurrent threads do not interleave. A
+    part too long for the line buffer is handed over on its own.
 
-    if (logLevelStderr <= level) {
-        (void) vfprintf(stderr, format, arglist);
+    @param level The level of the message.
+    @param addPrefix Start a new line with the text describing the level?
+    @param format A format string as used by @see printf
+    @param arglist A list of parameters as used by @see vprintf
+ */
+static void log_appendLine(log_level_t level, bool addPrefix,
+                           char const *format, va_list arglist) {
+    int partLength = 0;
+    va_list argcopy;
+
+    if (addPrefix) {
+        log_startLine(level);
+    } else if (0 == logLineLength) {
+        logLineLevel = level;
     }
-    if (logLevelStdout <= level) {
-        // If suppression is active, log only what has not been output to stderr.
-        if (!logSuppressStdout || (logLevelStderr > level)) {
-            (void) vprintf(format, arglist);
+
+    va_copy(argcopy, arglist);
+    partLength = vsnprintf(logLineBuffer + logLineLength,
+                           sizeof(logLineBuffer) - logLineLength,
+                           format, arglist);
+    if (partLength < 0) {
+        // Invalid format string.
+    } else if (logLineLength + (size_t) partLength < sizeof(logLineBuffer)) {
+        logLineLength += (size_t) partLength;
+        if ((partLength > 0) && ('\n' == logLineBuffer[logLineLength - 1])) {
+            log_flushLine();
         }
+    } else {
+        log_flushLine();
+        log_render(logLineLevel, false, false, format, argcopy);
     }
-    if ((logLevelFile <= level) && (NULL != logFileHandle)) {
-        (void) vfprintf(logFileHandle, format, arglist);
-        (void) fflush(logFileHandle);
+    va_end(argcopy);
+} // log_appendLine()
+
+
+
+void log_logVMessageContinue(log_level_t level, char const *format, va_list arglist) {
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != format);
+
+    if (level < logMinimumLevel) {
+        return;
     }
+
+    log_appendLine(level, false, format, arglist);
 } // log_logVMessageContinue()
 
 
@@ -201,6 +2392,10 @@ void log_logMessageContinue_impl(log_level_t level, char const *format, ...) {
     //lint --e{438} args is changed by the macros.
     va_list args;
 
+    if (level < logMinimumLevel) {
+        return;
+    }
+
     //lint -e{530} va_start initializes 'args'
     va_start(args, format);
     log_logVMessageContinue(level, format, args);
@@ -209,49 +2404,13 @@ void log_logMessageContinue_impl(log_level_t level, char const *format, ...) {
 
 
 void log_logLevelStart(log_level_t level) {
-    char const *prepend_string;
-
     assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
 
-    // Note: this could be made more efficient using table-lookup in a
-    // string table. The switch/case has the advantage of causing a run-time
-    // error if the strings and log_level_t get out of sync.
-    switch (level) {
-        case LOGLEVEL_DEBUG3:
-            prepend_string = "DEBUG3: ";
-            break;
-        case LOGLEVEL_DEBUG2:
-            prepend_string = "DEBUG2: ";
-            break;
-        case LOGLEVEL_DEBUG1:
-            prepend_string = "DEBUG1: ";
-            break;
-        case LOGLEVEL_DEBUG:
-            prepend_string = "DEBUG: ";
-            break;
-        case LOGLEVEL_INFO:
-            prepend_string = "INFO: ";
-            break;
-        case LOGLEVEL_WARNING:
-            prepend_string = "WARNING: ";
-            break;
-        case LOGLEVEL_ERROR:
-            prepend_string = "ERROR: ";
-            break;
-        case LOGLEVEL_FATAL:
-            prepend_string = "FATAL ERROR: ";
-            break;
-        case LOGLEVEL_ALWAYS:
-            prepend_string = "ALWAYS: ";
-            break;
-        case LOGLEVEL_NONE:
-            //!fallthrough
-        default:
-            //lint -e{237,506} This is intended to fail.
-            assert(false);
-            return;
-    } // switch (level)
-    log_logMessageContinue_impl(level, prepend_string);
+    if (level < logMinimumLevel) {
+        return;
+    }
+
+    log_startLine(level);
 } // log_logLevelStart()
 
 
@@ -259,8 +2418,11 @@ void log_logVMessageStart(log_level_t level, char const *format, va_list arglist
     assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
     assert(NULL != format);
 
-    log_logLevelStart(level);
-    log_logVMessageContinue(level, format, arglist);
+    if (level < logMinimumLevel) {
+        return;
+    }
+
+    log_appendLine(level, true, format, arglist);
 } // log_logVMessageStart()
 
 
@@ -269,6 +2431,10 @@ void log_logMessageStart_impl(log_level_t level, char const *format, ...) {
     //lint --e{438} args is changed by the macros.
     va_list args;
 
+    if (level < logMinimumLevel) {
+        return;
+    }
+
     //lint -e{530} va_start initializes 'args'
     va_start(args, format);
     log_logVMessageStart(level, format, args);
@@ -277,89 +2443,246 @@ void log_logMessageStart_impl(log_level_t level, char const *format, ...) {
 
 
 
+void log_setSamplingSummary(bool enable) {
+    logSamplingSummary = enable;
+} // log_setSamplingSummary()
+
+
+
+bool log_checkSample(log_sample_site_t *pSite, log_level_t level, unsigned long *pNumber) {
+    unsigned long number;
+
+    assert(NULL != pSite);
+    assert(0 != pSite->rate);
+    assert(NULL != pNumber);
+
+    if (level < logMinimumLevel) {
+        return false;
+    }
+
+#if LOGGING_THREADS
+    number = atomic_fetch_add_explicit(&pSite->counter, 1, memory_order_relaxed);
+#else
+    number = pSite->counter++;
+#endif // !LOGGING_THREADS
+    *pNumber = number;
+    return 0 == number % pSite->rate;
+} // log_checkSample()
+
+
+
+void log_logSampled_impl(log_sample_site_t const *pSite, unsigned long number,
+                         log_level_t level, char const *format, ...) {
+    //lint --e{438} args is changed by the macros.
+    va_list args;
+
+    assert(NULL != pSite);
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != format);
+
+    if (level < logMinimumLevel) {
+        return;
+    }
+
+    va_start(args, format);
+    if (logSamplingSummary && (0 != number)) {
+        // All messages before this one except the sampled ones were
+        // skipped. The summary completes the line of the message.
+        unsigned long nrSkipped = number - number / pSite->rate;
+
+        log_appendLine(level, true, format, args);
+        log_logMessageContinue_impl(level, " (%lu skipped)\n", nrSkipped);
+    } else {
+        log_flushLine();
+        log_render(level, true, true, format, args);
+    }
+    va_end(args);
+} // log_logSampled_impl()
+
+
+
+char const *log_getLevelPrefix(log_level_t level) {
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+
+    return logLevelPrefixes[level];
+} // log_getLevelPrefix()
+
+
+
+bool log_isLevelEnabled(log_level_t level) {
+    return level >= logMinimumLevel;
+} // log_isLevelEnabled()
+
+
+
+void log_logVMessage(log_level_t level, char const *format, va_list arglist) {
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != format);
+
+    if (level < logMinimumLevel) {
+        return;
+    }
+
+    // Keep the order of the messages of this thread.
+    log_flushLine();
+    log_render(level, true, true, format, arglist);
+} // log_logVMessage()
+
+
+
 void log_logMessage_impl(log_level_t level, char const *format, ...) {
     //lint --e{438} args is changed by the macros.
     va_list args;
 
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != format);
+
+    // Discard the message before paying for any formatting.
+    if (level < logMinimumLevel) {
+        return;
+    }
+
+    // Keep the order of the messages of this thread.
+    log_flushLine();
     va_start(args, format);
-    log_logVMessageStart(level, format, args);
+    log_render(level, true, true, format, args);
     va_end(args);
-    log_logMessageContinue_impl(level, "\n");
 } // log_logMessage_impl()
 
 
 
-void log_logData(log_level_t level,
+void log_logCategory_impl(log_level_t level, char const *format, ...) {
+    //lint --e{438} args is changed by the macros.
+    va_list args;
+
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != format);
+
+    // The category has accepted the level, only the channels decide.
+    if (level < logAcceptedLevel) {
+        return;
+    }
+
+    log_flushLine();
+    va_start(args, format);
+    log_render(level, true, true, format, args);
+    va_end(args);
+} // log_logCategory_impl()
+
+
+
+void log_logDataLimited(log_level_t level,
                         char const *pData,
                         size_t nrOfBytes,
                         char const *prefixStr,
-                        size_t hexWidth) {
-#ifndef FTR_LOG_GLOBAL_BUFFER
-    static char debugBuffer[FTR_LOG_BUFFER_SIZE];
-#endif // !FTR_LOG_GLOBAL_BUFFER
-    bool firstLine = true;
-    unsigned prefixLen, i;
-
+                        size_t hexWidth,
+                        size_t maxBytes) {
+    char linePrefix[LOG_TIMESTAMP_LENGTH + 32];
+    char *pBuffer = logRenderBuffer, *pOut;
+    size_t linePrefixLength, timestampLength, prefixLength, indentLength;
+    size_t shownBytes = nrOfBytes, nrOfLines, bufferSize, i;
 
     assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
     assert(NULL != pData);
     assert(NULL != prefixStr);
-    assert(hexWidth*3 + 3 < sizeof(debugBuffer));
+    assert(hexWidth > 0);
+
+    if (level < logMinimumLevel) {
+        return;
+    }
 
     // Special handling for no data.
     if (0 == nrOfBytes) {
-#if 0 == LOGGING_API_USES_VARIADIC_MACROS
-        log_logMessage((level, "%s (None)", prefixStr));
-#else
-        log_logMessage(level, "%s (None)", prefixStr);
-#endif // LOGGING_API_USES_VARIADIC_MACROS
+        log_logMessage_impl(level, "%s (None)", prefixStr);
         return;
     }
 
-    prefixLen = (unsigned) strlen(prefixStr);
-
-    while (nrOfBytes > 0) {
-        // Calculate the most bytes that will fit into the buffer.
-        size_t chunkSize = hexWidth;
+    // A partial line of this thread goes first.
+    log_flushLine();
 
-        if (nrOfBytes < chunkSize) {
-            chunkSize = nrOfBytes;
-        }
-
-        if (hexbuf2String(pData, chunkSize,
-                          debugBuffer, sizeof(debugBuffer),
-                          USE_CRLF, false,          // CRLF, no ASCII
-                          (unsigned) hexWidth,      // linewidth
-                          false, 0)                 // show no offset, offset = 0
-             == NULL) {
-#if 0 == LOGGING_API_USES_VARIADIC_MACROS
-                log_logMessage((LOGLEVEL_ERROR,
-                        "tcp_log_data(): unable to hexify buffer"));
-#else
-                log_logMessage(LOGLEVEL_ERROR,
-                       "tcp_log_data(): unable to hexify buffer");
-#endif // LOGGING_API_USES_VARIADIC_MACROS
+    if ((0 != maxBytes) && (shownBytes > maxBytes)) {
+        shownBytes = maxBytes;
+    }
+    linePrefixLength = log_formatPrefix(linePrefix, level);
+    timestampLength = linePrefixLength - strlen(logLevelPrefixes[level]);
+    prefixLength = strlen(prefixStr);
+    // The first line continues the prefix with a space, the following ones
+    // are indented by as many spaces.
+    indentLength = prefixLength + 1;
+
+    // Each line of the dump is preceded by the line prefix and the
+    // indentation. The line telling about omitted bytes needs less than
+    // another line prefix, indentation and 64 characters.
+    nrOfLines = (shownBytes + hexWidth - 1) / hexWidth;
+    bufferSize = hexbuf2StringLength(shownBytes, false, false, (unsigned) hexWidth, false)
+                 + (nrOfLines + 1) * (linePrefixLength + indentLength) + 64;
+    if (bufferSize > sizeof(logRenderBuffer)) {
+        if (NULL == (pBuffer = malloc(bufferSize))) {
+            // Dump what fits into the buffer of this thread.
+            pBuffer = logRenderBuffer;
+            bufferSize = sizeof(logRenderBuffer);
+            if (linePrefixLength + indentLength + 64 + 1 >= bufferSize) {
+                // Not even the note on the omitted bytes fits.
+                return;
+            }
+            nrOfLines = (bufferSize - 64 - 1 - (linePrefixLength + indentLength))
+                        / (linePrefixLength + indentLength + 3 * hexWidth + 1);
+            if (0 == nrOfLines) {
                 return;
+            }
+            shownBytes = nrOfLines * hexWidth;
         }
-        // Remove the trailing CRLF because log_logMessage() will append it again.
-        debugBuffer[strlen(debugBuffer) - 2] = '\0';
-        if (firstLine) {
-#if 0 == LOGGING_API_USES_VARIADIC_MACROS
-            log_logMessage((level, "%s %s", prefixStr, debugBuffer));
-#else
-            log_logMessage(level, "%s %s", prefixStr, debugBuffer);
-#endif // LOGGING_API_USES_VARIADIC_MACROS
-            firstLine = false;
+    }
+
+    pOut = pBuffer;
+    for (i = 0; i < shownBytes; i += hexWidth) {
+        size_t chunkSize = (shownBytes - i < hexWidth) ? shownBytes - i : hexWidth;
+
+        memcpy(pOut, linePrefix, linePrefixLength);
+        pOut += linePrefixLength;
+        if (0 == i) {
+            memcpy(pOut, prefixStr, prefixLength);
+            pOut[prefixLength] = ' ';
         } else {
-            log_logLevelStart(level);
-            for (i = prefixLen + 1;i > 0;i --) {
-                log_logMessageContinue_impl(level, " ");
-            }
-            log_logMessageContinue_impl(level, debugBuffer);
-            log_logMessageContinue_impl(level, "\n");
+            memset(pOut, ' ', indentLength);
         }
+        pOut += indentLength;
+        // Each byte takes a space and two digits, the line ends with LF.
+        (void) hexbuf2String(pData + i, chunkSize,
+                             pOut, bufferSize - (size_t) (pOut - pBuffer),
+                             false, false,              // LF, no ASCII
+                             (unsigned) hexWidth,       // linewidth
+                             false, 0);                 // show no offset, offset = 0
+        pOut += 3 * chunkSize + 1;
+    } // for i
+
+    if (shownBytes < nrOfBytes) {
+        int noteLength;
+
+        memcpy(pOut, linePrefix, linePrefixLength);
+        pOut += linePrefixLength;
+        memset(pOut, ' ', indentLength);
+        pOut += indentLength;
+        noteLength = snprintf(pOut, 64, " ... %lu more bytes\n",
+                              (unsigned long) (nrOfBytes - shownBytes));
+        if (noteLength > 0) {
+            pOut += noteLength;
+        }
+    }
+
+    log_dispatch(level, pBuffer, (size_t) (pOut - pBuffer), timestampLength);
+
+    if (pBuffer != logRenderBuffer) {
+        free(pBuffer);
+    }
+} // log_logDataLimited()
+
 
-        nrOfBytes = nrOfBytes - chunkSize;
-        pData = pData + chunkSize;
-    } // while nrOfBytes > 0
+
+void log_logData(log_level_t level,
+                 char const *pData,
+                 size_t nrOfBytes,
+                 char const *prefixStr,
+                 size_t hexWidth) {
+    log_logDataLimited(level, pData, nrOfBytes, prefixStr, hexWidth, 0);
 } // log_logData()
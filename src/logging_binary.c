@@ -0,0 +1,894 @@
+/** Binary logging with deferred formatting.
+
+    Messages are recorded as the identifier of their call site, a timestamp
+    and the raw values of their arguments. The format strings are written
+    once per call site, formatting happens offline in log_decodeBinary().
+
+
+    @file logging_binary.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "legetset.h"
+#include "logging.h"
+
+#if LOGGING_THREADS
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif // LOGGING_THREADS
+
+#ifdef _MSC_VER
+// Disable warnings for functions VS C considers deprecated.
+#pragma warning(disable: 4996)
+#endif // _MSC_VER
+
+#ifdef _WIN32
+// Provided by winsix_clock_gettime.c.
+extern int clock_gettime(int option, struct timespec *pTS);
+#define CLOCK_REALTIME 0
+#endif // _WIN32
+
+
+/** The first bytes of every binary log file. */
+#define LOG_BINARY_MAGIC "MLB1"
+/** Tags the record defining a call site. */
+#define LOG_BINARY_DEFINITION 'D'
+/** Tags the record of a message. */
+#define LOG_BINARY_MESSAGE 'M'
+/** The largest record of a message. Strings are truncated to fit. */
+#define LOG_BINARY_RECORD_SIZE 1024
+/** The length stored for a NULL string. */
+#define LOG_BINARY_NULL_STRING 0xffffu
+/** Marks a call site whose format string can not be logged in binary. */
+#define LOG_BINARY_UNSUPPORTED 0xffu
+/** The decoder rejects a definition whose id is this far beyond the
+    definitions seen so far; call site ids are assigned consecutively. */
+#define LOG_BINARY_MAX_ID_GAP 0x10000u
+
+
+/** The types of arguments, as passed through the variadic argument list. */
+typedef enum {
+    /** The conversion takes no argument, i.e. %%. */
+    LOG_ARG_NONE = 0,
+    /** int, also used for char and short, which are promoted. */
+    LOG_ARG_INT,
+    /** long */
+    LOG_ARG_LONG,
+    /** long long */
+    LOG_ARG_LLONG,
+    /** size_t */
+    LOG_ARG_SIZE,
+    /** intmax_t */
+    LOG_ARG_INTMAX,
+    /** ptrdiff_t */
+    LOG_ARG_PTRDIFF,
+    /** double, also used for float, which is promoted. */
+    LOG_ARG_DOUBLE,
+    /** long double, recorded as double. */
+    LOG_ARG_LDOUBLE,
+    /** char const *, recorded as the string. */
+    LOG_ARG_STRING,
+    /** void *, recorded as its address. */
+    LOG_ARG_POINTER
+} log_arg_type_t;
+
+/** A conversion specification in a format string. */
+typedef struct {
+    /** The '%' starting the specification. */
+    char const *pStart;
+    /** The character following the specification. */
+    char const *pEnd;
+    /** The number of '*' for width and precision, each takes an int. */
+    unsigned nrStars;
+    /** The type of the converted argument. */
+    log_arg_type_t type;
+} log_conversion_t;
+
+
+/** The binary log file or NULL if none is open.
+
+    Threads announce their use of the handle in logBinaryUsers, like the
+    text log file, so it is closed only once no thread writes to it.
+ */
+static LOGGING_ATOMIC(FILE *) logBinaryFile = NULL;
+/** Selects the counter in logBinaryUsers new users increment. */
+static LOGGING_ATOMIC(unsigned) logBinaryEpoch = 0;
+/** The number of threads using logBinaryFile, by epoch. */
+static LOGGING_ATOMIC(unsigned) logBinaryUsers[2];
+/** The lowest level written to the binary log file. */
+static log_level_t logBinaryLevel = LOGLEVEL_NONE;
+/** Incremented for every binary log file opened. */
+static LOGGING_ATOMIC(unsigned) logBinaryGeneration = 0;
+/** The last identifier assigned to a call site. */
+static uint32_t logBinaryLastId = 0;
+#if LOGGING_THREADS
+/** Serializes the definition of call sites. */
+static pthread_mutex_t logBinaryMutex = PTHREAD_MUTEX_INITIALIZER;
+/** Serializes opening and closing the binary log file. */
+static pthread_mutex_t logBinaryFileMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif // LOGGING_THREADS
+
+
+
+/** Announces the use of the binary log file by the calling thread.
+
+    @param ppFile Receives the binary log file or NULL if none is open.
+    @return The epoch to pass to #log_binaryRelease.
+ */
+static unsigned log_binaryAcquire(FILE **ppFile) {
+    unsigned epoch;
+
+    for (;;) {
+        epoch = logBinaryEpoch;
+        logBinaryUsers[epoch & 1]++;
+        if (epoch == logBinaryEpoch) {
+            break;
+        }
+        // The handle is being exchanged, count this use for the new epoch.
+        logBinaryUsers[epoch & 1]--;
+    }
+
+    *ppFile = logBinaryFile;
+    return epoch;
+} // log_binaryAcquire()
+
+
+
+/** Ends the use of the binary log file announced by #log_binaryAcquire.
+
+    @param epoch The value returned by #log_binaryAcquire.
+ */
+static void log_binaryRelease(unsigned epoch) {
+    logBinaryUsers[epoch & 1]--;
+} // log_binaryRelease()
+
+
+
+/** Replaces the binary log file, waiting until no thread uses the old one.
+
+    The caller must hold logBinaryFileMutex.
+
+    @param pFile The new binary log file or NULL.
+    @return The old binary log file, which is no longer in use, or NULL.
+ */
+static FILE *log_binaryExchange(FILE *pFile) {
+    FILE *pOldFile;
+    unsigned epoch;
+
+#if LOGGING_THREADS
+    pOldFile = atomic_exchange(&logBinaryFile, pFile);
+#else
+    pOldFile = logBinaryFile;
+    logBinaryFile = pFile;
+#endif // !LOGGING_THREADS
+
+    epoch = logBinaryEpoch++;
+    while (0 != logBinaryUsers[epoch & 1]) {
+#if LOGGING_THREADS
+        (void) sched_yield();
+#endif // LOGGING_THREADS
+    }
+    return pOldFile;
+} // log_binaryExchange()
+
+
+
+/** Parses the next conversion specification of a format string.
+
+    @param pFormat The position in the format string to start searching.
+    @param pConversion Receives the specification.
+    @return Was a specification found? False at the end of the string or if
+        the specification is not supported.
+ */
+static bool log_binaryNextConversion(char const *pFormat, log_conversion_t *pConversion) {
+    char const *p;
+    log_arg_type_t integerType = LOG_ARG_INT;
+    bool longDouble = false;
+
+    if (NULL == (p = strchr(pFormat, '%'))) {
+        return false;
+    }
+    pConversion->pStart = p++;
+    pConversion->nrStars = 0;
+
+    // Flags, width and precision.
+    while ((NULL != strchr("-+ #0", *p)) && ('\0' != *p)) {
+        p++;
+    }
+    if ('*' == *p) {
+        pConversion->nrStars++;
+        p++;
+    }
+    while ((*p >= '0') && (*p <= '9')) {
+        p++;
+    }
+    if ('.' == *p) {
+        p++;
+        if ('*' == *p) {
+            pConversion->nrStars++;
+            p++;
+        }
+        while ((*p >= '0') && (*p <= '9')) {
+            p++;
+        }
+    }
+
+    // Length modifier.
+    switch (*p) {
+        case 'h':
+            p += ('h' == p[1]) ? 2 : 1;
+            break;
+        case 'l':
+            if ('l' == p[1]) {
+                integerType = LOG_ARG_LLONG;
+                p += 2;
+            } else {
+                integerType = LOG_ARG_LONG;
+                p++;
+            }
+            break;
+        case 'z':
+            integerType = LOG_ARG_SIZE;
+            p++;
+            break;
+        case 'j':
+            integerType = LOG_ARG_INTMAX;
+            p++;
+            break;
+        case 't':
+            integerType = LOG_ARG_PTRDIFF;
+            p++;
+            break;
+        case 'L':
+            longDouble = true;
+            p++;
+            break;
+        default:
+            break;
+    } // switch length modifier
+
+    // Conversion.
+    switch (*p) {
+        case '%':
+            pConversion->type = LOG_ARG_NONE;
+            break;
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            pConversion->type = integerType;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            pConversion->type = longDouble ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+            break;
+        case 'c':
+            if (LOG_ARG_INT != integerType) {
+                // %lc takes a wint_t.
+                return false;
+            }
+            pConversion->type = LOG_ARG_INT;
+            break;
+        case 's':
+            if (LOG_ARG_INT != integerType) {
+                // %ls takes a wchar_t string.
+                return false;
+            }
+            pConversion->type = LOG_ARG_STRING;
+            break;
+        case 'p':
+            pConversion->type = LOG_ARG_POINTER;
+            break;
+        default:
+            // %n, wide characters and unknown conversions.
+            return false;
+    } // switch conversion
+    pConversion->pEnd = p + 1;
+
+    return true;
+} // log_binaryNextConversion()
+
+
+
+/** Stores a 64 bit value in little-endian byte order.
+
+    @param pDest The address to store the value at.
+    @param value The value.
+ */
+static void log_binarySetUint64(unsigned char *pDest, uint64_t value) {
+    leSetUint32(pDest, (uint_fast32_t) (value & 0xffffffffu));
+    leSetUint32(pDest + 4, (uint_fast32_t) (value >> 32));
+} // log_binarySetUint64()
+
+
+
+/** Retrieves a 64 bit value stored in little-endian byte order.
+
+    @param pSrc The address of the value.
+    @return The value.
+ */
+static uint64_t log_binaryGetUint64(unsigned char const *pSrc) {
+    return (uint64_t) leGetUint32(pSrc) | ((uint64_t) leGetUint32(pSrc + 4) << 32);
+} // log_binaryGetUint64()
+
+
+
+/** Determines the argument types of a call site and writes its
+    definition to the binary log file.
+
+    @param pSite The call site.
+    @param format The format string of the call site.
+    @param pFile The binary log file.
+ */
+static void log_binaryDefine(log_binary_site_t *pSite, char const *format, FILE *pFile) {
+    log_conversion_t conversion;
+    unsigned char header[1 + 4 + 1 + 4 + 2];
+    size_t fileLength = strlen(pSite->file);
+    size_t formatLength = strlen(format);
+    unsigned nrArgs = 0;
+    char const *p = format;
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logBinaryMutex);
+#endif // LOGGING_THREADS
+
+    if (pSite->generation != logBinaryGeneration) {
+        if (0 == pSite->id) {
+            pSite->id = ++logBinaryLastId;
+        }
+
+        // Determine the types of the arguments.
+        while (log_binaryNextConversion(p, &conversion)) {
+            unsigned i;
+
+            for (i = 0; i < conversion.nrStars; i++) {
+                if (nrArgs < LOG_BINARY_MAX_ARGS) {
+                    pSite->argTypes[nrArgs] = LOG_ARG_INT;
+                }
+                nrArgs++;
+            }
+            if (LOG_ARG_NONE != conversion.type) {
+                if (nrArgs < LOG_BINARY_MAX_ARGS) {
+                    pSite->argTypes[nrArgs] = (unsigned char) conversion.type;
+                }
+                nrArgs++;
+            }
+            p = conversion.pEnd;
+        }
+        if ((NULL != strchr(p, '%')) || (nrArgs > LOG_BINARY_MAX_ARGS)
+            || (fileLength > 0xffff) || (formatLength > 0xffff)) {
+            // Leave this call site to the text log.
+            pSite->nrArgs = LOG_BINARY_UNSUPPORTED;
+        } else {
+            size_t recordLength = sizeof(header) + fileLength + 2 + formatLength;
+            unsigned char *pRecord = malloc(recordLength);
+
+            pSite->nrArgs = (unsigned char) nrArgs;
+
+            if (NULL == pRecord) {
+                // Try again with the next message.
+#if LOGGING_THREADS
+                (void) pthread_mutex_unlock(&logBinaryMutex);
+#endif // LOGGING_THREADS
+                pSite->nrArgs = LOG_BINARY_UNSUPPORTED;
+                return;
+            }
+
+            // Assemble the record so it is written in one piece.
+            header[0] = LOG_BINARY_DEFINITION;
+            leSetUint32(&header[1], pSite->id);
+            header[5] = (unsigned char) pSite->level;
+            leSetUint32(&header[6], pSite->line);
+            leSetUint16(&header[10], (uint_fast16_t) fileLength);
+            memcpy(pRecord, header, sizeof(header));
+            memcpy(pRecord + sizeof(header), pSite->file, fileLength);
+            leSetUint16(pRecord + sizeof(header) + fileLength, (uint_fast16_t) formatLength);
+            memcpy(pRecord + sizeof(header) + fileLength + 2, format, formatLength);
+            (void) fwrite(pRecord, 1, recordLength, pFile);
+            free(pRecord);
+        }
+
+        // Publish the definition only after it was written, and not when
+        // it went to a file that is being replaced.
+        if (pFile == logBinaryFile) {
+            pSite->generation = logBinaryGeneration;
+        }
+    }
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logBinaryMutex);
+#endif // LOGGING_THREADS
+} // log_binaryDefine()
+
+
+
+bool log_openBinaryLogfile(char const *filename, log_level_t level) {
+    FILE *pFile, *pOldFile;
+    bool failed = false;
+
+    assert(NULL != filename);
+    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+
+    if (NULL == (pFile = fopen(filename, "wb"))) {
+        fprintf(stderr, "ERROR: Unable to open binary logfile '%s' for write: %s\n", filename, strerror(errno));
+        return true;
+    }
+    (void) fwrite(LOG_BINARY_MAGIC, 1, strlen(LOG_BINARY_MAGIC), pFile);
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logBinaryFileMutex);
+    // No call site may define itself while the generation changes.
+    (void) pthread_mutex_lock(&logBinaryMutex);
+#endif // LOGGING_THREADS
+    logBinaryLevel = level;
+    // All call sites must write their definitions to the new file.
+    logBinaryGeneration++;
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logBinaryMutex);
+#endif // LOGGING_THREADS
+    pOldFile = log_binaryExchange(pFile);
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logBinaryFileMutex);
+#endif // LOGGING_THREADS
+
+    if ((NULL != pOldFile) && (fclose(pOldFile) != 0)) {
+        failed = true;
+    }
+    return failed;
+} // log_openBinaryLogfile()
+
+
+
+bool log_closeBinaryLogfile(void) {
+    FILE *pFile;
+
+    assert(NULL != logBinaryFile);
+
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logBinaryFileMutex);
+#endif // LOGGING_THREADS
+    pFile = log_binaryExchange(NULL);
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logBinaryFileMutex);
+#endif // LOGGING_THREADS
+
+    if ((NULL == pFile) || (fclose(pFile) != 0)) {
+        return true;
+    }
+    return false;
+} // log_closeBinaryLogfile()
+
+
+
+void log_logBinary_impl(log_binary_site_t *pSite, char const *format, ...) {
+    unsigned char record[LOG_BINARY_RECORD_SIZE];
+    unsigned char *pRecord = record;
+    struct timespec now;
+    va_list args;
+    FILE *pFile;
+    unsigned epoch, i;
+
+    assert(NULL != pSite);
+    assert(NULL != format);
+
+    epoch = log_binaryAcquire(&pFile);
+    if (NULL == pFile) {
+        log_binaryRelease(epoch);
+        // Without a binary log file, this is an ordinary message.
+        va_start(args, format);
+        log_logVMessage(pSite->level, format, args);
+        va_end(args);
+        return;
+    }
+    if (pSite->level < logBinaryLevel) {
+        log_binaryRelease(epoch);
+        return;
+    }
+
+    if (pSite->generation != logBinaryGeneration) {
+        log_binaryDefine(pSite, format, pFile);
+    }
+    if (LOG_BINARY_UNSUPPORTED == pSite->nrArgs) {
+        log_binaryRelease(epoch);
+        va_start(args, format);
+        log_logVMessage(pSite->level, format, args);
+        va_end(args);
+        return;
+    }
+
+    // Record header: tag, call site and timestamp in ns.
+    (void) clock_gettime(CLOCK_REALTIME, &now);
+    *pRecord++ = LOG_BINARY_MESSAGE;
+    leSetUint32(pRecord, pSite->id);
+    pRecord += 4;
+    log_binarySetUint64(pRecord, (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec);
+    pRecord += 8;
+
+    // The raw arguments. Numbers take 8 bytes each, strings are prefixed
+    // with their length.
+    va_start(args, format);
+    for (i = 0; i < pSite->nrArgs; i++) {
+        uint64_t value = 0;
+
+        switch ((log_arg_type_t) pSite->argTypes[i]) {
+            case LOG_ARG_INT:
+                value = (uint64_t) (int64_t) va_arg(args, int);
+                break;
+            case LOG_ARG_LONG:
+                value = (uint64_t) (int64_t) va_arg(args, long);
+                break;
+            case LOG_ARG_LLONG:
+                value = (uint64_t) va_arg(args, long long);
+                break;
+            case LOG_ARG_SIZE:
+                value = (uint64_t) va_arg(args, size_t);
+                break;
+            case LOG_ARG_INTMAX:
+                value = (uint64_t) va_arg(args, intmax_t);
+                break;
+            case LOG_ARG_PTRDIFF:
+                value = (uint64_t) (int64_t) va_arg(args, ptrdiff_t);
+                break;
+            case LOG_ARG_DOUBLE:
+            case LOG_ARG_LDOUBLE: {
+                double d = (LOG_ARG_DOUBLE == pSite->argTypes[i])
+                    ? va_arg(args, double)
+                    : (double) va_arg(args, long double);
+
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+            case LOG_ARG_POINTER:
+                value = (uint64_t) (uintptr_t) va_arg(args, void *);
+                break;
+            case LOG_ARG_STRING: {
+                char const *pString = va_arg(args, char const *);
+                size_t available = (size_t) (record + sizeof(record) - pRecord)
+                    - 2 - 8 * (pSite->nrArgs - i - 1u);
+                size_t length;
+
+                if (NULL == pString) {
+                    leSetUint16(pRecord, LOG_BINARY_NULL_STRING);
+                    pRecord += 2;
+                    continue;
+                }
+                length = strlen(pString);
+                if (length > available) {
+                    // Truncate, leaving room for the remaining numbers.
+                    length = available;
+                }
+                leSetUint16(pRecord, (uint_fast16_t) length);
+                memcpy(pRecord + 2, pString, length);
+                pRecord += 2 + length;
+                continue;
+            }
+            case LOG_ARG_NONE:
+                //!fallthrough
+            default:
+                assert(false);
+                break;
+        } // switch argType
+
+        log_binarySetUint64(pRecord, value);
+        pRecord += 8;
+    } // for i
+    va_end(args);
+
+    // One write per record keeps records of different threads apart.
+    (void) fwrite(record, 1, (size_t) (pRecord - record), pFile);
+    log_binaryRelease(epoch);
+} // log_logBinary_impl()
+
+
+
+/** Reads exactly the given number of bytes.
+
+    @param pInput The file to read from.
+    @param pBuffer Receives the bytes.
+    @param length The number of bytes to read.
+    @return Did an error occur?
+ */
+static bool log_binaryRead(FILE *pInput, void *pBuffer, size_t length) {
+    return fread(pBuffer, 1, length, pInput) != length;
+} // log_binaryRead()
+
+
+
+/** Skips the given number of bytes.
+
+    The input is read rather than repositioned, so pipes work as well.
+
+    @param pInput The file to read from.
+    @param length The number of bytes to skip.
+    @return Did an error occur?
+ */
+static bool log_binarySkip(FILE *pInput, size_t length) {
+    unsigned char buffer[256];
+    size_t chunk;
+
+    while (length > 0) {
+        chunk = (length < sizeof(buffer)) ? length : sizeof(buffer);
+        if (log_binaryRead(pInput, buffer, chunk)) {
+            return true;
+        }
+        length -= chunk;
+    }
+    return false;
+} // log_binarySkip()
+
+
+
+/** Formats a single conversion with its arguments read from a record.
+
+    @param pInput The binary log file, positioned at the arguments.
+    @param pOutput Receives the text.
+    @param pConversion The conversion.
+    @param pString A buffer for strings, at least 64 KiB.
+    @return Did an error occur?
+ */
+static bool log_binaryDecodeConversion(FILE *pInput, FILE *pOutput,
+                                       log_conversion_t const *pConversion,
+                                       char *pString) {
+    char spec[32];
+    int stars[2] = { 0, 0 };
+    unsigned char bytes[8];
+    size_t specLength = (size_t) (pConversion->pEnd - pConversion->pStart);
+    uint64_t value = 0;
+    unsigned i;
+
+    if (specLength >= sizeof(spec)) {
+        return true;
+    }
+    memcpy(spec, pConversion->pStart, specLength);
+    spec[specLength] = '\0';
+
+    for (i = 0; i < pConversion->nrStars; i++) {
+        if (log_binaryRead(pInput, bytes, 8)) {
+            return true;
+        }
+        stars[i] = (int) log_binaryGetUint64(bytes);
+    }
+
+    if (LOG_ARG_STRING == pConversion->type) {
+        uint_fast16_t length;
+
+        if (log_binaryRead(pInput, bytes, 2)) {
+            return true;
+        }
+        length = leGetUint16(bytes);
+        if (LOG_BINARY_NULL_STRING == length) {
+            strcpy(pString, "(null)");
+        } else {
+            if (log_binaryRead(pInput, pString, length)) {
+                return true;
+            }
+            pString[length] = '\0';
+        }
+    } else if (LOG_ARG_NONE != pConversion->type) {
+        if (log_binaryRead(pInput, bytes, 8)) {
+            return true;
+        }
+        value = log_binaryGetUint64(bytes);
+    }
+
+    // Let printf do the formatting, passing the argument with the type the
+    // conversion expects.
+#define LOG_BINARY_PRINT(arg) \
+    do { \
+        switch (pConversion->nrStars) { \
+            case 0: (void) fprintf(pOutput, spec, arg); break; \
+            case 1: (void) fprintf(pOutput, spec, stars[0], arg); break; \
+            default: (void) fprintf(pOutput, spec, stars[0], stars[1], arg); break; \
+        } \
+    } while (0)
+
+    switch (pConversion->type) {
+        case LOG_ARG_NONE:
+            (void) fputc('%', pOutput);
+            break;
+        case LOG_ARG_INT:
+            LOG_BINARY_PRINT((int) (int64_t) value);
+            break;
+        case LOG_ARG_LONG:
+            LOG_BINARY_PRINT((long) (int64_t) value);
+            break;
+        case LOG_ARG_LLONG:
+            LOG_BINARY_PRINT((long long) value);
+            break;
+        case LOG_ARG_SIZE:
+            LOG_BINARY_PRINT((size_t) value);
+            break;
+        case LOG_ARG_INTMAX:
+            LOG_BINARY_PRINT((intmax_t) value);
+            break;
+        case LOG_ARG_PTRDIFF:
+            LOG_BINARY_PRINT((ptrdiff_t) value);
+            break;
+        case LOG_ARG_DOUBLE: {
+            double d;
+
+            memcpy(&d, &value, sizeof(d));
+            LOG_BINARY_PRINT(d);
+            break;
+        }
+        case LOG_ARG_LDOUBLE: {
+            double d;
+
+            memcpy(&d, &value, sizeof(d));
+            LOG_BINARY_PRINT((long double) d);
+            break;
+        }
+        case LOG_ARG_STRING:
+            LOG_BINARY_PRINT(pString);
+            break;
+        case LOG_ARG_POINTER:
+            LOG_BINARY_PRINT((void *) (uintptr_t) value);
+            break;
+        default:
+            return true;
+    } // switch type
+#undef LOG_BINARY_PRINT
+
+    return false;
+} // log_binaryDecodeConversion()
+
+
+
+bool log_decodeBinary(FILE *pInput, FILE *pOutput) {
+    /** The definition of a call site read from the file. */
+    typedef struct {
+        log_level_t level;
+        char *format;
+    } definition_t;
+    definition_t *pDefinitions = NULL;
+    size_t nrDefinitions = 0;
+    unsigned char header[12];
+    char *pString;
+    bool failed = true;
+    int tag;
+
+    assert(NULL != pInput);
+    assert(NULL != pOutput);
+
+    if (log_binaryRead(pInput, header, strlen(LOG_BINARY_MAGIC))
+        || (memcmp(header, LOG_BINARY_MAGIC, strlen(LOG_BINARY_MAGIC)) != 0)) {
+        return true;
+    }
+    if (NULL == (pString = malloc(0x10000))) {
+        return true;
+    }
+
+    while (EOF != (tag = fgetc(pInput))) {
+        if (LOG_BINARY_DEFINITION == tag) {
+            uint32_t id;
+            size_t length;
+
+            // Skip the source position, keep level and format.
+            if (log_binaryRead(pInput, header, 11)) {
+                goto done;
+            }
+            id = (uint32_t) leGetUint32(header);
+            if (id >= nrDefinitions) {
+                size_t nrNew;
+                definition_t *pNew;
+
+                // A corrupt id must not make the table wrap around.
+                if ((size_t) id - nrDefinitions >= LOG_BINARY_MAX_ID_GAP) {
+                    goto done;
+                }
+                nrNew = ((size_t) id + 1) * 2;
+                if (nrNew > SIZE_MAX / sizeof(definition_t)) {
+                    goto done;
+                }
+                if (NULL == (pNew = realloc(pDefinitions, nrNew * sizeof(definition_t)))) {
+                    goto done;
+                }
+                memset(pNew + nrDefinitions, 0, (nrNew - nrDefinitions) * sizeof(definition_t));
+                pDefinitions = pNew;
+                nrDefinitions = nrNew;
+            }
+            pDefinitions[id].level = (log_level_t) header[4];
+            length = leGetUint16(&header[9]);
+            if ((pDefinitions[id].level <= LOGLEVEL_NONE) || (pDefinitions[id].level > LOGLEVEL_ALWAYS)
+                || log_binarySkip(pInput, length)
+                || log_binaryRead(pInput, header, 2)) {
+                goto done;
+            }
+            length = leGetUint16(header);
+            free(pDefinitions[id].format);
+            if ((NULL == (pDefinitions[id].format = malloc(length + 1)))
+                || log_binaryRead(pInput, pDefinitions[id].format, length)) {
+                goto done;
+            }
+            pDefinitions[id].format[length] = '\0';
+        } else if (LOG_BINARY_MESSAGE == tag) {
+            log_conversion_t conversion;
+            char const *p;
+            uint32_t id;
+
+            // The timestamp is not part of the text format.
+            if (log_binaryRead(pInput, header, 12)) {
+                goto done;
+            }
+            id = (uint32_t) leGetUint32(header);
+            if ((id >= nrDefinitions) || (NULL == pDefinitions[id].format)) {
+                goto done;
+            }
+
+            (void) fputs(log_getLevelPrefix(pDefinitions[id].level), pOutput);
+            p = pDefinitions[id].format;
+            while (log_binaryNextConversion(p, &conversion)) {
+                (void) fwrite(p, 1, (size_t) (conversion.pStart - p), pOutput);
+                if (log_binaryDecodeConversion(pInput, pOutput, &conversion, pString)) {
+                    goto done;
+                }
+                p = conversion.pEnd;
+            }
+            (void) fputs(p, pOutput);
+            (void) fputc('\n', pOutput);
+        } else {
+            // Unknown record.
+            goto done;
+        }
+    } // while tag
+    failed = false;
+
+done:
+    while (nrDefinitions > 0) {
+        free(pDefinitions[--nrDefinitions].format);
+    }
+    free(pDefinitions);
+    free(pString);
+    return failed;
+} // log_decodeBinary()
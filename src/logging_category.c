@@ -0,0 +1,456 @@
+/** Log categories with levels of their own.
+
+    Categories register themselves when first used. Their levels can be set
+    by name at any time, before or after registration, and reloaded from a
+    configuration file.
+
+
+    @file logging_category.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#include <assert.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyvalue.h"
+#include "logging.h"
+
+#if LOGGING_THREADS
+#include <pthread.h>
+#include <semaphore.h>
+#endif // LOGGING_THREADS
+
+#ifdef _MSC_VER
+// Disable warnings for functions VS C considers deprecated.
+#pragma warning(disable: 4996)
+#endif // _MSC_VER
+
+
+/** The prefix of the keys configuring categories. */
+#define LOG_CATEGORY_SECTION "categories."
+/** The key configuring the default level. */
+#define LOG_CATEGORY_DEFAULT_KEY "default"
+
+
+/** The names of the levels as used in configuration files. */
+static char const * const logCategoryLevelNames[] = {
+    "NONE",             // LOGLEVEL_NONE
+    "DEBUG3",           // LOGLEVEL_DEBUG3
+    "DEBUG2",           // LOGLEVEL_DEBUG2
+    "DEBUG1",           // LOGLEVEL_DEBUG1
+    "DEBUG",            // LOGLEVEL_DEBUG
+    "INFO",             // LOGLEVEL_INFO
+    "WARNING",          // LOGLEVEL_WARNING
+    "ERROR",            // LOGLEVEL_ERROR
+    "FATAL",            // LOGLEVEL_FATAL
+    "ALWAYS"            // LOGLEVEL_ALWAYS
+};
+
+/** All registered categories. */
+static log_category_t *logCategories = NULL;
+/** The levels set by name, as integers keyed by the category name. */
+static kv_collection_t *logCategoryLevels = NULL;
+/** The levels of the last configuration file loaded, replaced on each load. */
+static kv_collection_t *logCategoryFileLevels = NULL;
+/** The level of categories without a level of their own. */
+static log_level_t logCategoryDefaultLevel = LOGLEVEL_DEBUG3;
+/** The configuration file loaded on request, or NULL. */
+static char *logCategoryConfigFile = NULL;
+/** Set by the signal handler to request loading the configuration file. */
+static volatile LOGGING_ATOMIC(int) logCategoryReloadRequested = 0;
+#if LOGGING_THREADS
+/** Protects the state of all categories. */
+static pthread_mutex_t logCategoryMutex = PTHREAD_MUTEX_INITIALIZER;
+/** Posted by the signal handler to wake the reload thread. */
+static sem_t logCategoryReloadSemaphore;
+/** Is the thread loading the configuration file on request running? */
+static bool logCategoryReloadThreadRunning = false;
+#endif // LOGGING_THREADS
+
+
+
+/** Locks the state of all categories. */
+static void log_lockCategories(void) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_lock(&logCategoryMutex);
+#endif // LOGGING_THREADS
+} // log_lockCategories()
+
+
+
+/** Unlocks the state of all categories. */
+static void log_unlockCategories(void) {
+#if LOGGING_THREADS
+    (void) pthread_mutex_unlock(&logCategoryMutex);
+#endif // LOGGING_THREADS
+} // log_unlockCategories()
+
+
+
+/** Determines the level a category of the given name uses.
+
+    The caller must hold the lock.
+
+    @param name The name of the category.
+    @return The level to store in the category.
+ */
+static log_level_t log_categoryLevel(char const *name) {
+    log_level_t level = logCategoryDefaultLevel;
+    kv_object_t *pObject = NULL;
+
+    // The configuration file overrides the levels set by name.
+    if (NULL != logCategoryFileLevels) {
+        pObject = kv_findObjectForKey(logCategoryFileLevels, name);
+    }
+    if ((NULL == pObject) && (NULL != logCategoryLevels)) {
+        pObject = kv_findObjectForKey(logCategoryLevels, name);
+    }
+    if (NULL != pObject) {
+        level = (log_level_t) kv_getIntValueFromObject(pObject);
+    }
+
+    // LOGLEVEL_NONE marks unregistered categories, so it must not be stored.
+    if (LOGLEVEL_NONE == level) {
+        level = LOGLEVEL_ALWAYS;
+    }
+    return level;
+} // log_categoryLevel()
+
+
+
+/** Recalculates the levels of all registered categories.
+
+    The caller must hold the lock.
+ */
+static void log_updateCategories(void) {
+    log_category_t *pCategory;
+
+    for (pCategory = logCategories; NULL != pCategory; pCategory = pCategory->next) {
+        pCategory->level = log_categoryLevel(pCategory->name);
+    }
+    // Messages without a category belong to the default category.
+    log_setUncategorizedLevel((LOGLEVEL_NONE == logCategoryDefaultLevel)
+                              ? LOGLEVEL_ALWAYS : logCategoryDefaultLevel);
+} // log_updateCategories()
+
+
+
+/** Converts the value of a configuration entry to a level.
+
+    @param pObject The configuration entry.
+    @param pLevel Receives the level.
+    @return Is the value invalid?
+ */
+static bool log_parseLevel(kv_object_t const *pObject, log_level_t *pLevel) {
+    size_t i;
+
+    switch (kv_getTypeFromObject(pObject)) {
+    case KV_VALUE_INTEGER: {
+        int value = kv_getIntValueFromObject(pObject);
+
+        if ((value < (int) LOGLEVEL_NONE) || (value > (int) LOGLEVEL_ALWAYS)) {
+            return true;
+        }
+        *pLevel = (log_level_t) value;
+        return false;
+    }
+
+    case KV_VALUE_STRING: {
+        char const *pName = kv_getStringValueFromObject(pObject);
+
+        for (i = 0; i < sizeof(logCategoryLevelNames) / sizeof(logCategoryLevelNames[0]); i++) {
+            char const *p = pName, *q = logCategoryLevelNames[i];
+
+            while (('\0' != *p) && (toupper((unsigned char) *p) == *q)) {
+                p++;
+                q++;
+            }
+            if (('\0' == *p) && ('\0' == *q)) {
+                *pLevel = (log_level_t) i;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    default:
+        return true;
+    }
+} // log_parseLevel()
+
+
+
+bool log_checkCategory(log_category_t *pCategory, log_level_t level) {
+    assert(NULL != pCategory);
+    assert(NULL != pCategory->name);
+
+    if (LOGLEVEL_NONE == pCategory->level) {
+        log_lockCategories();
+        // Another thread may have registered the category meanwhile.
+        if (LOGLEVEL_NONE == pCategory->level) {
+            pCategory->next = logCategories;
+            logCategories = pCategory;
+            pCategory->level = log_categoryLevel(pCategory->name);
+        }
+        log_unlockCategories();
+    }
+
+    return level >= pCategory->level;
+} // log_checkCategory()
+
+
+
+bool log_setCategoryLevel(char const *name, log_level_t level) {
+    bool failed = false;
+
+    assert(NULL != name);
+    assert(level <= LOGLEVEL_ALWAYS);
+
+    log_lockCategories();
+    if (NULL == logCategoryLevels) {
+        logCategoryLevels = kv_createCollection();
+    }
+    if ((NULL == logCategoryLevels)
+        || (NULL == kv_insertInt(logCategoryLevels, name, (int) level))) {
+        failed = true;
+    } else {
+        // The latest level set wins over the one from the file.
+        if (NULL != logCategoryFileLevels) {
+            (void) kv_remove(logCategoryFileLevels, name);
+        }
+        log_updateCategories();
+    }
+    log_unlockCategories();
+
+    return failed;
+} // log_setCategoryLevel()
+
+
+
+void log_setDefaultCategoryLevel(log_level_t level) {
+    assert(level <= LOGLEVEL_ALWAYS);
+
+    log_lockCategories();
+    logCategoryDefaultLevel = level;
+    log_updateCategories();
+    log_unlockCategories();
+} // log_setDefaultCategoryLevel()
+
+
+
+bool log_loadCategoryConfig(char const *filename) {
+    kv_collection_t *pConfig, *pLevels, *pOldLevels;
+    kv_iterator_t iterator;
+    kv_object_t *pObject;
+    log_level_t level, defaultLevel;
+    size_t prefixLength = strlen(LOG_CATEGORY_SECTION);
+    bool failed = false;
+
+    assert(NULL != filename);
+
+    pConfig = kv_createCollection();
+    pLevels = kv_createCollection();
+    if ((NULL == pConfig) || (NULL == pLevels) || kv_loadIniFile(pConfig, filename, NULL)) {
+        failed = true;
+    }
+
+    // Validate the whole file before changing any level.
+    log_lockCategories();
+    defaultLevel = logCategoryDefaultLevel;
+    log_unlockCategories();
+    for (pObject = failed ? NULL : kv_initializeIterator(&iterator, pConfig);
+         NULL != pObject;
+         pObject = kv_iterateNext(&iterator)) {
+        char const *name = pObject->key;
+
+        if (strncmp(name, LOG_CATEGORY_SECTION, prefixLength) != 0) {
+            continue;
+        }
+        name += prefixLength;
+        if (log_parseLevel(pObject, &level)) {
+            failed = true;
+        } else if (strcmp(name, LOG_CATEGORY_DEFAULT_KEY) == 0) {
+            defaultLevel = level;
+        } else if (NULL == kv_insertInt(pLevels, name, (int) level)) {
+            failed = true;
+        }
+    }
+
+    if (!failed) {
+        log_lockCategories();
+        logCategoryDefaultLevel = defaultLevel;
+        // Replace the whole file set, so entries removed from the file fall
+        // back to the levels set by name or the default level.
+        pOldLevels = logCategoryFileLevels;
+        logCategoryFileLevels = pLevels;
+        pLevels = pOldLevels;
+        log_updateCategories();
+        log_unlockCategories();
+    }
+
+    if (NULL != pConfig) {
+        kv_freeCollection(pConfig);
+    }
+    if (NULL != pLevels) {
+        kv_freeCollection(pLevels);
+    }
+    return failed;
+} // log_loadCategoryConfig()
+
+
+
+/** Records the request to reload the category configuration.
+
+    @param signalNumber The number of the signal received.
+ */
+static void log_categoryReloadHandler(int signalNumber) {
+    (void) signalNumber;
+    logCategoryReloadRequested = 1;
+#if LOGGING_THREADS
+    (void) sem_post(&logCategoryReloadSemaphore);
+#endif // LOGGING_THREADS
+} // log_categoryReloadHandler()
+
+
+
+#if LOGGING_THREADS
+/** Loads the configuration file whenever the signal handler requests it,
+    so the file I/O does not delay a thread logging a message.
+
+    @param pArgument Unused.
+    @return Never returns.
+ */
+static void *log_categoryReloadThread(void *pArgument) {
+    (void) pArgument;
+
+    for (;;) {
+        if (sem_wait(&logCategoryReloadSemaphore) == 0) {
+            log_checkCategoryReload();
+        }
+    }
+    return NULL;
+} // log_categoryReloadThread()
+#endif // LOGGING_THREADS
+
+
+
+bool log_installCategoryReloadHandler(char const *filename) {
+#ifdef SIGHUP
+    struct sigaction action;
+    char *pCopy;
+
+    assert(NULL != filename);
+
+    if (NULL == (pCopy = strdup(filename))) {
+        return true;
+    }
+    log_lockCategories();
+    free(logCategoryConfigFile);
+    logCategoryConfigFile = pCopy;
+#if LOGGING_THREADS
+    if (!logCategoryReloadThreadRunning) {
+        pthread_t thread;
+
+        if ((sem_init(&logCategoryReloadSemaphore, 0, 0) != 0)
+            || (pthread_create(&thread, NULL, log_categoryReloadThread, NULL) != 0)) {
+            log_unlockCategories();
+            return true;
+        }
+        (void) pthread_detach(thread);
+        logCategoryReloadThreadRunning = true;
+    }
+#endif // LOGGING_THREADS
+    log_unlockCategories();
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = log_categoryReloadHandler;
+    (void) sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return sigaction(SIGHUP, &action, NULL) != 0;
+#else
+    (void) filename;
+    return true;
+#endif // !SIGHUP
+} // log_installCategoryReloadHandler()
+
+
+
+void log_checkCategoryReload(void) {
+    char *filename = NULL;
+
+    if (0 == logCategoryReloadRequested) {
+        return;
+    }
+
+#if LOGGING_THREADS
+    if (0 == atomic_exchange(&logCategoryReloadRequested, 0)) {
+        // Another thread is already reloading.
+        return;
+    }
+#else
+    logCategoryReloadRequested = 0;
+#endif // !LOGGING_THREADS
+
+    log_lockCategories();
+    if (NULL != logCategoryConfigFile) {
+        filename = strdup(logCategoryConfigFile);
+    }
+    log_unlockCategories();
+
+    if ((NULL != filename) && log_loadCategoryConfig(filename)) {
+#if 0 == LOGGING_API_USES_VARIADIC_MACROS
+        log_logMessage((LOGLEVEL_ERROR,
+                       "Unable to reload log categories from '%s'", filename));
+#else
+        log_logMessage(LOGLEVEL_ERROR,
+                       "Unable to reload log categories from '%s'", filename);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+    }
+    free(filename);
+} // log_checkCategoryReload()
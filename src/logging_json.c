@@ -0,0 +1,302 @@
+/** Structured log records with typed fields and a JSON-lines log file.
+
+    The fields are serialized straight into the buffer of the record using
+    the JSON conversions of the key-value module.
+
+
+    @file logging_json.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "keyvalue.h"
+#include "logging.h"
+
+#ifdef _MSC_VER
+// Disable warnings for functions VS C considers deprecated.
+#pragma warning(disable: 4996)
+#endif // _MSC_VER
+
+#ifdef _WIN32
+// Provided by winsix_clock_gettime.c.
+extern int clock_gettime(int option, struct timespec *pTS);
+#define CLOCK_REALTIME 0
+#endif // _WIN32
+
+
+/** The size of the buffer a record is formatted into. Larger records are
+ * formatted into an allocated buffer.
+ */
+#define LOG_JSON_RECORD_SIZE 1024
+
+
+/** The names of the levels in JSON records. */
+static char const * const logJsonLevelNames[] = {
+    "NONE",             // LOGLEVEL_NONE
+    "DEBUG3",           // LOGLEVEL_DEBUG3
+    "DEBUG2",           // LOGLEVEL_DEBUG2
+    "DEBUG1",           // LOGLEVEL_DEBUG1
+    "DEBUG",            // LOGLEVEL_DEBUG
+    "INFO",             // LOGLEVEL_INFO
+    "WARNING",          // LOGLEVEL_WARNING
+    "ERROR",            // LOGLEVEL_ERROR
+    "FATAL",            // LOGLEVEL_FATAL
+    "ALWAYS"            // LOGLEVEL_ALWAYS
+};
+
+/** The JSON-lines log file or NULL if none is open. */
+static FILE *logJsonFile = NULL;
+/** The lowest level written to the JSON-lines log file. */
+static log_level_t logJsonLevel = LOGLEVEL_NONE;
+
+
+
+/** Appends text to a record.
+
+    Like the JSON conversions, nothing is written if the text does not fit,
+    but the length it would need is accounted for.
+
+    @param pBuffer The buffer of the record.
+    @param bufferSize The size of the buffer in bytes.
+    @param length The length of the record so far.
+    @param pText The text to append.
+    @return The length of the record including the text.
+ */
+static size_t log_jsonAppend(char *pBuffer, size_t bufferSize, size_t length, char const *pText) {
+    size_t textLength = strlen(pText);
+
+    if (length + textLength < bufferSize) {
+        memcpy(pBuffer + length, pText, textLength + 1);
+    }
+    return length + textLength;
+} // log_jsonAppend()
+
+
+
+/** Formats a record.
+
+    Like snprintf(), the function returns the length the record would have
+    and writes as much as fits into the buffer.
+
+    @param pBuffer The buffer receiving the record.
+    @param bufferSize The size of the buffer in bytes.
+    @param asJson Format as a JSON object? Otherwise the fields are
+        appended to the message as key=value.
+    @param level The level of the record.
+    @param message The message of the record.
+    @param pFields The fields of the record.
+    @param nrFields The number of fields.
+    @return The length of the complete record, not counting the NUL
+        terminator.
+ */
+static size_t log_jsonFormat(char *pBuffer, size_t bufferSize, bool asJson,
+                             log_level_t level, char const *message,
+                             log_field_t const *pFields, size_t nrFields) {
+    size_t length = 0, i;
+
+// The part of the buffer following the record so far.
+#define LOG_JSON_REST pBuffer + ((length < bufferSize) ? length : 0), \
+                      ((length < bufferSize) ? bufferSize - length : 0)
+
+    if (asJson) {
+        struct timespec now;
+        char prefix[64];
+
+        (void) clock_gettime(CLOCK_REALTIME, &now);
+        (void) snprintf(prefix, sizeof(prefix), "{\"ts\":%lld.%06ld,\"level\":\"%s\",\"msg\":",
+                        (long long) now.tv_sec, (long) (now.tv_nsec / 1000),
+                        logJsonLevelNames[level]);
+        length = log_jsonAppend(pBuffer, bufferSize, length, prefix);
+        length += kv_stringToJSON(LOG_JSON_REST, message);
+    } else {
+        length = log_jsonAppend(pBuffer, bufferSize, length, message);
+    }
+
+    for (i = 0; i < nrFields; i++) {
+        if (asJson) {
+            length = log_jsonAppend(pBuffer, bufferSize, length, ",");
+            length += kv_stringToJSON(LOG_JSON_REST, pFields[i].key);
+            length = log_jsonAppend(pBuffer, bufferSize, length, ":");
+        } else {
+            length = log_jsonAppend(pBuffer, bufferSize, length, " ");
+            length = log_jsonAppend(pBuffer, bufferSize, length, pFields[i].key);
+            length = log_jsonAppend(pBuffer, bufferSize, length, "=");
+        }
+        length += kv_valueToJSON(LOG_JSON_REST, pFields[i].type, &pFields[i].value);
+    }
+
+    if (asJson) {
+        length = log_jsonAppend(pBuffer, bufferSize, length, "}\n");
+    }
+#undef LOG_JSON_REST
+
+    return length;
+} // log_jsonFormat()
+
+
+
+bool log_openJsonLogfile(char const *filename, bool append, log_level_t level) {
+    assert(NULL != filename);
+    assert((level >= LOGLEVEL_NONE) && (level < LOGLEVEL_ALWAYS));
+
+    if (NULL != logJsonFile) {
+        if (log_closeJsonLogfile()) {
+            return true;
+        }
+    }
+
+    if (NULL == (logJsonFile = fopen(filename, append ? "a" : "w"))) {
+        fprintf(stderr, "ERROR: Unable to open JSON logfile '%s' for write: %s\n", filename, strerror(errno));
+        return true;
+    }
+    // Complete lines reach the file as soon as they are written, so a
+    // shipper following the file never sees a partial record.
+    (void) setvbuf(logJsonFile, NULL, _IOLBF, BUFSIZ);
+
+    logJsonLevel = level;
+    return false;
+} // log_openJsonLogfile()
+
+
+
+bool log_closeJsonLogfile(void) {
+    FILE *pFile = logJsonFile;
+
+    assert(NULL != logJsonFile);
+
+    logJsonFile = NULL;
+    if (fclose(pFile) != 0) {
+        return true;
+    }
+    return false;
+} // log_closeJsonLogfile()
+
+
+
+/** Logs a text record to the channels of log_logMessage.
+
+    @param level The level of the record.
+    @param format A format string as used by @see printf
+    @param ... A list of parameters as used by @see printf
+ */
+static void log_jsonLogText(log_level_t level, char const *format, ...) {
+    //lint --e{438} args is changed by the macros.
+    va_list args;
+
+    va_start(args, format);
+    log_logVMessage(level, format, args);
+    va_end(args);
+} // log_jsonLogText()
+
+
+
+/** Formats a record and writes it to the JSON-lines log file or the
+    channels of log_logMessage.
+
+    @param pFile The JSON-lines log file, or NULL to log the record as
+        text.
+    @param level The level of the record.
+    @param message The message of the record.
+    @param pFields The fields of the record.
+    @param nrFields The number of fields.
+ */
+static void log_jsonWrite(FILE *pFile, log_level_t level, char const *message,
+                          log_field_t const *pFields, size_t nrFields) {
+    char record[LOG_JSON_RECORD_SIZE];
+    char *pRecord = record;
+    bool asJson = (NULL != pFile);
+    size_t length;
+
+    length = log_jsonFormat(record, sizeof(record), asJson, level, message, pFields, nrFields);
+    if (length >= sizeof(record)) {
+        // Format the record again into a buffer of the proper size. If
+        // that fails, the record is discarded rather than truncated, since
+        // a truncated JSON object can not be parsed.
+        if (NULL == (pRecord = malloc(length + 1))) {
+            return;
+        }
+        (void) log_jsonFormat(pRecord, length + 1, asJson, level, message, pFields, nrFields);
+    }
+
+    if (asJson) {
+        // One write per record keeps records of different threads apart.
+        (void) fwrite(pRecord, 1, length, pFile);
+    } else {
+        log_jsonLogText(level, "%s", pRecord);
+    }
+
+    if (pRecord != record) {
+        free(pRecord);
+    }
+} // log_jsonWrite()
+
+
+
+void log_logFields(log_level_t level, char const *message,
+                   log_field_t const *pFields, size_t nrFields) {
+    FILE *pFile = logJsonFile;
+
+    assert((level > LOGLEVEL_NONE) && (level <= LOGLEVEL_ALWAYS));
+    assert(NULL != message);
+    assert((NULL != pFields) || (0 == nrFields));
+
+    // Decide before anything is formatted.
+    if ((NULL != pFile) && (level >= logJsonLevel)) {
+        log_jsonWrite(pFile, level, message, pFields, nrFields);
+    }
+    // The record also reaches the regular channels as text.
+    if (log_isLevelEnabled(level)) {
+        log_jsonWrite(NULL, level, message, pFields, nrFields);
+    }
+} // log_logFields()
@@ -98,6 +98,16 @@
    into FTR_TCP_LC_BUFFER_SIZE. */
 #define FTR_TCP_LC_LINE_WIDTH 0x10
 
+/** The largest number of data bytes of a single send or receive to log. */
+#define FTR_TCP_LC_MAX_BYTES 0x400
+
+/** The number of socket errors per second logged on average. Errors
+   beyond that are counted, so a failing peer can not flood the log. */
+#define FTR_TCP_ERROR_RATE 10
+
+/** The number of socket errors logged at once before the rate applies. */
+#define FTR_TCP_ERROR_BURST 20
+
 
 #ifdef FTR_TCP_LOG_CONTENT
 /** Enables content logging if true, disables if false. */
@@ -107,6 +117,9 @@ static bool logContentEnabled = true;
 
 static bool isInitialized = false;
 
+/** The log category of the debug messages of this module. */
+static LOG_DEFINE_CATEGORY(tcpCategory, "tcputils");
+
 #ifdef _WIN32
 /** Windows uses strange "secure" functions. */
 #define snprintf(x, y, ...) _snprintf_s(x, y, y, ## __VA_ARGS__)
@@ -167,7 +180,8 @@ static char const *winsock_strerror(int errorCode) {
 /** Logs an error with the message and a description of the cause.
 
     The message and the description will be separated by a colon ':'.
-    The log entry will be terminated.
+    The log entry will be terminated. At most FTR_TCP_ERROR_RATE errors
+    per second are logged.
 
    @param message A string describing what the application was trying to do.
 
@@ -294,13 +308,15 @@ static void tcp_log_error(char const *message) {
     } // switch errorCode
 
     // Windows nicely formats error messages by appending a period.
-    log_logMessage(level, "%s: %s(%d) - %s",
-                   message, errorStr, errorCode,
-                   winsock_strerror(errorCode));
+    log_logRateLimited(FTR_TCP_ERROR_RATE, FTR_TCP_ERROR_BURST, level,
+                       "%s: %s(%d) - %s",
+                       message, errorStr, errorCode,
+                       winsock_strerror(errorCode));
 #else // POSIX
-    log_logMessage(LOGLEVEL_ERROR, "%s: %s.",
-                   message,
-                   strerror(errno));
+    log_logRateLimited(FTR_TCP_ERROR_RATE, FTR_TCP_ERROR_BURST, LOGLEVEL_ERROR,
+                       "%s: %s.",
+                       message,
+                       strerror(errno));
 #endif // POSIX
 } // tcp_log_error()
 
@@ -308,8 +324,9 @@ static void tcp_log_error(char const *message) {
 
 #ifdef FTR_TCP_LOG_CONTENT
 void tcp_log_data(char const *pData, size_t nrOfBytes, char const *prefix) {
-    if (logContentEnabled) {
-        log_logData(LOGLEVEL_DEBUG2, pData, nrOfBytes, prefix, FTR_TCP_LC_LINE_WIDTH);
+    if (logContentEnabled && log_isCategoryEnabled(tcpCategory, LOGLEVEL_DEBUG2)) {
+        log_logDataLimited(LOGLEVEL_DEBUG2, pData, nrOfBytes, prefix,
+                           FTR_TCP_LC_LINE_WIDTH, FTR_TCP_LC_MAX_BYTES);
     }
 } // tcp_log_data()
 #endif // FTR_TCP_LOG_CONTENT
@@ -396,7 +413,7 @@ int tcp_client_connect(char const *hostname, int port) {
     struct  hostent *host;
 
 
-    log_logMessage(LOGLEVEL_DEBUG1, "tcp_client_connect('%s', %d)", hostname, port);
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "tcp_client_connect('%s', %d)", hostname, port);
     serverAddress.sin_family = AF_INET;
     serverAddress.sin_port = htons((unsigned short) port);
     if ((host = gethostbyname(hostname)) == NULL) {
@@ -542,7 +559,7 @@ int tcp_connect_to_server(int port) {
 #endif // _WIN32
 
 
-    log_logMessage(LOGLEVEL_DEBUG1, "tcp_connect_to_server(%d)", port);
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "tcp_connect_to_server(%d)", port);
     assert((port >= 0) && (port <= 65535));
     if (NULL == itoa(port, portString, 10)) {
         log_logMessage(LOGLEVEL_ERROR, "itoa(%d) failed.", port);
@@ -602,7 +619,7 @@ int tcp_connect_to_server(int port) {
         (void) closesocket(sd);
         return -3;
     }
-    log_logMessage(LOGLEVEL_DEBUG1, "Server socket running on port %d", port);
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "Server socket running on port %d", port);
 
     // Wait until we get a connection.
     if ((sc = accept(sd, (struct sockaddr *) &client, &clientSize)) < 0) {
@@ -611,7 +628,7 @@ int tcp_connect_to_server(int port) {
         (void) closesocket(sd);
         return -4;
     }
-    log_logMessage(LOGLEVEL_DEBUG1, "Server socket accepted connection from %s:%d", inet_ntoa(client.sin_addr), ntohs(client.sin_port));
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "Server socket accepted connection from %s:%d", inet_ntoa(client.sin_addr), ntohs(client.sin_port));
 
     return (int) sc;
 } // tcp_connect_to_server()
@@ -623,7 +640,7 @@ int tcp_server(int port, serverfunction pServerFunction, bool multiThreaded) {
     struct sockaddr_in server;
 
 
-    log_logMessage(LOGLEVEL_DEBUG1,
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1,
         "tcp_server(%d, @0x%p, %s)",
         port, pServerFunction, multiThreaded ? "true" : "false");
 
@@ -691,7 +708,7 @@ int tcp_server(int port, serverfunction pServerFunction, bool multiThreaded) {
         {
             bool result = pServerFunction(sc, &client);
             (void) closesocket(sc);
-            log_logMessage(LOGLEVEL_DEBUG1, "Closed connection on port %d", port);
+            log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "Closed connection on port %d", port);
             if (result) {
                 break;
             }
@@ -715,18 +732,20 @@ int tcp_server_multiport(unsigned nrOfSockets,
 
 
     // Create some fancy debug output.
-    log_logMessageStart(LOGLEVEL_DEBUG1, "tcp_server_multiport(%u, [", nrOfSockets);
-    for (i = 0;i < nrOfSockets;i ++) {
-        log_logMessageContinue(LOGLEVEL_DEBUG1, "{ %d, @0x%p, @0x%p, @0x%p }",
-                               serversockets[i].port,
-                               serversockets[i].pFctConnect,
-                               serversockets[i].pFctReceive,
-                               serversockets[i].pFctDisconnect);
-        if (i > 1) {
-            log_logMessageContinue(LOGLEVEL_DEBUG1, ", ");
-        }
-    } // for i
-    log_logMessageContinue(LOGLEVEL_DEBUG1, "])\n");
+    if (log_isCategoryEnabled(tcpCategory, LOGLEVEL_DEBUG1)) {
+        log_logMessageStart(LOGLEVEL_DEBUG1, "tcp_server_multiport(%u, [", nrOfSockets);
+        for (i = 0;i < nrOfSockets;i ++) {
+            log_logMessageContinue(LOGLEVEL_DEBUG1, "{ %d, @0x%p, @0x%p, @0x%p }",
+                                   serversockets[i].port,
+                                   serversockets[i].pFctConnect,
+                                   serversockets[i].pFctReceive,
+                                   serversockets[i].pFctDisconnect);
+            if (i > 1) {
+                log_logMessageContinue(LOGLEVEL_DEBUG1, ", ");
+            }
+        } // for i
+        log_logMessageContinue(LOGLEVEL_DEBUG1, "])\n");
+    }
 
 
     if (0 == nrOfSockets) {
@@ -827,7 +846,7 @@ int tcp_server_multiport(unsigned nrOfSockets,
         // Use select() to wait until something interesting occurs.
         nrSelectEvents = select(maxFd, &readSet, NULL /*&writeSet*/, &errorSet, &timeout);
         if (0 == nrSelectEvents) {
-//            log_logMessage(LOGLEVEL_DEBUG1, "timeout in select()");
+//            log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "timeout in select()");
             continue;
         }
         if (nrSelectEvents < 0) {
@@ -842,7 +861,7 @@ int tcp_server_multiport(unsigned nrOfSockets,
             if (0 != FD_ISSET(serversockets[i].listenSocket, &readSet)) {
                 nrSelectEvents--;
                 // Accept the connection.
-                log_logMessage(LOGLEVEL_DEBUG1,
+                log_logCategory(tcpCategory, LOGLEVEL_DEBUG1,
                     "tcp_server_multiport(): server socket #%d received connection attempt.",
                     i);
                 serversockets[i].clientSize = sizeof(serversockets[i].client);
@@ -854,10 +873,10 @@ int tcp_server_multiport(unsigned nrOfSockets,
                     errorOccurred = -6;
                     break;
                 }
-                log_logMessage(LOGLEVEL_DEBUG1,
-                               "tcp_server_multiport(): accepted connection from %s:%d",
-                               inet_ntoa(serversockets[i].client.sin_addr),
-                               ntohs(serversockets[i].client.sin_port));
+                log_logCategory(tcpCategory, LOGLEVEL_DEBUG1,
+                                "tcp_server_multiport(): accepted connection from %s:%d",
+                                inet_ntoa(serversockets[i].client.sin_addr),
+                                ntohs(serversockets[i].client.sin_port));
 
                 // Try to set non-blocking mode.
                 if (!tcp_set_socket_nonblocking(serversockets[i].clientSocket)) {
@@ -874,19 +893,19 @@ int tcp_server_multiport(unsigned nrOfSockets,
                  if (NULL != serversockets[i].pFctConnect) {
                     if (serversockets[i].pFctConnect(serversockets[i].clientSocket,
                                                      &serversockets[i].client)) {
-                        log_logMessage(LOGLEVEL_DEBUG1, "tcp_server_multiport(): callback failed.");
+                        log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "tcp_server_multiport(): callback failed.");
                     }
                  }
             } // if listenSocket read
 
             if (0 != FD_ISSET(serversockets[i].clientSocket, &readSet)) {
                 nrSelectEvents--;
-                log_logMessage(LOGLEVEL_DEBUG1,
-                               "tcp_server_multiport(): client socket #%d became readable.",
-                               i);
+                log_logCategory(tcpCategory, LOGLEVEL_DEBUG1,
+                                "tcp_server_multiport(): client socket #%d became readable.",
+                                i);
                 if (serversockets[i].pFctReceive(serversockets[i].clientSocket,
                                                  &serversockets[i].client)) {
-                    log_logMessage(LOGLEVEL_DEBUG1, "tcp_server_multiport(): close client connection.");
+                    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1, "tcp_server_multiport(): close client connection.");
                     FD_CLR(serversockets[i].clientSocket, &masterSet);
                     closesocket(serversockets[i].clientSocket);
                     if (NULL != serversockets[i].pFctDisconnect) {
@@ -1003,10 +1022,10 @@ bool multiechoserver(int theSocket,  struct sockaddr_in *from) {
     int numRxBytes;
 
 
-    log_logMessage(LOGLEVEL_DEBUG1,
-                   "multiechoserver(%d): Serving %s:%d",
-                   theSocket,
-                   inet_ntoa(from->sin_addr), ntohs(from->sin_port));
+    log_logCategory(tcpCategory, LOGLEVEL_DEBUG1,
+                    "multiechoserver(%d): Serving %s:%d",
+                    theSocket,
+                    inet_ntoa(from->sin_addr), ntohs(from->sin_port));
 
     numRxBytes = recv(theSocket, rxTxBuffer, sizeof(rxTxBuffer), 0);
     if (numRxBytes > 0) {
@@ -0,0 +1,375 @@
+/** Measures the throughput and latency of the logging functions.
+
+    Usage: logbench [messages-per-thread]
+
+    Each scenario configures the channels, logs the messages from one or
+    more threads and measures the time of every call. One line of JSON is
+    written to stdout per scenario and number of threads:
+    <pre>
+    {"scenario":"file","threads":1,"messages":100000,"messages_per_s":...,
+     "p50_ns":...,"p90_ns":...,"p99_ns":...,"p999_ns":...,"max_ns":...}
+    </pre>
+    The latencies include the overhead of reading the clock. The log files
+    are created in the current directory and removed afterwards.
+
+
+    @file logbench.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+
+
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "logging.h"
+
+
+/** The log file written by the scenarios. */
+#define LOGBENCH_LOGFILE "logbench.log"
+/** The number of messages each thread logs if not specified. */
+#define LOGBENCH_DEFAULT_MESSAGES 100000
+/** The largest number of threads of a scenario. */
+#define LOGBENCH_MAX_THREADS 4
+/** The number of bytes dumped by the log_logData scenario. */
+#define LOGBENCH_DATA_SIZE 256
+
+
+/** A benchmark scenario. */
+typedef struct {
+    /** The name used in the output. */
+    char const *name;
+    /** Configures the channels. Returns true on error, after undoing what
+        it did, as the teardown is not called then. */
+    bool (*setup)(void);
+    /** Logs the i-th message. */
+    void (*log)(unsigned long i);
+    /** Restores the configuration after the scenario. */
+    void (*teardown)(void);
+} logbench_scenario_t;
+
+/** The work of one thread. */
+typedef struct {
+    /** The scenario. */
+    logbench_scenario_t const *pScenario;
+    /** The number of messages to log. */
+    unsigned long nrMessages;
+    /** Receives the latency of each call in ns. */
+    uint32_t *pLatencies;
+} logbench_thread_t;
+
+/** The data dumped by the log_logData scenario. */
+static char logbenchData[LOGBENCH_DATA_SIZE];
+/** The descriptor of the real stdout while stdout is redirected. */
+static int logbenchStdout = -1;
+
+
+
+/** Returns a monotonic time in ns. */
+static uint64_t logbench_now(void) {
+    struct timespec now;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+} // logbench_now()
+
+
+
+/** Compares two latencies for qsort(). */
+static int logbench_compare(void const *pA, void const *pB) {
+    uint32_t a = *(uint32_t const *) pA, b = *(uint32_t const *) pB;
+
+    return (a > b) - (a < b);
+} // logbench_compare()
+
+
+
+/** Logs the messages of one thread, timing each call.
+
+    @param pArgument The logbench_thread_t of the thread.
+    @return Always NULL.
+ */
+static void *logbench_thread(void *pArgument) {
+    logbench_thread_t *pThread = pArgument;
+    unsigned long i;
+
+    for (i = 0; i < pThread->nrMessages; i++) {
+        uint64_t start = logbench_now();
+
+        pThread->pScenario->log(i);
+        pThread->pLatencies[i] = (uint32_t) (logbench_now() - start);
+    }
+    return NULL;
+} // logbench_thread()
+
+
+
+static void logbench_teardownFile(void) {
+    (void) log_closeLogfile();
+    (void) remove(LOGBENCH_LOGFILE);
+} // logbench_teardownFile()
+
+
+
+/** Writes the results to the original stdout again. */
+static void logbench_restoreStdout(void) {
+    log_setStdoutLevel(LOGLEVEL_ALWAYS - 1);
+    (void) fflush(stdout);
+    (void) dup2(logbenchStdout, STDOUT_FILENO);
+    (void) close(logbenchStdout);
+    clearerr(stdout);
+} // logbench_restoreStdout()
+
+
+
+static bool logbench_setupFile(void) {
+    log_setFileLevel(LOGLEVEL_INFO);
+    return log_openLogfile(LOGBENCH_LOGFILE, false);
+} // logbench_setupFile()
+
+
+
+static bool logbench_setupFileBuffered(void) {
+    if (logbench_setupFile()) {
+        return true;
+    }
+    if (log_setFlushPolicy(LOG_FLUSH_BYTES, 65536)) {
+        logbench_teardownFile();
+        return true;
+    }
+    return false;
+} // logbench_setupFileBuffered()
+
+
+
+static bool logbench_setupStdoutAndFile(void) {
+    // The messages shown on stdout must not mix with the results.
+    (void) fflush(stdout);
+    logbenchStdout = dup(STDOUT_FILENO);
+    if (!freopen("/dev/null", "w", stdout)) {
+        logbench_restoreStdout();
+        return true;
+    }
+    log_setStdoutLevel(LOGLEVEL_INFO);
+    if (logbench_setupFile()) {
+        logbench_restoreStdout();
+        return true;
+    }
+    return false;
+} // logbench_setupStdoutAndFile()
+
+
+
+static bool logbench_setupAsync(void) {
+    if (logbench_setupFile()) {
+        return true;
+    }
+    if (log_startAsync(1 << 20, LOG_QUEUE_BLOCK)) {
+        logbench_teardownFile();
+        return true;
+    }
+    return false;
+} // logbench_setupAsync()
+
+
+
+static bool logbench_setupMapped(void) {
+    log_setFileLevel(LOGLEVEL_INFO);
+    return log_openMappedLogfile(LOGBENCH_LOGFILE, false, 0);
+} // logbench_setupMapped()
+
+
+
+static void logbench_teardownFileBuffered(void) {
+    (void) log_setFlushPolicy(LOG_FLUSH_EVERY_MESSAGE, 0);
+    logbench_teardownFile();
+} // logbench_teardownFileBuffered()
+
+
+
+static void logbench_teardownStdoutAndFile(void) {
+    logbench_teardownFile();
+    logbench_restoreStdout();
+} // logbench_teardownStdoutAndFile()
+
+
+
+static void logbench_teardownAsync(void) {
+    log_stopAsync();
+    logbench_teardownFile();
+} // logbench_teardownAsync()
+
+
+
+static void logbench_logMessage(unsigned long i) {
+    log_logMessage(LOGLEVEL_INFO, "benchmark message %lu with a string %s", i, "argument");
+} // logbench_logMessage()
+
+
+
+static void logbench_logFiltered(unsigned long i) {
+    log_logMessage(LOGLEVEL_DEBUG, "benchmark message %lu with a string %s", i, "argument");
+} // logbench_logFiltered()
+
+
+
+static void logbench_logData(unsigned long i) {
+    (void) i;
+    log_logData(LOGLEVEL_INFO, logbenchData, sizeof(logbenchData), "data    ", 16);
+} // logbench_logData()
+
+
+
+/** The scenarios, in the order they are run. */
+static logbench_scenario_t const logbenchScenarios[] = {
+    { "filtered", logbench_setupFile, logbench_logFiltered, logbench_teardownFile },
+    { "file", logbench_setupFile, logbench_logMessage, logbench_teardownFile },
+    { "file_buffered", logbench_setupFileBuffered, logbench_logMessage, logbench_teardownFileBuffered },
+    { "stdout_file", logbench_setupStdoutAndFile, logbench_logMessage, logbench_teardownStdoutAndFile },
+    { "async_file", logbench_setupAsync, logbench_logMessage, logbench_teardownAsync },
+    { "mapped_file", logbench_setupMapped, logbench_logMessage, logbench_teardownFile },
+    { "data_dump", logbench_setupFile, logbench_logData, logbench_teardownFile }
+};
+
+
+
+/** Runs a scenario and writes its results.
+
+    @param pScenario The scenario.
+    @param nrThreads The number of threads logging concurrently.
+    @param nrMessages The number of messages each thread logs.
+    @return Did an error occur?
+ */
+static bool logbench_run(logbench_scenario_t const *pScenario,
+                         unsigned nrThreads, unsigned long nrMessages) {
+    pthread_t threads[LOGBENCH_MAX_THREADS];
+    logbench_thread_t work[LOGBENCH_MAX_THREADS];
+    unsigned long total = nrThreads * nrMessages;
+    uint32_t *pLatencies;
+    uint64_t start, elapsed;
+    unsigned i;
+
+    if (NULL == (pLatencies = malloc(total * sizeof(*pLatencies)))) {
+        fprintf(stderr, "ERROR: Out of memory.\n");
+        return true;
+    }
+    if (pScenario->setup()) {
+        fprintf(stderr, "ERROR: Unable to set up scenario %s: %s\n", pScenario->name, strerror(errno));
+        free(pLatencies);
+        return true;
+    }
+
+    start = logbench_now();
+    for (i = 0; i < nrThreads; i++) {
+        work[i].pScenario = pScenario;
+        work[i].nrMessages = nrMessages;
+        work[i].pLatencies = pLatencies + i * nrMessages;
+        if (pthread_create(&threads[i], NULL, logbench_thread, &work[i]) != 0) {
+            fprintf(stderr, "ERROR: Unable to create thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < nrThreads; i++) {
+        (void) pthread_join(threads[i], NULL);
+    }
+    // Include writing what is still buffered.
+    log_flush();
+    elapsed = logbench_now() - start;
+    pScenario->teardown();
+
+    qsort(pLatencies, total, sizeof(*pLatencies), logbench_compare);
+    printf("{\"scenario\":\"%s\",\"threads\":%u,\"messages\":%lu,\"messages_per_s\":%.0f,"
+           "\"p50_ns\":%lu,\"p90_ns\":%lu,\"p99_ns\":%lu,\"p999_ns\":%lu,\"max_ns\":%lu}\n",
+           pScenario->name, nrThreads, total, (double) total * 1e9 / (double) (elapsed ? elapsed : 1),
+           (unsigned long) pLatencies[total / 2],
+           (unsigned long) pLatencies[total * 9 / 10],
+           (unsigned long) pLatencies[total * 99 / 100],
+           (unsigned long) pLatencies[total * 999 / 1000],
+           (unsigned long) pLatencies[total - 1]);
+    (void) fflush(stdout);
+
+    free(pLatencies);
+    return false;
+} // logbench_run()
+
+
+
+int main(int argc, char *argv[]) {
+    unsigned long nrMessages = LOGBENCH_DEFAULT_MESSAGES;
+    size_t i;
+    bool failed = false;
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [messages-per-thread]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((2 == argc) && (0 == (nrMessages = strtoul(argv[1], NULL, 0)))) {
+        fprintf(stderr, "ERROR: Invalid number of messages '%s'.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < sizeof(logbenchData); i++) {
+        logbenchData[i] = (char) i;
+    }
+    // Only the scenarios decide which channels are used.
+    log_setStderrLevel(LOGLEVEL_ALWAYS - 1);
+    log_setStdoutLevel(LOGLEVEL_ALWAYS - 1);
+
+    for (i = 0; i < sizeof(logbenchScenarios) / sizeof(logbenchScenarios[0]); i++) {
+        failed |= logbench_run(&logbenchScenarios[i], 1, nrMessages);
+        failed |= logbench_run(&logbenchScenarios[i], LOGBENCH_MAX_THREADS, nrMessages);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+} // main()
@@ -0,0 +1,103 @@
+/** Converts binary log files to text.
+
+    Usage: logdecode binary-log-file [text-file]
+
+    Without a text file, the text is written to stdout. A binary log file
+    of "-" reads stdin, so the output of another program can be decoded.
+
+
+    @file logdecode.c
+    @ingroup misclib
+
+    @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+    @note The master repository for this file is at
+     <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+
+    LICENSE
+
+    This software is open source software under the "Simplified BSD License"
+    as approved by the Open Source Initiative (OSI)
+    <http://opensource.org/licenses/bsd-license.php>:
+
+
+    Copyright (c) 2010-2016, Christian Doenges (Christian D&ouml;nges) All rights
+    reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    * Neither the name of the Platypus Projects GmbH nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+    TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "logging.h"
+
+
+
+int main(int argc, char *argv[]) {
+    FILE *pInput, *pOutput = stdout;
+    bool failed;
+
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "Usage: %s binary-log-file [text-file]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[1], "-") == 0) {
+        pInput = stdin;
+    } else if (NULL == (pInput = fopen(argv[1], "rb"))) {
+        fprintf(stderr, "ERROR: Unable to open '%s': %s\n", argv[1], strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if ((3 == argc) && (NULL == (pOutput = fopen(argv[2], "w")))) {
+        fprintf(stderr, "ERROR: Unable to create '%s': %s\n", argv[2], strerror(errno));
+        if (stdin != pInput) {
+            fclose(pInput);
+        }
+        return EXIT_FAILURE;
+    }
+
+    failed = log_decodeBinary(pInput, pOutput);
+    if (failed) {
+        fprintf(stderr, "ERROR: '%s' is not a valid binary log file or it is truncated.\n", argv[1]);
+    }
+
+    if (stdin != pInput) {
+        fclose(pInput);
+    }
+    if (stdout != pOutput) {
+        fclose(pOutput);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+} // main()
@@ -34,7 +34,11 @@
 // Add test functions to this array.
 static utfunc_t unittest_functions[] = {
     unittest_factorial,
+    unittest_hex,
     unittest_keyvalue,
+    unittest_logging,
+    unittest_logging_minimumLevel,
+    unittest_logging_nonVariadic,
     unittest_lstrip,
     unittest_prng,
     unittest_ringbuffer,
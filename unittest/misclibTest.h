@@ -66,7 +66,11 @@ typedef bool(*utfunc_t)(void);
 
 
 extern bool unittest_factorial(void);
+extern bool unittest_hex(void);
 extern bool unittest_keyvalue(void);
+extern bool unittest_logging(void);
+extern bool unittest_logging_minimumLevel(void);
+extern bool unittest_logging_nonVariadic(void);
 extern bool unittest_lstrip(void);
 extern bool unittest_ringbuffer(void);
 extern bool unittest_prng(void);
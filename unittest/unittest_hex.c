@@ -0,0 +1,335 @@
+/** Unit tests for the hexadecimal conversion functions.
+
+   @file unittest_hex.c
+   @ingroup misclib
+
+   @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+   @note The master repository for this file is at
+    <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    Copyright 2016, 2017 Christian Doenges (Christian D&ouml;nges)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hex.h"
+#include "logging.h"
+#include "misclibTest.h"
+
+
+
+/** Encodes nrBytes starting at pSrc and compares the result to the
+   digits produced one nibble at a time. */
+static bool unittest_hex_encodeCompare(unsigned char const *pSrc,
+                                       size_t nrBytes, bool lowercase) {
+    char encoded[2 * 160 + 1];
+    char expected[2 * 160];
+    size_t i;
+
+    for (i = 0;i < nrBytes;i ++) {
+        unsigned hi = pSrc[i] >> 4, lo = pSrc[i] & 0x0f;
+
+        expected[2 * i]     = lowercase ? nibbleToHexdigit(hi) : nibbleToHexDigit(hi);
+        expected[2 * i + 1] = lowercase ? nibbleToHexdigit(lo) : nibbleToHexDigit(lo);
+    } // for i
+
+    // The byte following the output must not be touched.
+    memset(encoded, '#', sizeof(encoded));
+    hex_encode(encoded, pSrc, nrBytes, lowercase);
+    expectTrue(0 == memcmp(encoded, expected, 2 * nrBytes));
+    expectTrue('#' == encoded[2 * nrBytes]);
+
+    return true;
+} // unittest_hex_encodeCompare()
+
+
+
+static bool unittest_hex_encode(void) {
+    unsigned char values[256 + 3];
+    char encoded[16];
+    size_t i, offset, n;
+
+    for (i = 0;i < sizeof(values);i ++) {
+        values[i] = (unsigned char) (i * 0x35 + 7);
+    }
+
+    hex_encode(encoded, "\x00\x9f\xA0\xff", 4, false);
+    expectTrue(0 == memcmp(encoded, "009FA0FF", 8));
+    hex_encode(encoded, "\x00\x9f\xA0\xff", 4, true);
+    expectTrue(0 == memcmp(encoded, "009fa0ff", 8));
+    hex_encode(NULL, NULL, 0, false);
+
+    // Cover the scalar tail after every block size and unaligned sources.
+    for (offset = 0;offset < 4;offset ++) {
+        for (n = 0;n <= 160;n ++) {
+            expectTrue(unittest_hex_encodeCompare(values + offset, n, false));
+            expectTrue(unittest_hex_encodeCompare(values + offset, n, true));
+        } // for n
+    } // for offset
+
+    return true;
+} // unittest_hex_encode()
+
+
+
+/** Checks that hex_decode() rejects the character c at every position
+   of strings long enough to use every conversion path. */
+static bool unittest_hex_decodeInvalid(char c) {
+    char digits[2 * 100];
+    unsigned char decoded[100];
+    size_t position, n, k;
+
+    for (n = 1;n <= sizeof(digits);n += (n < 70) ? 1 : 13) {
+        for (k = 0;k < n;k ++) {
+            memset(digits, 'a', n);
+            digits[k] = c;
+            position = (size_t) -1;
+            expectTrue(hex_decode(decoded, digits, n, &position));
+            expectTrue(k == position);
+        } // for k
+    } // for n
+
+    return true;
+} // unittest_hex_decodeInvalid()
+
+
+
+static bool unittest_hex_decode(void) {
+    unsigned char values[160];
+    unsigned char decoded[160 + 1];
+    char encoded[2 * 160];
+    size_t position, i, n;
+    int c;
+
+    for (i = 0;i < sizeof(values);i ++) {
+        values[i] = (unsigned char) (i * 0x35 + 7);
+    }
+
+    expectFalse(hex_decode(decoded, "00fFa09F", 8, &position));
+    expectTrue(0 == memcmp(decoded, "\x00\xff\xa0\x9f", 4));
+    expectFalse(hex_decode(NULL, NULL, 0, NULL));
+    expectTrue(hex_decode(decoded, "a", 1, &position));
+    expectTrue(1 == position);
+    expectTrue(hex_decode(decoded, "abc", 3, NULL));
+    expectTrue(hex_decode(decoded, "abg", 3, &position));
+    expectTrue(2 == position);
+
+    // Round trips through every path, mixing the case of the digits.
+    for (n = 0;n <= sizeof(values);n ++) {
+        hex_encode(encoded, values, n, 0 != (n & 1));
+        for (i = 0;i < 2 * n;i += 3) {
+            encoded[i] = (char) toupper((unsigned char) encoded[i]);
+        }
+        decoded[n] = '#';
+        expectFalse(hex_decode(decoded, encoded, 2 * n, NULL));
+        expectTrue(0 == memcmp(decoded, values, n));
+        expectTrue('#' == decoded[n]);
+    } // for n
+
+    // Every character that is not a digit is rejected wherever it is.
+    for (c = 0;c < 256;c ++) {
+        if (!isxdigit(c)) {
+            expectTrue(unittest_hex_decodeInvalid((char) c));
+        }
+    } // for c
+
+    return true;
+} // unittest_hex_decode()
+
+
+
+static bool unittest_hex_int64(void) {
+    char digits[17];
+    char expected[17];
+    uint64_t value = UINT64_C(0x9e3779b97f4a7c15);
+    uint64_t decoded;
+    uint32_t decoded32;
+    int i, c, k;
+
+    int64ToHex(digits, UINT64_C(0x0123456789abcdef));
+    expectTrue(0 == memcmp(digits, "0123456789ABCDEF", 16));
+    int32ToHex(digits, 0xfedcba98u);
+    expectTrue(0 == memcmp(digits, "FEDCBA98", 8));
+    expectTrue(UINT64_C(0xfedcba9876543210) == hexToInt64("FeDcBa9876543210"));
+    expectTrue(0xa1b2c3d4u == hexToInt32("a1B2c3D4"));
+
+    // Compare against printf() for values with all kinds of digits.
+    for (i = 0;i < 1000;i ++) {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+
+        int64ToHex(digits, value);
+        (void) snprintf(expected, sizeof(expected), "%08lX%08lX",
+                        (unsigned long) (value >> 32), (unsigned long) (value & 0xffffffffu));
+        expectTrue(0 == memcmp(digits, expected, 16));
+        expectTrue(value == hexToInt64(digits));
+        expectFalse(hexToInt64Checked(digits, &decoded));
+        expectTrue(value == decoded);
+        expectFalse(hexToInt32Checked(digits + 8, &decoded32));
+        expectTrue((uint32_t) value == decoded32);
+    } // for i
+
+    // Every character that is not a digit is rejected wherever it is.
+    for (c = 0;c < 256;c ++) {
+        if (isxdigit(c)) {
+            continue;
+        }
+        for (k = 0;k < 16;k ++) {
+            memcpy(digits, "0123456789abcDEF", 16);
+            digits[k] = (char) c;
+            decoded = 42;
+            expectTrue(hexToInt64Checked(digits, &decoded));
+            expectTrue(42 == decoded);
+            if (k < 8) {
+                expectTrue(hexToInt32Checked(digits, &decoded32));
+            }
+        } // for k
+    } // for c
+
+    return true;
+} // unittest_hex_int64()
+
+
+
+/** The output collected by unittest_hex_sink(). */
+static struct {
+    char text[64 * 1024];
+    size_t length;
+    unsigned nrCalls;
+    /** Fail once this many calls have succeeded. */
+    unsigned failAfter;
+} unittestSink;
+
+
+/** A hex dump sink appending to unittestSink. */
+static bool unittest_hex_sink(void *pSinkContext, char const *pText, size_t length) {
+    (void) pSinkContext;
+
+    if ((unittestSink.nrCalls >= unittestSink.failAfter)
+     || (length > sizeof(unittestSink.text) - unittestSink.length)) {
+        return true;
+    }
+    memcpy(unittestSink.text + unittestSink.length, pText, length);
+    unittestSink.length += length;
+    unittestSink.nrCalls++;
+    return false;
+} // unittest_hex_sink()
+
+
+
+/** Dumps the data in chunks and compares the result to hexbuf2String(). */
+static bool unittest_hex_dumpCompare(char const *pData, size_t nrBytes, size_t chunkSize,
+                                     bool useCRLF, bool showASCII, unsigned lineWidth,
+                                     bool showOffset) {
+    hex_dump_t dump;
+    char *pExpected;
+    size_t i;
+
+    pExpected = hexbuf2String(pData, nrBytes, NULL, 0,
+                              useCRLF, showASCII, lineWidth, showOffset, 0x1234);
+    expectNotNull(pExpected);
+
+    memset(&unittestSink, 0, sizeof(unittestSink));
+    unittestSink.failAfter = ~0u;
+    expectFalse(hex_dumpInit(&dump, unittest_hex_sink, NULL,
+                             useCRLF, showASCII, lineWidth, showOffset, 0x1234));
+    for (i = 0;i < nrBytes;i += chunkSize) {
+        expectFalse(hex_dumpWrite(&dump, pData + i, (nrBytes - i < chunkSize) ? nrBytes - i : chunkSize));
+    }
+    expectFalse(hex_dumpFinish(&dump));
+
+    expectTrue(strlen(pExpected) == unittestSink.length);
+    expectTrue(0 == memcmp(pExpected, unittestSink.text, unittestSink.length));
+    free(pExpected);
+
+    return true;
+} // unittest_hex_dumpCompare()
+
+
+
+static bool unittest_hex_dump(void) {
+    static char data[5000];
+    hex_dump_t dump;
+    FILE *fh;
+    char line[80];
+    size_t i;
+
+    for (i = 0;i < sizeof(data);i ++) {
+        data[i] = (char) (i * 7 + (i >> 8));
+    }
+
+    expectTrue(hex_dumpInit(&dump, unittest_hex_sink, NULL, false, true, 0, true, 0));
+    expectTrue(hex_dumpInit(&dump, unittest_hex_sink, NULL, false, true, HEX_DUMP_MAX_LINE_WIDTH + 1, true, 0));
+
+    // Chunks splitting lines anywhere give the same output as a single
+    // buffer, also when the output exceeds the batch buffer.
+    expectTrue(unittest_hex_dumpCompare(data, 37, 1, false, true, 8, true));
+    expectTrue(unittest_hex_dumpCompare(data, 37, 5, true, false, 16, true));
+    expectTrue(unittest_hex_dumpCompare(data, 48, 48, false, true, 16, false));
+    expectTrue(unittest_hex_dumpCompare(data, sizeof(data), 7, false, true, 16, true));
+    expectTrue(unittest_hex_dumpCompare(data, sizeof(data), 1000, true, true, 11, true));
+    expectTrue(unittest_hex_dumpCompare(data, sizeof(data), sizeof(data), false, true, 64, true));
+    expectTrue(unittestSink.nrCalls > 1);
+
+    // A failing sink aborts the dump.
+    memset(&unittestSink, 0, sizeof(unittestSink));
+    unittestSink.failAfter = 1;
+    expectFalse(hex_dumpInit(&dump, unittest_hex_sink, NULL, false, true, 16, true, 0));
+    for (i = 0;i < 100;i ++) {
+        if (hex_dumpWrite(&dump, data, sizeof(data))) {
+            break;
+        }
+    }
+    expectTrue(hex_dumpWrite(&dump, data, 1));
+    expectTrue(hex_dumpFinish(&dump));
+    expectTrue(1 == unittestSink.nrCalls);
+
+    // The offset grows beyond 8 digits, the dump goes to a stream.
+    expectNotNull(fh = tmpfile());
+    expectFalse(hex_dumpInit(&dump, hex_dumpFileSink, fh, false, false, 4,
+                             true, (size_t) 0xfffffffcu));
+    expectFalse(hex_dumpWrite(&dump, "\x01\x02\x03\x04\x05", 5));
+    expectFalse(hex_dumpFinish(&dump));
+    rewind(fh);
+    expectNotNull(fgets(line, sizeof(line), fh));
+    expectTrue(strcmp(line, "FFFFFFFC 01 02 03 04\n") == 0);
+    expectNotNull(fgets(line, sizeof(line), fh));
+    if (sizeof(size_t) > 4) {
+        expectTrue(strcmp(line, "0000000100000000 05\n") == 0);
+    }
+    (void) fclose(fh);
+
+    return true;
+} // unittest_hex_dump()
+
+
+
+bool unittest_hex(void) {
+    log_logMessage(LOGLEVEL_INFO, "Testing hex");
+
+    expectTrue(unittest_hex_int64());
+    expectTrue(unittest_hex_encode());
+    expectTrue(unittest_hex_decode());
+    expectTrue(unittest_hex_dump());
+
+    return true;
+} // unittest_hex()
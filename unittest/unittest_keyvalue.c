@@ -25,6 +25,8 @@
     limitations under the License.
  */
 #include <errno.h>
+#include <locale.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -142,6 +144,473 @@ static bool unittest_keyvalue_functional(void) {
 
 
 
+static bool unittest_keyvalue_types(void) {
+    kv_collection_t *pCollection;
+    kv_object_t *theObject;
+    static char const borrowedString[] = "borrowed";
+    char ownedString[] = STRING;
+    static unsigned char const blobData[] = { 0x00, 0x01, 0xfe, 0xff, 0x00 };
+    unsigned char blobCopy[sizeof(blobData)];
+    void const *pBlob;
+    size_t blobLength;
+
+    pCollection = kv_createCollection();
+    expectNotNull(pCollection);
+
+    // 64 bit integers must keep all their bits.
+    theObject = kv_insertInt64(pCollection, KEY1, INT64_C(0x123456789abcdef0));
+    expectNotNull(theObject);
+    expectTrue(kv_getTypeFromObject(theObject) == KV_VALUE_INT64);
+    expectTrue(kv_getInt64ValueFromObject(theObject) == INT64_C(0x123456789abcdef0));
+    theObject = kv_insertInt64(pCollection, KEY1, INT64_MIN);
+    expectNotNull(theObject);
+    expectTrue(kv_getInt64(pCollection, KEY1) == INT64_MIN);
+    expectTrue(kv_getInt64(pCollection, KEYx) == 0);
+
+    // Blobs are copied and may contain NUL bytes.
+    memcpy(blobCopy, blobData, sizeof(blobCopy));
+    theObject = kv_insertBlob(pCollection, KEY2, blobCopy, sizeof(blobCopy));
+    expectNotNull(theObject);
+    memset(blobCopy, 0x55, sizeof(blobCopy));
+    expectTrue(kv_getTypeFromObject(theObject) == KV_VALUE_BLOB);
+    pBlob = kv_getBlobValueFromObject(theObject, &blobLength);
+    expectTrue(blobLength == sizeof(blobData));
+    expectTrue(memcmp(pBlob, blobData, sizeof(blobData)) == 0);
+    // Replace the blob with an empty one.
+    theObject = kv_insertBlob(pCollection, KEY2, NULL, 0);
+    expectNotNull(theObject);
+    expectNull(kv_getBlob(pCollection, KEY2, &blobLength));
+    expectTrue(0 == blobLength);
+    blobLength = 1;
+    expectNull(kv_getBlob(pCollection, KEYx, &blobLength));
+    expectTrue(0 == blobLength);
+
+    // Borrowed strings are not copied and can be replaced by owned strings.
+    theObject = kv_insertBorrowedString(pCollection, KEY3, borrowedString);
+    expectNotNull(theObject);
+    expectTrue(kv_getString(pCollection, KEY3) == borrowedString);
+    theObject = kv_insertString(pCollection, KEY3, ownedString);
+    expectNotNull(theObject);
+    ownedString[0] = 'X';
+    expectTrue(strcmp(kv_getString(pCollection, KEY3), STRING) == 0);
+    theObject = kv_insertBorrowedString(pCollection, KEY3, borrowedString);
+    expectNotNull(theObject);
+    expectTrue(kv_getString(pCollection, KEY3) == borrowedString);
+
+    // Removing a borrowed string must leave the string alone.
+    expectTrue(kv_remove(pCollection, KEY3));
+    expectTrue(strcmp(borrowedString, "borrowed") == 0);
+
+    kv_freeCollection(pCollection);
+
+    return true;
+} // unittest_keyvalue_types()
+
+
+
+static bool unittest_keyvalue_ini(void) {
+    kv_collection_t *pCollection;
+    kv_parse_error_t error;
+    static char const iniText[] =
+        "; A comment\r\n"
+        "top = level  \r\n"
+        "\n"
+        "[ server ]\n"
+        "  port= 8080\n"
+        "enabled =YES\n"
+        "ratio = 0.25\n"
+        "counter = 5000000000\n"
+        "mask = 0xff\n"
+        "name = \"  spaced out  \"\n"
+        "quoted = \"42\"\n"
+        "empty =\n"
+        "# Another comment\n"
+        "port = 8081";
+    static char const badText[] = "a = 1\nb = 2\nno delimiter here\nc = 3\n";
+    static char const floatText[] = "f = -2.25e1\ng = 1,5";
+    char const *filename = "misclibTest_keyvalue.ini";
+    FILE *fp;
+
+    pCollection = kv_createCollection();
+    expectNotNull(pCollection);
+
+    expectFalse(kv_parseIni(pCollection, iniText, strlen(iniText), &error));
+    expectTrue(0 == error.line);
+    expectTrue(strcmp(kv_getString(pCollection, "top"), "level") == 0);
+    expectTrue(kv_getTypeFromObject(kv_findObjectForKey(pCollection, "server.port")) == KV_VALUE_INTEGER);
+    expectTrue(kv_getInt(pCollection, "server.port") == 8081);
+    expectTrue(kv_getBool(pCollection, "server.enabled") == true);
+    expectTrue(kv_getFloat(pCollection, "server.ratio") == 0.25);
+    expectTrue(kv_getInt64(pCollection, "server.counter") == INT64_C(5000000000));
+    expectTrue(kv_getInt(pCollection, "server.mask") == 0xff);
+    expectTrue(strcmp(kv_getString(pCollection, "server.name"), "  spaced out  ") == 0);
+    expectTrue(strcmp(kv_getString(pCollection, "server.quoted"), "42") == 0);
+    expectTrue(strcmp(kv_getString(pCollection, "server.empty"), "") == 0);
+    expectNull(kv_findObjectForKey(pCollection, "port"));
+
+    // A duplicate key may change the type of the value.
+    expectFalse(kv_parseIni(pCollection, "top = 3", 7, NULL));
+    expectTrue(kv_getInt(pCollection, "top") == 3);
+
+    // The decimal point of the locale is not used, if one is installed.
+    if ((NULL != setlocale(LC_NUMERIC, "de_DE.UTF-8"))
+        || (NULL != setlocale(LC_NUMERIC, "de_DE"))
+        || (NULL != setlocale(LC_NUMERIC, "German_Germany.1252"))) {
+        bool ok;
+
+        ok = !kv_parseIni(pCollection, floatText, strlen(floatText), NULL)
+             && (kv_getFloat(pCollection, "f") == -22.5)
+             && (kv_getTypeFromObject(kv_findObjectForKey(pCollection, "g")) == KV_VALUE_STRING);
+        (void) setlocale(LC_NUMERIC, "C");
+        expectTrue(ok);
+    }
+    expectFalse(kv_parseIni(pCollection, floatText, strlen(floatText), NULL));
+    expectTrue(kv_getFloat(pCollection, "f") == -22.5);
+    expectTrue(kv_getTypeFromObject(kv_findObjectForKey(pCollection, "g")) == KV_VALUE_STRING);
+
+    // Errors must report the line number.
+    kv_clearCollection(pCollection);
+    expectTrue(kv_parseIni(pCollection, badText, strlen(badText), &error));
+    expectTrue(3 == error.line);
+    expectNotNull(error.message);
+    expectTrue(kv_getInt(pCollection, "b") == 2);
+    expectNull(kv_findObjectForKey(pCollection, "c"));
+    expectTrue(kv_parseIni(pCollection, "[open", 5, &error));
+    expectTrue(1 == error.line);
+    expectTrue(kv_parseIni(pCollection, "x=1\n = 2", strlen("x=1\n = 2"), &error));
+    expectTrue(2 == error.line);
+
+    // Load the same text from a file.
+    kv_clearCollection(pCollection);
+    fp = fopen(filename, "wb");
+    expectNotNull(fp);
+    expectTrue(fwrite(iniText, 1, strlen(iniText), fp) == strlen(iniText));
+    expectTrue(fclose(fp) == 0);
+    expectFalse(kv_loadIniFile(pCollection, filename, &error));
+    (void) remove(filename);
+    expectTrue(kv_getInt(pCollection, "server.port") == 8081);
+    expectTrue(kv_loadIniFile(pCollection, filename, &error));
+    expectTrue(0 == error.line);
+
+    kv_freeCollection(pCollection);
+
+    return true;
+} // unittest_keyvalue_ini()
+
+
+
+/** Sink for kv_writeJSON() that appends to a buffer. */
+static bool unittest_keyvalue_json_sink(void *pContext, char const *pData, size_t length) {
+    char *pBuffer = (char *) pContext;
+    size_t used = strlen(pBuffer);
+
+    memcpy(pBuffer + used, pData, length);
+    pBuffer[used + length] = '\0';
+    return false;
+} // unittest_keyvalue_json_sink()
+
+
+
+static bool unittest_keyvalue_json(void) {
+    kv_collection_t *pCollection;
+    kv_parse_error_t error;
+    static unsigned char const blobData[] = { 0x00, 0x7f, 0xab };
+    static char const expected[] =
+        "{\"b\":true,\"i\":-42,\"i64\":-9223372036854775808,"
+        "\"f\":0.1,\"fi\":-3.0,\"s\":\"a\\\"b\\\\c\\nd\\u0001\","
+        "\"blob\":\"007FAB\",\"null\":null}";
+    char buffer[256];
+    char text[] =
+        "{ \"name\" : \"caf\\u00e9 \\ud83d\\ude00\\t\\\"x\\\"\",\n"
+        "  \"int\": 2147483647, \"big\": -2147483649,\n"
+        "  \"float\": -1.5e3, \"yes\": true, \"no\": false, \"nothing\": null }";
+    size_t length;
+
+    pCollection = kv_createCollection();
+    expectNotNull(pCollection);
+
+    expectTrue(kv_toJSON(pCollection, buffer, sizeof(buffer)) == 2);
+    expectTrue(strcmp(buffer, "{}") == 0);
+
+    expectNotNull(kv_insertBool(pCollection, "b", true));
+    expectNotNull(kv_insertInt(pCollection, "i", -42));
+    expectNotNull(kv_insertInt64(pCollection, "i64", INT64_MIN));
+    expectNotNull(kv_insertFloat(pCollection, "f", 0.1));
+    expectNotNull(kv_insertFloat(pCollection, "fi", -3.0));
+    expectNotNull(kv_insertString(pCollection, "s", "a\"b\\c\nd\x01"));
+    expectNotNull(kv_insertBlob(pCollection, "blob", blobData, sizeof(blobData)));
+    expectNotNull(kv_insertPointer(pCollection, "null", NULL));
+
+    // Serialize into a buffer, with size query and truncation.
+    length = kv_toJSON(pCollection, NULL, 0);
+    expectTrue(length == strlen(expected));
+    expectTrue(kv_toJSON(pCollection, buffer, sizeof(buffer)) == length);
+    expectTrue(strcmp(buffer, expected) == 0);
+    expectTrue(kv_toJSON(pCollection, buffer, 10) == length);
+    expectTrue(strlen(buffer) == 9);
+    expectTrue(strncmp(buffer, expected, 9) == 0);
+
+    // Serialize through a sink.
+    buffer[0] = '\0';
+    expectFalse(kv_writeJSON(pCollection, unittest_keyvalue_json_sink, buffer));
+    expectTrue(strcmp(buffer, expected) == 0);
+
+    // Parse in place.
+    kv_clearCollection(pCollection);
+    expectFalse(kv_fromJSON(pCollection, text, strlen(text), true, &error));
+    expectTrue(strcmp(kv_getString(pCollection, "name"), "caf\xc3\xa9 \xf0\x9f\x98\x80\t\"x\"") == 0);
+    expectTrue((kv_getString(pCollection, "name") >= text)
+               && (kv_getString(pCollection, "name") < text + sizeof(text)));
+    expectTrue(kv_getInt(pCollection, "int") == 2147483647);
+    expectTrue(kv_getInt64(pCollection, "big") == INT64_C(-2147483649));
+    expectTrue(kv_getFloat(pCollection, "float") == -1500.0);
+    expectTrue(kv_getBool(pCollection, "yes") == true);
+    expectTrue(kv_getBool(pCollection, "no") == false);
+    expectTrue(kv_getTypeFromObject(kv_findObjectForKey(pCollection, "nothing")) == KV_VALUE_POINTER);
+
+    // Round trip of the serialized collection.
+    kv_clearCollection(pCollection);
+    strcpy(buffer, "{\"s\":\"a\\\"b\\\\c\\nd\\u0001\",\"f\":0.1}");
+    expectFalse(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    expectTrue(strcmp(kv_getString(pCollection, "s"), "a\"b\\c\nd\x01") == 0);
+    expectTrue(kv_getFloat(pCollection, "f") == 0.1);
+
+    // The sign of zero survives.
+    kv_clearCollection(pCollection);
+    expectNotNull(kv_insertFloat(pCollection, "z", -0.0));
+    expectTrue(kv_toJSON(pCollection, buffer, sizeof(buffer)) == 10);
+    expectTrue(strcmp(buffer, "{\"z\":-0.0}") == 0);
+    expectFalse(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    expectTrue(signbit(kv_getFloat(pCollection, "z")));
+
+    // The decimal point of the locale is not used, if one is installed.
+    if ((NULL != setlocale(LC_NUMERIC, "de_DE.UTF-8"))
+        || (NULL != setlocale(LC_NUMERIC, "de_DE"))
+        || (NULL != setlocale(LC_NUMERIC, "German_Germany.1252"))) {
+        bool ok;
+
+        kv_clearCollection(pCollection);
+        expectNotNull(kv_insertFloat(pCollection, "f", 1.5));
+        (void) kv_toJSON(pCollection, buffer, sizeof(buffer));
+        ok = (strcmp(buffer, "{\"f\":1.5}") == 0);
+        strcpy(buffer, "{\"f\":-2.25e1}");
+        ok = ok && !kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error)
+             && (kv_getFloat(pCollection, "f") == -22.5);
+        (void) setlocale(LC_NUMERIC, "C");
+        expectTrue(ok);
+    }
+
+    // Errors report the line.
+    strcpy(buffer, "{\"a\": 1,\n\"b\": [1]}");
+    expectTrue(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    expectTrue(2 == error.line);
+    strcpy(buffer, "{\"a\": 01}");
+    expectTrue(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    strcpy(buffer, "{\"a\": 1");
+    expectTrue(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    strcpy(buffer, "{\"a\": \"\\ud800\"}");
+    expectTrue(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+    strcpy(buffer, "{} x");
+    expectTrue(kv_fromJSON(pCollection, buffer, strlen(buffer), false, &error));
+
+    kv_freeCollection(pCollection);
+
+    return true;
+} // unittest_keyvalue_json()
+
+
+
+static bool unittest_keyvalue_statistics(void) {
+    kv_collection_t *pCollection;
+    kv_statistics_t statistics;
+    static unsigned char const blobData[] = { 1, 2, 3, 4 };
+    char key[16];
+    int i;
+
+    pCollection = kv_createCollection();
+    expectNotNull(pCollection);
+
+    kv_getStatistics(pCollection, &statistics);
+    expectTrue(0 == statistics.nrObjects);
+    expectTrue(0 == statistics.maximumChainLength);
+    expectTrue(0 == statistics.counters.nrLookups);
+
+    // Only owned values count.
+    expectNotNull(kv_insertString(pCollection, "s", "abc"));
+    expectNotNull(kv_insertBorrowedString(pCollection, "b", "borrowed"));
+    expectNotNull(kv_insertBlob(pCollection, "blob", blobData, sizeof(blobData)));
+    kv_getStatistics(pCollection, &statistics);
+    expectTrue(3 == statistics.nrObjects);
+    expectTrue(3 * sizeof(kv_object_t) == statistics.objectBytes);
+    expectTrue(2 + 2 + 5 == statistics.keyBytes);
+    expectTrue(4 + sizeof(blobData) == statistics.valueBytes);
+
+    // Lookups are only counted once enabled.
+    expectFalse(kv_enableLookupCounters(pCollection, true));
+    expectNotNull(kv_findObjectForKey(pCollection, "s"));
+    expectNull(kv_findObjectForKey(pCollection, "missing"));
+    kv_getStatistics(pCollection, &statistics);
+    expectTrue(2 == statistics.counters.nrLookups);
+    expectTrue(1 == statistics.counters.nrHits);
+    expectTrue(1 == statistics.counters.nrMisses);
+    expectTrue(statistics.counters.nrProbes >= 1);
+
+    // A large collection keeps its chains short.
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        expectNotNull(kv_insertInt(pCollection, key, i));
+    }
+    kv_getStatistics(pCollection, &statistics);
+    expectTrue(1003 == statistics.nrObjects);
+    expectTrue(statistics.nrBuckets >= 1003);
+    expectTrue(statistics.nrUsedBuckets > 0);
+    expectTrue(statistics.averageChainLength >= 1.0);
+    expectTrue(statistics.averageChainLength < 3.0);
+    expectTrue(statistics.maximumChainLength < 16);
+    expectTrue(statistics.counters.nrLookups > 1000);
+
+    expectFalse(kv_enableLookupCounters(pCollection, false));
+    kv_getStatistics(pCollection, &statistics);
+    expectTrue(0 == statistics.counters.nrLookups);
+
+    kv_freeCollection(pCollection);
+
+    return true;
+} // unittest_keyvalue_statistics()
+
+
+
+/** Counts the differences reported by kv_diff() per kind and remembers the
+   key of the last one.
+ */
+typedef struct {
+    unsigned nrChanges[3];
+    char const *lastKey;
+} unittest_keyvalue_diff_t;
+
+static bool unittest_keyvalue_diff_callback(void *pContext,
+                                            kv_change_t change,
+                                            kv_object_t const *pOldObject,
+                                            kv_object_t const *pNewObject) {
+    unittest_keyvalue_diff_t *pDiff = pContext;
+
+    pDiff->nrChanges[change]++;
+    pDiff->lastKey = (NULL != pNewObject) ? pNewObject->key : pOldObject->key;
+    return false;
+} // unittest_keyvalue_diff_callback()
+
+
+
+static bool unittest_keyvalue_diff_merge(void) {
+    kv_collection_t *pOld, *pNew;
+    unittest_keyvalue_diff_t diff;
+    char key[16];
+    int i;
+
+    pOld = kv_createCollection();
+    expectNotNull(pOld);
+    pNew = kv_createCollection();
+    expectNotNull(pNew);
+
+    expectNotNull(kv_insertInt(pOld, "same", 1));
+    expectNotNull(kv_insertInt(pOld, "value", 1));
+    expectNotNull(kv_insertInt(pOld, "type", 1));
+    expectNotNull(kv_insertString(pOld, "string", "abc"));
+    expectNotNull(kv_insertString(pOld, "removed", "x"));
+    expectNotNull(kv_insertInt(pNew, "same", 1));
+    expectNotNull(kv_insertInt(pNew, "value", 2));
+    expectNotNull(kv_insertInt64(pNew, "type", 1));
+    expectNotNull(kv_insertBorrowedString(pNew, "string", "abc"));
+    expectNotNull(kv_insertBool(pNew, "added", true));
+
+    memset(&diff, 0, sizeof(diff));
+    expectFalse(kv_diff(pOld, pNew, unittest_keyvalue_diff_callback, &diff));
+    expectTrue(1 == diff.nrChanges[KV_CHANGE_ADDED]);
+    expectTrue(1 == diff.nrChanges[KV_CHANGE_REMOVED]);
+    expectTrue(2 == diff.nrChanges[KV_CHANGE_CHANGED]);
+    expectTrue(strcmp(diff.lastKey, "added") == 0);
+
+    // Keep the existing values, only add the missing keys.
+    expectFalse(kv_merge(pOld, pNew, KV_MERGE_KEEP_EXISTING));
+    expectTrue(6 == pOld->nrObjects);
+    expectTrue(kv_getInt(pOld, "value") == 1);
+    expectTrue(kv_getBool(pOld, "added") == true);
+
+    // Overwrite the values, changing the type where needed.
+    expectFalse(kv_merge(pOld, pNew, KV_MERGE_OVERWRITE));
+    expectTrue(kv_getInt(pOld, "value") == 2);
+    expectTrue(kv_getTypeFromObject(kv_findObjectForKey(pOld, "type")) == KV_VALUE_INT64);
+    expectTrue(kv_getString(pOld, "string") != kv_getString(pNew, "string"));
+    memset(&diff, 0, sizeof(diff));
+    expectFalse(kv_diff(pOld, pNew, unittest_keyvalue_diff_callback, &diff));
+    expectTrue(0 == diff.nrChanges[KV_CHANGE_ADDED]);
+    expectTrue(1 == diff.nrChanges[KV_CHANGE_REMOVED]);
+    expectTrue(0 == diff.nrChanges[KV_CHANGE_CHANGED]);
+
+    // Large collections compare in linear time.
+    kv_clearCollection(pOld);
+    kv_clearCollection(pNew);
+    for (i = 0; i < 20000; i++) {
+        sprintf(key, "key%d", i);
+        expectNotNull(kv_insertInt(pOld, key, i));
+        expectNotNull(kv_insertInt(pNew, key, (i % 100 == 0) ? -i : i));
+    }
+    memset(&diff, 0, sizeof(diff));
+    expectFalse(kv_diff(pOld, pNew, unittest_keyvalue_diff_callback, &diff));
+    expectTrue(199 == diff.nrChanges[KV_CHANGE_CHANGED]);
+
+    kv_freeCollection(pOld);
+    kv_freeCollection(pNew);
+
+    return true;
+} // unittest_keyvalue_diff_merge()
+
+
+
+static bool unittest_keyvalue_performance_ini(void) {
+    clock_t startclock, endclock;
+    kv_collection_t *pCollection;
+    char *pText, *p;
+    int i;
+    double t;
+    kv_parse_error_t error;
+
+#define NR_INI_LINES 100000
+
+    if (NULL == (pText = malloc(NR_INI_LINES * 48))) {
+        log_logMessage(LOGLEVEL_ERROR, "malloc() failed: %s", strerror(errno));
+        return false;
+    }
+    p = pText;
+    for (i = 0; i < NR_INI_LINES; i++) {
+        if (0 == i % 1000) {
+            p += sprintf(p, "[section%d]\n", i / 1000);
+        }
+        p += sprintf(p, "key%08x = %d\n", i, i);
+    }
+
+    pCollection = kv_createCollection();
+    expectNotNull(pCollection);
+
+    log_logMessage(LOGLEVEL_INFO, "Starting kv_parseIni() timing ...");
+    startclock = clock();
+    expectFalse(kv_parseIni(pCollection, pText, (size_t) (p - pText), &error));
+    endclock = clock();
+
+    t = ((double) (endclock - startclock)) / (double) CLOCKS_PER_SEC;
+    log_logMessage(LOGLEVEL_INFO,
+                   "kv_parseIni()\t%.3f s for %d lines (%lu bytes)",
+                   t, NR_INI_LINES, (unsigned long) (p - pText));
+
+    expectTrue(kv_getInt(pCollection, "section99.key0001869f") == NR_INI_LINES - 1);
+    kv_freeCollection(pCollection);
+    free(pText);
+
+    return true;
+} // unittest_keyvalue_performance_ini()
+
+
+
 static bool unittest_keyvalue_performance_write(void) {
     clock_t startclock, endclock;
     kv_collection_t *pCollection;
@@ -174,6 +643,7 @@ static bool unittest_keyvalue_performance_write(void) {
                    "kv_insertInt()\t%.2f s (%f us/operation)",
                    t, (t / i) * 1000000.0);
 
+    kv_freeCollection(pCollection);
 
     return true;
 } // unittest_keyvalue_performance_write()
@@ -186,7 +656,13 @@ bool unittest_keyvalue(void) {
     log_logMessage(LOGLEVEL_INFO, "Testing keyvalue");
 
     testsAllPassed &= unittest_keyvalue_functional();
+    testsAllPassed &= unittest_keyvalue_types();
+    testsAllPassed &= unittest_keyvalue_ini();
+    testsAllPassed &= unittest_keyvalue_json();
+    testsAllPassed &= unittest_keyvalue_statistics();
+    testsAllPassed &= unittest_keyvalue_diff_merge();
     testsAllPassed &= unittest_keyvalue_performance_write();
+    testsAllPassed &= unittest_keyvalue_performance_ini();
 
     return testsAllPassed;
 } // unittest_keyvalue_functional()
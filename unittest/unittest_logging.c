@@ -0,0 +1,1098 @@
+/** Unit tests for the logging module.
+
+   @file unittest_logging.c
+   @ingroup misclib
+
+   @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+   @note The master repository for this file is at
+    <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    Copyright 2016, 2017 Christian Doenges (Christian D&ouml;nges)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "logging.h"
+#include "misclibTest.h"
+#if LOGGING_THREADS
+#include <pthread.h>
+#include <time.h>
+#endif // LOGGING_THREADS
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+
+/** The log file used by the tests. */
+#define UNITTEST_LOGFILE "unittest_logging.log"
+/** The dump file of the flight recorder used by the tests. */
+#define UNITTEST_DUMPFILE "unittest_logging.dump"
+/** The category configuration file used by the tests. */
+#define UNITTEST_CATEGORYFILE "unittest_logging.ini"
+/** The number of threads logging concurrently. */
+#define UNITTEST_NR_THREADS 4
+/** The number of messages each thread logs. */
+#define UNITTEST_NR_MESSAGES 2000
+
+
+
+/** Reads an entire file into a buffer.
+
+   @param filename The name of the file.
+   @param pLength Receives the number of bytes read.
+   @return The NUL-terminated content, to be free()d by the caller, or NULL.
+ */
+static char *unittest_logging_readFile(char const *filename, size_t *pLength) {
+    FILE *fh;
+    char *pContent;
+    long size;
+
+    if (NULL == (fh = fopen(filename, "rb"))) {
+        return NULL;
+    }
+    (void) fseek(fh, 0, SEEK_END);
+    size = ftell(fh);
+    (void) fseek(fh, 0, SEEK_SET);
+    if (NULL != (pContent = malloc((size_t) size + 1))) {
+        *pLength = fread(pContent, 1, (size_t) size, fh);
+        pContent[*pLength] = '\0';
+    }
+    fclose(fh);
+    return pContent;
+} // unittest_logging_readFile()
+
+
+
+/** Reads the entire log file into a buffer.
+
+   @param pLength Receives the number of bytes read.
+   @return The NUL-terminated content, to be free()d by the caller, or NULL.
+ */
+static char *unittest_logging_readLogfile(size_t *pLength) {
+    return unittest_logging_readFile(UNITTEST_LOGFILE, pLength);
+} // unittest_logging_readLogfile()
+
+
+
+/** Counts the lines in a string.
+
+   @param pText The string.
+   @return The number of LF characters.
+ */
+static unsigned long unittest_logging_countLines(char const *pText) {
+    unsigned long nrLines = 0;
+
+    while (NULL != (pText = strchr(pText, '\n'))) {
+        nrLines++;
+        pText++;
+    }
+    return nrLines;
+} // unittest_logging_countLines()
+
+
+
+static bool unittest_logging_format(void) {
+    static char const expected[] =
+        "INFO: value 42\n"
+        "WARNING: start 1, continued 2\n"
+        "ERROR: done\n";
+    char *pLongMessage;
+    char *pContent;
+    size_t length;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+
+    // Each message is formatted once, including the prefix.
+    log_logMessage(LOGLEVEL_INFO, "value %d", 42);
+    log_logMessage(LOGLEVEL_DEBUG, "filtered %d", 0);
+    log_logMessageStart(LOGLEVEL_WARNING, "start %d", 1);
+    log_logMessageContinue(LOGLEVEL_WARNING, ", continued %d\n", 2);
+    log_logMessage(LOGLEVEL_ERROR, "done");
+    log_flush();
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, expected) == 0);
+    free(pContent);
+
+    // Messages longer than the format buffer are not truncated.
+    pLongMessage = malloc(10000);
+    expectNotNull(pLongMessage);
+    memset(pLongMessage, 'y', 9999);
+    pLongMessage[9999] = '\0';
+    log_logMessage(LOGLEVEL_INFO, "%s", pLongMessage);
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length == sizeof(expected) - 1 + 6 + 9999 + 1);
+    expectNotNull(strstr(pContent, pLongMessage));
+    free(pContent);
+    free(pLongMessage);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_format()
+
+
+
+static bool unittest_logging_timestamps(void) {
+    char *pContent, *pLine;
+    size_t length;
+    int year, month, day, hour, minute, second, microsecond, consumed;
+    unsigned long nrLines = 0;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_setTimestamps(true);
+    log_logMessage(LOGLEVEL_INFO, "stamped %d", 1);
+    log_logMessageStart(LOGLEVEL_WARNING, "stamped %d", 2);
+    log_logMessageContinue(LOGLEVEL_WARNING, "\n");
+    log_setTimestamps(false);
+    log_logMessage(LOGLEVEL_INFO, "plain");
+    expectFalse(log_closeLogfile());
+
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    for (pLine = strtok(pContent, "\n"); NULL != pLine; pLine = strtok(NULL, "\n")) {
+        nrLines++;
+        if (3 == nrLines) {
+            expectTrue(strcmp(pLine, "INFO: plain") == 0);
+            continue;
+        }
+        consumed = 0;
+        expectTrue(sscanf(pLine, "%4d-%2d-%2d %2d:%2d:%2d.%6d %n",
+                          &year, &month, &day, &hour, &minute, &second, &microsecond,
+                          &consumed) == 7);
+        expectTrue(27 == consumed);
+        expectTrue((month >= 1) && (month <= 12) && (microsecond >= 0) && (microsecond < 1000000));
+        expectTrue(strcmp(pLine + consumed, (1 == nrLines) ? "INFO: stamped 1" : "WARNING: stamped 2") == 0);
+    }
+    expectTrue(3 == nrLines);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_timestamps()
+
+
+
+static bool unittest_logging_mapped(void) {
+#ifndef _WIN32
+    char *pContent;
+    size_t length;
+
+    expectFalse(log_openMappedLogfile(UNITTEST_LOGFILE, false, 0));
+    log_logMessage(LOGLEVEL_INFO, "one");
+    log_logMessage(LOGLEVEL_INFO, "two");
+
+    // The file is extended in chunks, the messages are visible right away.
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length > 20);
+    expectTrue(strcmp(pContent, "INFO: one\nINFO: two\n") == 0);
+    free(pContent);
+
+    // Closing truncates the file to the messages written.
+    expectFalse(log_closeLogfile());
+    expectFalse(log_openMappedLogfile(UNITTEST_LOGFILE, true, 16));
+    log_logMessage(LOGLEVEL_INFO, "three");
+    log_logMessage(LOGLEVEL_INFO, "discarded");
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length == 32);
+    expectTrue(strcmp(pContent, "INFO: one\nINFO: two\nINFO: three\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+#endif // !_WIN32
+
+    return true;
+} // unittest_logging_mapped()
+
+
+
+static bool unittest_logging_flush(void) {
+    char *pContent;
+    size_t length;
+#if LOGGING_THREADS
+    int i;
+#endif // LOGGING_THREADS
+
+    // Buffer until enough bytes have been written.
+    expectTrue(log_setFlushPolicy(LOG_FLUSH_BYTES, 0));
+    expectFalse(log_setFlushPolicy(LOG_FLUSH_BYTES, 100));
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_logMessage(LOGLEVEL_INFO, "buffered");
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(0 == length);
+    free(pContent);
+    log_logMessage(LOGLEVEL_INFO, "%0100d", 0);
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length == 15 + 107);
+    free(pContent);
+
+    // Buffer everything below LOGLEVEL_ERROR.
+    expectFalse(log_setFlushPolicy(LOG_FLUSH_ERROR, 0));
+    log_logMessage(LOGLEVEL_WARNING, "buffered");
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length == 15 + 107);
+    free(pContent);
+    log_logMessage(LOGLEVEL_ERROR, "flushed");
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(length == 15 + 107 + 18 + 15);
+    free(pContent);
+
+#if LOGGING_THREADS
+    // Flush by a timer.
+    expectFalse(log_setFlushPolicy(LOG_FLUSH_INTERVAL, 10));
+    log_logMessage(LOGLEVEL_INFO, "timer");
+    for (i = 0; i < 100; i++) {
+        struct timespec pause = { 0, 10000000L };
+
+        pContent = unittest_logging_readLogfile(&length);
+        expectNotNull(pContent);
+        free(pContent);
+        if (15 + 107 + 18 + 15 + 12 == length) {
+            break;
+        }
+        (void) nanosleep(&pause, NULL);
+    }
+    expectTrue(15 + 107 + 18 + 15 + 12 == length);
+#endif // LOGGING_THREADS
+
+    expectFalse(log_setFlushPolicy(LOG_FLUSH_EVERY_MESSAGE, 0));
+    expectFalse(log_closeLogfile());
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_flush()
+
+
+
+static bool unittest_logging_binary(void) {
+#if LOGGING_API_USES_VARIADIC_MACROS
+    static char const expected[] =
+        "INFO: plain\n"
+        "WARNING: int -42 unsigned 4294967295 hex 0x00ff size 123 long 1234567890123\n"
+        "INFO: float 3.25 text 'abc' null (null) 100% [   7]\n"
+        "INFO: plain\n";
+    char const *pNull = NULL;
+    wchar_t const *pWide = L"abc";
+    FILE *pInput, *pOutput;
+    char *pContent;
+    char text[512];
+    size_t length;
+    int i;
+
+    expectFalse(log_openBinaryLogfile(UNITTEST_LOGFILE ".bin", LOGLEVEL_INFO));
+    for (i = 0; i < 2; i++) {
+        // The same call site is defined only once.
+        log_logBinary(LOGLEVEL_INFO, "plain");
+        if (0 == i) {
+            log_logBinary(LOGLEVEL_WARNING, "int %d unsigned %u hex 0x%04x size %zu long %lld",
+                          -42, 4294967295u, 255, (size_t) 123, 1234567890123ll);
+            log_logBinary(LOGLEVEL_INFO, "float %.2f text '%s' null %s 100%% [%*d]",
+                          3.25, "abc", pNull, 4, 7);
+        }
+        log_logBinary(LOGLEVEL_DEBUG, "below the level %d", i);
+    }
+    expectFalse(log_closeBinaryLogfile());
+
+    pInput = fopen(UNITTEST_LOGFILE ".bin", "rb");
+    expectNotNull(pInput);
+    pOutput = fopen(UNITTEST_LOGFILE, "w");
+    expectNotNull(pOutput);
+    expectFalse(log_decodeBinary(pInput, pOutput));
+    fclose(pInput);
+    fclose(pOutput);
+
+    pOutput = fopen(UNITTEST_LOGFILE, "r");
+    expectNotNull(pOutput);
+    length = fread(text, 1, sizeof(text) - 1, pOutput);
+    text[length] = '\0';
+    fclose(pOutput);
+    expectTrue(strcmp(text, expected) == 0);
+
+    // Wide characters and strings are left to the text log.
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    expectFalse(log_openBinaryLogfile(UNITTEST_LOGFILE ".bin", LOGLEVEL_INFO));
+    log_logBinary(LOGLEVEL_INFO, "wide %ls %lc", pWide, (wint_t) L'x');
+    expectFalse(log_closeBinaryLogfile());
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readFile(UNITTEST_LOGFILE, &length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, "INFO: wide abc x\n") == 0);
+    free(pContent);
+    pInput = fopen(UNITTEST_LOGFILE ".bin", "rb");
+    expectNotNull(pInput);
+    pOutput = fopen(UNITTEST_LOGFILE, "w");
+    expectNotNull(pOutput);
+    expectFalse(log_decodeBinary(pInput, pOutput));
+    fclose(pInput);
+    fclose(pOutput);
+    pContent = unittest_logging_readFile(UNITTEST_LOGFILE, &length);
+    expectNotNull(pContent);
+    expectTrue(0 == length);
+    free(pContent);
+
+    // A corrupt call site id is rejected instead of growing the table.
+    pInput = fopen(UNITTEST_LOGFILE ".bin", "wb");
+    expectNotNull(pInput);
+    (void) fwrite("MLB1D\x00\x00\x00\x80\x03\x00\x00\x00\x00\x00\x00", 1, 16, pInput);
+    fclose(pInput);
+    pInput = fopen(UNITTEST_LOGFILE ".bin", "rb");
+    expectNotNull(pInput);
+    pOutput = fopen(UNITTEST_LOGFILE, "w");
+    expectNotNull(pOutput);
+    expectTrue(log_decodeBinary(pInput, pOutput));
+    fclose(pInput);
+    fclose(pOutput);
+
+    (void) remove(UNITTEST_LOGFILE ".bin");
+    (void) remove(UNITTEST_LOGFILE);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+    return true;
+} // unittest_logging_binary()
+
+
+
+/** Categories used by the tests. */
+static LOG_DEFINE_CATEGORY(unittestCategoryA, "unittest.a");
+static LOG_DEFINE_CATEGORY(unittestCategoryB, "unittest.b");
+
+/** The number of calls of unittest_logging_argument(). */
+static int unittestArgumentCalls = 0;
+
+
+
+/** Counts its calls, to detect the evaluation of arguments.
+
+   @return The number of calls so far.
+ */
+static int unittest_logging_argument(void) {
+    return ++unittestArgumentCalls;
+} // unittest_logging_argument()
+
+
+
+/** Writes the category configuration file.
+
+   @param pText The content of the file.
+ */
+static void unittest_logging_writeCategoryFile(char const *pText) {
+    FILE *fh = fopen(UNITTEST_CATEGORYFILE, "w");
+
+    if (NULL != fh) {
+        (void) fputs(pText, fh);
+        (void) fclose(fh);
+    }
+} // unittest_logging_writeCategoryFile()
+
+
+
+static bool unittest_logging_categories(void) {
+#if LOGGING_API_USES_VARIADIC_MACROS
+    char *pContent;
+    size_t length;
+#if defined(SIGHUP) && LOGGING_THREADS
+    int i;
+#endif // SIGHUP && LOGGING_THREADS
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_setFileLevel(LOGLEVEL_DEBUG);
+    log_setDefaultCategoryLevel(LOGLEVEL_INFO);
+
+    // A disabled level does not evaluate the arguments.
+    log_logCategory(unittestCategoryA, LOGLEVEL_DEBUG, "a %d", unittest_logging_argument());
+    log_logCategory(unittestCategoryA, LOGLEVEL_INFO, "a %d", unittest_logging_argument());
+    expectTrue(1 == unittestArgumentCalls);
+    expectFalse(log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_DEBUG));
+
+    // Levels are set by name, also for categories not registered yet.
+    expectFalse(log_setCategoryLevel("unittest.b", LOGLEVEL_DEBUG));
+    log_logCategory(unittestCategoryA, LOGLEVEL_DEBUG, "a %d", 2);
+    log_logCategory(unittestCategoryB, LOGLEVEL_DEBUG, "b %d", 2);
+    expectTrue(log_isCategoryEnabled(unittestCategoryB, LOGLEVEL_DEBUG));
+
+    // The configuration file is validated before anything is changed.
+    unittest_logging_writeCategoryFile("[categories]\nunittest.a = LOUD\n");
+    expectTrue(log_loadCategoryConfig(UNITTEST_CATEGORYFILE));
+    expectTrue(log_isCategoryEnabled(unittestCategoryB, LOGLEVEL_DEBUG));
+    unittest_logging_writeCategoryFile("[categories]\ndefault = warning\nunittest.a = debug\nunittest.b = NONE\n");
+    expectFalse(log_loadCategoryConfig(UNITTEST_CATEGORYFILE));
+    expectTrue(log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_DEBUG));
+    expectFalse(log_isCategoryEnabled(unittestCategoryB, LOGLEVEL_FATAL));
+    expectTrue(log_isCategoryEnabled(unittestCategoryB, LOGLEVEL_ALWAYS));
+
+    // A reload replaces the levels of the previous file.
+    unittest_logging_writeCategoryFile("[categories]\ndefault = warning\n");
+    expectFalse(log_loadCategoryConfig(UNITTEST_CATEGORYFILE));
+    expectFalse(log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_INFO));
+    expectTrue(log_isCategoryEnabled(unittestCategoryB, LOGLEVEL_DEBUG));
+    expectFalse(log_setCategoryLevel("unittest.a", LOGLEVEL_DEBUG));
+    expectTrue(log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_DEBUG));
+
+    // The default level also applies to messages without a category, so
+    // the channels may accept the low levels of selected categories only.
+    log_logMessage(LOGLEVEL_INFO, "uncategorized %d", 1);
+    log_logCategory(unittestCategoryB, LOGLEVEL_DEBUG, "b %d", 3);
+
+#ifdef SIGHUP
+    // A reload is requested by a signal and done by a thread of its own.
+    expectFalse(log_installCategoryReloadHandler(UNITTEST_CATEGORYFILE));
+    unittest_logging_writeCategoryFile("[categories]\nunittest.a = ERROR\n");
+    expectTrue(raise(SIGHUP) == 0);
+#if LOGGING_THREADS
+    for (i = 0; (i < 1000) && log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_WARNING); i++) {
+        struct timespec pause = { 0, 1000000L };
+
+        (void) nanosleep(&pause, NULL);
+    }
+#else
+    log_checkCategoryReload();
+#endif // !LOGGING_THREADS
+    expectFalse(log_isCategoryEnabled(unittestCategoryA, LOGLEVEL_WARNING));
+    (void) signal(SIGHUP, SIG_DFL);
+#endif // SIGHUP
+
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectNotNull(strstr(pContent, "INFO: a 1\n"));
+    expectNull(strstr(pContent, "DEBUG: a 2\n"));
+    expectNotNull(strstr(pContent, "DEBUG: b 2\n"));
+    expectNull(strstr(pContent, "uncategorized"));
+    expectNotNull(strstr(pContent, "DEBUG: b 3\n"));
+    free(pContent);
+
+    log_setFileLevel(LOGLEVEL_INFO);
+    log_setDefaultCategoryLevel(LOGLEVEL_DEBUG3);
+    expectFalse(log_setCategoryLevel("unittest.a", LOGLEVEL_DEBUG3));
+    expectFalse(log_setCategoryLevel("unittest.b", LOGLEVEL_DEBUG3));
+    (void) remove(UNITTEST_CATEGORYFILE);
+    (void) remove(UNITTEST_LOGFILE);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+    return true;
+} // unittest_logging_categories()
+
+
+
+static bool unittest_logging_rateLimit(void) {
+#if LOGGING_API_USES_VARIADIC_MACROS
+    char *pContent;
+    size_t length;
+    int i, calls = unittestArgumentCalls;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+
+    // Only the burst is logged, the arguments of the rest are not evaluated.
+    for (i = 0; i < 100; i++) {
+        log_logRateLimited(1, 5, LOGLEVEL_INFO, "burst %d", unittest_logging_argument());
+    }
+    expectTrue(calls + 5 == unittestArgumentCalls);
+
+#if LOGGING_THREADS
+    // Once the bucket is refilled, the discarded messages are reported.
+    for (i = 0; i <= 100; i++) {
+        if (100 == i) {
+            struct timespec pause = { 0, 5000000L };
+
+            (void) nanosleep(&pause, NULL);
+        }
+        log_logRateLimited(1000, 1, LOGLEVEL_INFO, "refill %d", i);
+    }
+#endif // LOGGING_THREADS
+
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+#if LOGGING_THREADS
+    expectTrue(8 == unittest_logging_countLines(pContent));
+    expectNotNull(strstr(pContent, "INFO: refill 0\n"));
+    expectNull(strstr(pContent, "INFO: refill 1\n"));
+    expectNotNull(strstr(pContent, "suppressed by rate limit.\nINFO: refill 100\n"));
+#else
+    expectTrue(5 == unittest_logging_countLines(pContent));
+#endif // !LOGGING_THREADS
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+    return true;
+} // unittest_logging_rateLimit()
+
+
+
+static bool unittest_logging_sampled(void) {
+#if LOGGING_API_USES_VARIADIC_MACROS
+    static char const expected[] =
+        "INFO: summary 0\n"
+        "INFO: summary 3 (2 skipped)\n"
+        "INFO: summary 6 (4 skipped)\n";
+    char *pContent;
+    size_t length;
+    int i, calls = unittestArgumentCalls;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+
+    // The arguments of skipped messages are not evaluated.
+    for (i = 0; i < 25; i++) {
+        log_logSampled(10, LOGLEVEL_INFO, "sampled %d", unittest_logging_argument());
+    }
+    expectTrue(calls + 3 == unittestArgumentCalls);
+
+    log_setSamplingSummary(true);
+    for (i = 0; i < 8; i++) {
+        log_logSampled(3, LOGLEVEL_INFO, "summary %d", i);
+    }
+    log_setSamplingSummary(false);
+
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(6 == unittest_logging_countLines(pContent));
+    expectTrue(strncmp(pContent, "INFO: sampled ", 14) == 0);
+    expectTrue(strcmp(pContent + length - (sizeof(expected) - 1), expected) == 0);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+#endif // LOGGING_API_USES_VARIADIC_MACROS
+
+    return true;
+} // unittest_logging_sampled()
+
+
+
+static bool unittest_logging_duplicates(void) {
+    static char const expected[] =
+        "INFO: same\n"
+        "INFO: last message repeated 2 times\n"
+        "INFO: other\n"
+        "INFO: same\n"
+        "INFO: last message repeated 1 times\n";
+    char *pContent;
+    size_t length;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_setDuplicateSuppression(true);
+    log_logMessage(LOGLEVEL_INFO, "same");
+    log_logMessage(LOGLEVEL_INFO, "same");
+    log_logMessage(LOGLEVEL_INFO, "same");
+    log_logMessage(LOGLEVEL_INFO, "other");
+    log_logMessage(LOGLEVEL_INFO, "same");
+    log_logMessage(LOGLEVEL_INFO, "same");
+    log_flush();
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, expected) == 0);
+    free(pContent);
+
+    // Timestamps are ignored when comparing.
+    log_setTimestamps(true);
+    log_logMessageStart(LOGLEVEL_WARNING, "stamped");
+    log_logMessageContinue(LOGLEVEL_WARNING, "\n");
+    log_logMessage(LOGLEVEL_WARNING, "stamped");
+    log_setTimestamps(false);
+    log_setDuplicateSuppression(false);
+    log_logMessage(LOGLEVEL_INFO, "same");
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(8 == unittest_logging_countLines(pContent));
+    expectNotNull(strstr(pContent, "WARNING: last message repeated 1 times\nINFO: same\n"));
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_duplicates()
+
+
+
+static bool unittest_logging_fields(void) {
+    char longString[2000];
+    log_field_t fields[] = {
+        LOG_FIELD_STRING("peer", "a\"b"),
+        LOG_FIELD_INT("bytes", 42),
+        LOG_FIELD_BOOL("ok", true)
+    };
+    char *pContent;
+    size_t length;
+
+    // Without a JSON-lines log file, the fields are appended to the text.
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_logFields(LOGLEVEL_INFO, "received", fields, 3);
+    log_logFields(LOGLEVEL_DEBUG, "filtered", fields, 3);
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, "INFO: received peer=\"a\\\"b\" bytes=42 ok=true\n") == 0);
+    free(pContent);
+
+    // The JSON-lines log file receives the records in addition.
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE ".txt", false));
+    expectFalse(log_openJsonLogfile(UNITTEST_LOGFILE, false, LOGLEVEL_INFO));
+    log_logFields(LOGLEVEL_INFO, "received", fields, 3);
+    log_logFields(LOGLEVEL_DEBUG, "filtered", fields, 3);
+    // Records larger than the buffer are not truncated.
+    memset(longString, 'z', sizeof(longString) - 1);
+    longString[sizeof(longString) - 1] = '\0';
+    fields[0].value.s = longString;
+    log_logFields(LOGLEVEL_WARNING, "long", fields, 1);
+    expectFalse(log_closeJsonLogfile());
+    expectFalse(log_closeLogfile());
+
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(2 == unittest_logging_countLines(pContent));
+    expectTrue(strncmp(pContent, "{\"ts\":", 6) == 0);
+    expectNotNull(strstr(pContent, ",\"level\":\"INFO\",\"msg\":\"received\",\"peer\":\"a\\\"b\",\"bytes\":42,\"ok\":true}\n{"));
+    expectNotNull(strstr(pContent, ",\"level\":\"WARNING\",\"msg\":\"long\",\"peer\":\"zzz"));
+    expectTrue(length > sizeof(longString));
+    expectTrue(strcmp(pContent + length - 3, "\"}\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    pContent = unittest_logging_readFile(UNITTEST_LOGFILE ".txt", &length);
+    expectNotNull(pContent);
+    expectTrue(2 == unittest_logging_countLines(pContent));
+    expectNotNull(strstr(pContent, "INFO: received peer=\"a\\\"b\" bytes=42 ok=true\nWARNING: long peer=\"zzz"));
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE ".txt");
+
+    return true;
+} // unittest_logging_fields()
+
+
+
+static bool unittest_logging_flightRecorder(void) {
+    char *pContent;
+    size_t length;
+    int i;
+#ifndef _WIN32
+    pid_t child;
+    int status;
+#endif // !_WIN32
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    expectFalse(log_startFlightRecorder(UNITTEST_DUMPFILE, 1000, LOGLEVEL_DEBUG3));
+    expectTrue(log_startFlightRecorder(UNITTEST_DUMPFILE, 1000, LOGLEVEL_DEBUG3));
+
+    // Debug records are kept in memory only, a fatal record dumps them.
+    log_logMessage(LOGLEVEL_DEBUG1, "detail %d", 1);
+    log_logMessage(LOGLEVEL_INFO, "info %d", 2);
+    // This also shows on stderr.
+    log_logMessage(LOGLEVEL_FATAL, "flight recorder test %d, not an error", 3);
+    pContent = unittest_logging_readFile(UNITTEST_DUMPFILE, &length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, "DEBUG1: detail 1\nINFO: info 2\nFATAL ERROR: flight recorder test 3, not an error\n") == 0);
+    free(pContent);
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, "INFO: info 2\nFATAL ERROR: flight recorder test 3, not an error\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    // Once the ring has wrapped around, the dump starts with a complete
+    // record and ends with the most recent one.
+    for (i = 0; i < 200; i++) {
+        log_logMessage(LOGLEVEL_DEBUG1, "wrapped %d", i);
+    }
+    expectFalse(log_dumpFlightRecorder());
+    pContent = unittest_logging_readFile(UNITTEST_DUMPFILE, &length);
+    expectNotNull(pContent);
+    expectTrue(length <= 1024);
+    expectTrue(strncmp(pContent, "DEBUG1: wrapped ", 16) == 0);
+    expectTrue(strcmp(pContent + length - 20, "DEBUG1: wrapped 199\n") == 0);
+    free(pContent);
+    log_stopFlightRecorder();
+    expectTrue(log_dumpFlightRecorder());
+    (void) remove(UNITTEST_DUMPFILE);
+
+#ifndef _WIN32
+    // A fatal signal dumps the ring of the dying process.
+    child = fork();
+    expectTrue(child >= 0);
+    if (0 == child) {
+        (void) log_startFlightRecorder(UNITTEST_DUMPFILE, 1000, LOGLEVEL_DEBUG3);
+        log_logMessage(LOGLEVEL_DEBUG1, "last words");
+        abort();
+    }
+    expectTrue(waitpid(child, &status, 0) == child);
+    expectTrue(WIFSIGNALED(status) && (SIGABRT == WTERMSIG(status)));
+    pContent = unittest_logging_readFile(UNITTEST_DUMPFILE, &length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, "DEBUG1: last words\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_DUMPFILE);
+#endif // !_WIN32
+
+    return true;
+} // unittest_logging_flightRecorder()
+
+
+
+static bool unittest_logging_data(void) {
+    static char const expected[] =
+        "INFO: prefix12  00 01 02 03 04 05 06 07\n"
+        "INFO:           08 09 0A 0B 0C 0D 0E 0F\n"
+        "INFO:           10 11 12 13\n"
+        "INFO: limited!  00 01 02 03 04 05 06 07\n"
+        "INFO:           08 09\n"
+        "INFO:           ... 10 more bytes\n"
+        "INFO: empty    (None)\n";
+    char data[3000];
+    char *pContent;
+    size_t length, i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (char) i;
+    }
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_logData(LOGLEVEL_INFO, data, 20, "prefix12", 8);
+    log_logDataLimited(LOGLEVEL_INFO, data, 20, "limited!", 8, 10);
+    log_logData(LOGLEVEL_INFO, data, 0, "empty   ", 8);
+    log_logData(LOGLEVEL_DEBUG, data, 20, "filtered", 8);
+    log_flush();
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent, expected) == 0);
+    free(pContent);
+
+    // A dump larger than the format buffer is not truncated.
+    log_logData(LOGLEVEL_INFO, data, sizeof(data), "large   ", 16);
+    expectFalse(log_closeLogfile());
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(7 + (sizeof(data) + 15) / 16 == unittest_logging_countLines(pContent));
+    expectTrue(strcmp(pContent + length - 40, "INFO:           B0 B1 B2 B3 B4 B5 B6 B7\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_data()
+
+
+
+#if LOGGING_THREADS
+/** Logs UNITTEST_NR_MESSAGES messages.
+
+   @param pArgument Points to the number of the thread.
+   @return Always NULL.
+ */
+static void *unittest_logging_thread(void *pArgument) {
+    int threadNr = *(int *) pArgument;
+    int i;
+
+    for (i = 0; i < UNITTEST_NR_MESSAGES; i++) {
+        log_logMessage(LOGLEVEL_INFO, "thread %d message %d", threadNr, i);
+    }
+    return NULL;
+} // unittest_logging_thread()
+
+
+
+/** Logs UNITTEST_NR_MESSAGES messages in several parts.
+
+   @param pArgument Points to the number of the thread.
+   @return Always NULL.
+ */
+static void *unittest_logging_multipartThread(void *pArgument) {
+    int threadNr = *(int *) pArgument;
+    int i;
+
+    for (i = 0; i < UNITTEST_NR_MESSAGES; i++) {
+        log_logMessageStart(LOGLEVEL_INFO, "thread %d", threadNr);
+        log_logMessageContinue(LOGLEVEL_INFO, " part %d", i);
+        log_logMessageContinue(LOGLEVEL_INFO, " end\n");
+    }
+    return NULL;
+} // unittest_logging_multipartThread()
+
+
+
+static bool unittest_logging_multipart(void) {
+    pthread_t threads[UNITTEST_NR_THREADS];
+    int threadNrs[UNITTEST_NR_THREADS];
+    char *pContent, *pLine;
+    size_t length;
+    unsigned long nrLines = 0;
+    int i;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    log_logMessage(LOGLEVEL_INFO, "first");
+    // An empty part without a pending line adds nothing.
+    log_logMessageContinue(LOGLEVEL_ERROR, "%s", "");
+    expectFalse(log_closeLogfile());
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, true));
+
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        threadNrs[i] = i;
+        expectTrue(pthread_create(&threads[i], NULL, unittest_logging_multipartThread, &threadNrs[i]) == 0);
+    }
+    // Exchange the log file while the threads are logging.
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, true));
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        (void) pthread_join(threads[i], NULL);
+    }
+    expectFalse(log_closeLogfile());
+
+    // Appending keeps the first message and no line is torn.
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strncmp(pContent, "INFO: first\n", 12) == 0);
+    for (pLine = strtok(pContent, "\n"); NULL != pLine; pLine = strtok(NULL, "\n")) {
+        int threadNr, partNr, consumed = 0;
+
+        nrLines++;
+        if (1 == nrLines) {
+            continue;
+        }
+        expectTrue(sscanf(pLine, "INFO: thread %d part %d end%n", &threadNr, &partNr, &consumed) == 2);
+        expectTrue((size_t) consumed == strlen(pLine));
+    }
+    expectTrue(nrLines == 1 + UNITTEST_NR_THREADS * UNITTEST_NR_MESSAGES);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_multipart()
+
+
+
+static bool unittest_logging_mappedThreads(void) {
+    pthread_t threads[UNITTEST_NR_THREADS];
+    int threadNrs[UNITTEST_NR_THREADS];
+    char *pContent;
+    size_t length;
+    int i;
+
+    expectFalse(log_openMappedLogfile(UNITTEST_LOGFILE, false, 0));
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        threadNrs[i] = i;
+        expectTrue(pthread_create(&threads[i], NULL, unittest_logging_thread, &threadNrs[i]) == 0);
+    }
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        (void) pthread_join(threads[i], NULL);
+    }
+    expectFalse(log_closeLogfile());
+
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(strlen(pContent) == length);
+    expectTrue(unittest_logging_countLines(pContent) == UNITTEST_NR_THREADS * UNITTEST_NR_MESSAGES);
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_mappedThreads()
+
+
+
+/** Waits until the log file has been rotated, i.e. is empty.
+
+   @return Was the file rotated within a few seconds?
+ */
+static bool unittest_logging_waitForRotation(void) {
+    struct timespec pause = { 0, 10000000L };
+    int i;
+
+    for (i = 0; i < 500; i++) {
+        char *pContent;
+        size_t length = 1;
+
+        if (NULL != (pContent = unittest_logging_readLogfile(&length))) {
+            free(pContent);
+        }
+        if (0 == length) {
+            return true;
+        }
+        (void) nanosleep(&pause, NULL);
+    }
+    return false;
+} // unittest_logging_waitForRotation()
+
+
+
+static bool unittest_logging_rotation(void) {
+    FILE *fh;
+    int i;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    expectFalse(log_setRotation(100, 0, 2));
+
+    // Each round exceeds the size, the third rotation drops the oldest file.
+    for (i = 0; i < 3; i++) {
+        log_logMessage(LOGLEVEL_INFO, "round %d: 0123456789012345678901234567890123456789", i);
+        log_logMessage(LOGLEVEL_INFO, "round %d: 0123456789012345678901234567890123456789", i);
+        expectTrue(unittest_logging_waitForRotation());
+        // The new file is created before it replaces the old one. Restarting
+        // the rotation waits until the thread has finished the rotation, so
+        // the next round is written to the new file.
+        expectFalse(log_setRotation(100, 0, 2));
+    }
+    expectNotNull(fh = fopen(UNITTEST_LOGFILE ".1", "r"));
+    expectTrue(fgetc(fh) == 'I');
+    (void) fclose(fh);
+    expectNotNull(fh = fopen(UNITTEST_LOGFILE ".2", "r"));
+    (void) fclose(fh);
+    expectNull(fopen(UNITTEST_LOGFILE ".3", "r"));
+
+    // Rotation by time.
+    expectFalse(log_setRotation(0, 1, 0));
+    log_logMessage(LOGLEVEL_INFO, "timed");
+    expectTrue(unittest_logging_waitForRotation());
+
+    expectFalse(log_setRotation(0, 0, 0));
+    expectFalse(log_closeLogfile());
+    (void) remove(UNITTEST_LOGFILE);
+    (void) remove(UNITTEST_LOGFILE ".1");
+    (void) remove(UNITTEST_LOGFILE ".2");
+
+    return true;
+} // unittest_logging_rotation()
+
+
+
+static bool unittest_logging_async(void) {
+    pthread_t threads[UNITTEST_NR_THREADS];
+    int threadNrs[UNITTEST_NR_THREADS];
+    char longMessage[1001];
+    char *pHugeMessage;
+    char *pContent, *pLine;
+    size_t length;
+    int i;
+
+    expectFalse(log_openLogfile(UNITTEST_LOGFILE, false));
+    expectFalse(log_startAsync(0, LOG_QUEUE_BLOCK));
+    expectTrue(log_startAsync(0, LOG_QUEUE_BLOCK));
+
+    // Messages longer than a queue slot are split and reassembled.
+    memset(longMessage, 'x', sizeof(longMessage) - 1);
+    longMessage[sizeof(longMessage) - 1] = '\0';
+    log_logMessage(LOGLEVEL_INFO, "%s", longMessage);
+    log_flush();
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectNotNull(strstr(pContent, longMessage));
+    free(pContent);
+
+    // Records longer than the render buffer are kept whole, records longer
+    // than the queue are cut but keep their EOL marker.
+    pHugeMessage = malloc(20001);
+    expectNotNull(pHugeMessage);
+    memset(pHugeMessage, 'y', 20000);
+    pHugeMessage[6000] = '\0';
+    log_logMessage(LOGLEVEL_INFO, "%s", pHugeMessage);
+    log_logMessage(LOGLEVEL_INFO, "after big");
+    pHugeMessage[6000] = 'y';
+    pHugeMessage[20000] = '\0';
+    log_logMessage(LOGLEVEL_INFO, "%s", pHugeMessage);
+    log_logMessage(LOGLEVEL_INFO, "after huge");
+    log_flush();
+    pHugeMessage[6000] = '\0';
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectNotNull(pLine = strstr(pContent, pHugeMessage));
+    expectTrue(strncmp(pLine + 6000, "\nINFO: after big\n", 17) == 0);
+    expectNotNull(pLine = strstr(pContent, "y [truncated]\nINFO: after huge\n"));
+    free(pContent);
+
+    // A long hex dump stays a single record, including the note.
+    for (i = 0; i < 2000; i++) {
+        pHugeMessage[i] = (char) i;
+    }
+    log_logDataLimited(LOGLEVEL_INFO, pHugeMessage, 2000, "dump", 16, 1500);
+    log_logMessage(LOGLEVEL_INFO, "after dump");
+    log_flush();
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectNotNull(strstr(pContent, "INFO: dump  00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F\n"));
+    expectNotNull(strstr(pContent, "INFO:       D0 D1 D2 D3 D4 D5 D6 D7 D8 D9 DA DB\n"
+                                   "INFO:       ... 500 more bytes\n"
+                                   "INFO: after dump\n"));
+    free(pContent);
+    free(pHugeMessage);
+
+    // Many threads logging at once lose no message.
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        threadNrs[i] = i;
+        expectTrue(pthread_create(&threads[i], NULL, unittest_logging_thread, &threadNrs[i]) == 0);
+    }
+    for (i = 0; i < UNITTEST_NR_THREADS; i++) {
+        (void) pthread_join(threads[i], NULL);
+    }
+    log_stopAsync();
+    expectFalse(log_closeLogfile());
+
+    pContent = unittest_logging_readLogfile(&length);
+    expectNotNull(pContent);
+    expectTrue(unittest_logging_countLines(pContent) == 101 + UNITTEST_NR_THREADS * UNITTEST_NR_MESSAGES);
+    expectTrue(0 == log_getDroppedCount());
+    free(pContent);
+    (void) remove(UNITTEST_LOGFILE);
+
+    return true;
+} // unittest_logging_async()
+#endif // LOGGING_THREADS
+
+
+
+bool unittest_logging(void) {
+    bool testsAllPassed = true;
+
+    log_logMessage(LOGLEVEL_INFO, "Testing logging");
+
+    // Keep the test messages off the console.
+    log_setStdoutLevel(LOGLEVEL_FATAL);
+    log_setStderrLevel(LOGLEVEL_FATAL);
+    log_setFileLevel(LOGLEVEL_INFO);
+
+    testsAllPassed &= unittest_logging_format();
+    testsAllPassed &= unittest_logging_timestamps();
+    testsAllPassed &= unittest_logging_mapped();
+    testsAllPassed &= unittest_logging_flush();
+    testsAllPassed &= unittest_logging_binary();
+    testsAllPassed &= unittest_logging_categories();
+    testsAllPassed &= unittest_logging_rateLimit();
+    testsAllPassed &= unittest_logging_sampled();
+    testsAllPassed &= unittest_logging_duplicates();
+    testsAllPassed &= unittest_logging_fields();
+    testsAllPassed &= unittest_logging_flightRecorder();
+    testsAllPassed &= unittest_logging_data();
+#if LOGGING_THREADS
+    testsAllPassed &= unittest_logging_multipart();
+    testsAllPassed &= unittest_logging_mappedThreads();
+    testsAllPassed &= unittest_logging_rotation();
+    testsAllPassed &= unittest_logging_async();
+#endif // LOGGING_THREADS
+
+    log_setStdoutLevel(LOGLEVEL_INFO);
+    log_setStderrLevel(LOGLEVEL_ERROR);
+
+    return testsAllPassed;
+} // unittest_logging()
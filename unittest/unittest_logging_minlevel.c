@@ -0,0 +1,129 @@
+/** Unit tests for removing log messages at compile-time.
+
+   @file unittest_logging_minlevel.c
+   @ingroup misclib
+
+   @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+   @note The master repository for this file is at
+    <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    Copyright 2016, 2017 Christian Doenges (Christian D&ouml;nges)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+// Remove the two lowest levels at compile-time.
+#define LOGGING_MIN_LEVEL LOGLEVEL_DEBUG1
+#include "logging.h"
+#include "misclibTest.h"
+
+
+/** The log file used by the tests. */
+#define UNITTEST_MINLEVEL_LOGFILE "unittest_logging_minlevel.log"
+
+
+
+/** The category used by the tests. */
+static LOG_DEFINE_CATEGORY(unittestMinLevelCategory, "unittest.minlevel");
+
+/** The number of calls of unittest_minLevel_argument(). */
+static int unittestMinLevelCalls = 0;
+
+
+
+/** Reads the entire log file into a buffer.
+
+   @return The NUL-terminated content, to be free()d by the caller, or NULL.
+ */
+static char *unittest_minLevel_readLogfile(void) {
+    FILE *fh;
+    char *pContent;
+    size_t length;
+    long size;
+
+    if (NULL == (fh = fopen(UNITTEST_MINLEVEL_LOGFILE, "rb"))) {
+        return NULL;
+    }
+    (void) fseek(fh, 0, SEEK_END);
+    size = ftell(fh);
+    (void) fseek(fh, 0, SEEK_SET);
+    if (NULL != (pContent = malloc((size_t) size + 1))) {
+        length = fread(pContent, 1, (size_t) size, fh);
+        pContent[length] = '\0';
+    }
+    fclose(fh);
+    return pContent;
+} // unittest_minLevel_readLogfile()
+
+
+
+/** Counts its calls, to detect the evaluation of arguments.
+
+   @return The number of calls so far.
+ */
+static int unittest_minLevel_argument(void) {
+    return ++unittestMinLevelCalls;
+} // unittest_minLevel_argument()
+
+
+
+bool unittest_logging_minimumLevel(void) {
+    char data[4] = { 1, 2, 3, 4 };
+    log_field_t const fields[] = { LOG_FIELD_INT("n", 5) };
+    char *pContent;
+
+    log_logMessage(LOGLEVEL_INFO, "Testing LOGGING_MIN_LEVEL");
+
+    expectFalse(log_openLogfile(UNITTEST_MINLEVEL_LOGFILE, false));
+    log_setFileLevel(LOGLEVEL_DEBUG3);
+    log_setCategoryLevel("unittest.minlevel", LOGLEVEL_DEBUG3);
+
+    // Messages below LOGGING_MIN_LEVEL are removed with their arguments.
+    log_logMessage(LOGLEVEL_DEBUG3, "removed %d", unittest_minLevel_argument());
+    log_logMessageStart(LOGLEVEL_DEBUG2, "removed %d", unittest_minLevel_argument());
+    log_logMessageContinue(LOGLEVEL_DEBUG2, "removed %d\n", unittest_minLevel_argument());
+    log_logBinary(LOGLEVEL_DEBUG2, "removed %d", unittest_minLevel_argument());
+    log_logCategory(unittestMinLevelCategory, LOGLEVEL_DEBUG2, "removed %d", unittest_minLevel_argument());
+    log_logData(LOGLEVEL_DEBUG2, data, sizeof(data), "removed ", 16);
+    log_logFields(LOGLEVEL_DEBUG2, "removed", fields, 1);
+    expectTrue(0 == unittestMinLevelCalls);
+    expectFalse(log_isCategoryEnabled(unittestMinLevelCategory, LOGLEVEL_DEBUG2));
+
+    // Messages at or above the level are kept.
+    log_logMessage(LOGLEVEL_DEBUG1, "kept %d", unittest_minLevel_argument());
+    log_logMessageStart(LOGLEVEL_DEBUG1, "start %d", unittest_minLevel_argument());
+    log_logMessageContinue(LOGLEVEL_DEBUG1, ", continued %d\n", unittest_minLevel_argument());
+    log_logCategory(unittestMinLevelCategory, LOGLEVEL_DEBUG1, "category %d", unittest_minLevel_argument());
+    expectTrue(4 == unittestMinLevelCalls);
+    log_logFields(LOGLEVEL_DEBUG1, "fields", fields, 1);
+
+    expectFalse(log_closeLogfile());
+    log_setFileLevel(LOGLEVEL_INFO);
+    pContent = unittest_minLevel_readLogfile();
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent,
+                      "DEBUG1: kept 1\n"
+                      "DEBUG1: start 2, continued 3\n"
+                      "DEBUG1: category 4\n"
+                      "DEBUG1: fields n=5\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_MINLEVEL_LOGFILE);
+
+    return true;
+} // unittest_logging_minimumLevel()
@@ -0,0 +1,132 @@
+/** Unit tests for the logging API without variadic macros.
+
+   @file unittest_logging_nonvariadic.c
+   @ingroup misclib
+
+   @author Christian D&ouml;nges <cd@platypus-projects.de>
+
+   @note The master repository for this file is at
+    <a href="https://github.com/cdoenges/misclib">https://github.com/cdoenges/misclib</a>
+
+    LICENSE
+
+    Copyright 2016, 2017 Christian Doenges (Christian D&ouml;nges)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+// Use the API of compilers without variadic macros and remove the two
+// lowest levels at compile-time.
+#undef LOGGING_API_USES_VARIADIC_MACROS
+#define LOGGING_API_USES_VARIADIC_MACROS 0
+#define LOGGING_MIN_LEVEL LOGLEVEL_DEBUG1
+#include "logging.h"
+#include "misclibTest.h"
+
+
+/** The log file used by the tests. */
+#define UNITTEST_NONVARIADIC_LOGFILE "unittest_logging_nonvariadic.log"
+
+
+
+/** The category used by the tests. */
+static LOG_DEFINE_CATEGORY(unittestNonVariadicCategory, "unittest.nonvariadic");
+
+/** The number of calls of unittest_nonVariadic_argument(). */
+static int unittestNonVariadicCalls = 0;
+
+
+
+/** Reads the entire log file into a buffer.
+
+   @return The NUL-terminated content, to be free()d by the caller, or NULL.
+ */
+static char *unittest_nonVariadic_readLogfile(void) {
+    FILE *fh;
+    char *pContent;
+    size_t length;
+    long size;
+
+    if (NULL == (fh = fopen(UNITTEST_NONVARIADIC_LOGFILE, "rb"))) {
+        return NULL;
+    }
+    (void) fseek(fh, 0, SEEK_END);
+    size = ftell(fh);
+    (void) fseek(fh, 0, SEEK_SET);
+    if (NULL != (pContent = malloc((size_t) size + 1))) {
+        length = fread(pContent, 1, (size_t) size, fh);
+        pContent[length] = '\0';
+    }
+    fclose(fh);
+    return pContent;
+} // unittest_nonVariadic_readLogfile()
+
+
+
+/** Counts its calls, to detect the evaluation of arguments.
+
+   @return The number of calls so far.
+ */
+static int unittest_nonVariadic_argument(void) {
+    return ++unittestNonVariadicCalls;
+} // unittest_nonVariadic_argument()
+
+
+
+bool unittest_logging_nonVariadic(void) {
+    char data[4] = { 1, 2, 3, 4 };
+    char *pContent;
+
+    log_logMessage((LOGLEVEL_INFO, "Testing logging without variadic macros"));
+
+    expectFalse(log_openLogfile(UNITTEST_NONVARIADIC_LOGFILE, false));
+    log_setFileLevel(LOGLEVEL_DEBUG3);
+    log_setCategoryLevel("unittest.nonvariadic", LOGLEVEL_DEBUG3);
+
+    // Messages below LOGGING_MIN_LEVEL are discarded. Without variadic
+    // macros only the category evaluates its arguments after the check.
+    log_logMessage((LOGLEVEL_DEBUG3, "removed %d", 0));
+    log_logMessageStart((LOGLEVEL_DEBUG2, "removed %d", 0));
+    log_logMessageContinue((LOGLEVEL_DEBUG2, "removed %d\n", 0));
+    log_logBinary((LOGLEVEL_DEBUG2, "removed %d", 0));
+    log_logCategory(unittestNonVariadicCategory, LOGLEVEL_DEBUG2,
+                    (LOGLEVEL_DEBUG2, "removed %d", unittest_nonVariadic_argument()));
+    log_logData(LOGLEVEL_DEBUG2, data, sizeof(data), "removed ", 16);
+    expectTrue(0 == unittestNonVariadicCalls);
+    expectFalse(log_isCategoryEnabled(unittestNonVariadicCategory, LOGLEVEL_DEBUG2));
+
+    // Messages at or above the level are kept.
+    log_logMessage((LOGLEVEL_DEBUG1, "kept %d", unittest_nonVariadic_argument()));
+    log_logMessageStart((LOGLEVEL_DEBUG1, "start %d", unittest_nonVariadic_argument()));
+    log_logMessageContinue((LOGLEVEL_DEBUG1, ", continued %d\n", unittest_nonVariadic_argument()));
+    log_logBinary((LOGLEVEL_DEBUG1, "binary %d", unittest_nonVariadic_argument()));
+    log_logCategory(unittestNonVariadicCategory, LOGLEVEL_DEBUG1,
+                    (LOGLEVEL_DEBUG1, "category %d", unittest_nonVariadic_argument()));
+
+    expectFalse(log_closeLogfile());
+    log_setFileLevel(LOGLEVEL_INFO);
+    pContent = unittest_nonVariadic_readLogfile();
+    expectNotNull(pContent);
+    expectTrue(strcmp(pContent,
+                      "DEBUG1: kept 1\n"
+                      "DEBUG1: start 2, continued 3\n"
+                      "DEBUG1: binary 4\n"
+                      "DEBUG1: category 5\n") == 0);
+    free(pContent);
+    (void) remove(UNITTEST_NONVARIADIC_LOGFILE);
+
+    return true;
+} // unittest_logging_nonVariadic()